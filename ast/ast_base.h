@@ -19,6 +19,7 @@
 #include <string>
 #include <utility>
 #include <iosfwd>
+#include <cassert>
 #include "../util/arena.h"
 #include "../input/location.h"
 #include "../util/string_view.h"
@@ -87,15 +88,47 @@ public:
 template <typename T>
 struct ASTBase
 {
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+private:
+    /** the input is the context of the arena slab this node is in */
+    input::CompactLocationSpan location;
+
+public:
+    ASTBase(const ASTBase &rt) noexcept : location(rt.location)
+    {
+        assert(util::Arena::getContext(this) == util::Arena::getContext(&rt));
+    }
+    explicit ASTBase(const input::LocationSpan &location) noexcept : location(location)
+    {
+        assert(util::Arena::getContext(this) == location.input);
+    }
+    input::LocationSpan getLocation() const noexcept
+    {
+        return location.getLocationSpan(static_cast<input::TextInput *>(
+            const_cast<void *>(util::Arena::getContext(this))));
+    }
+    input::SimpleLocationSpan getSimpleLocationSpan() const noexcept
+    {
+        return location.getSimpleLocationSpan();
+    }
+#else
     input::LocationSpan location;
     ASTBase(const ASTBase &) = default;
-    ASTBase(ASTBase &&) = delete;
-    ASTBase &operator=(const ASTBase &) = delete;
-    ASTBase &operator=(ASTBase &&) = delete;
     explicit ASTBase(const input::LocationSpan &location) noexcept : location(location)
     {
     }
-    virtual ~ASTBase() = default;
+    const input::LocationSpan &getLocation() const noexcept
+    {
+        return location;
+    }
+    const input::SimpleLocationSpan &getSimpleLocationSpan() const noexcept
+    {
+        return location;
+    }
+#endif
+    ASTBase(ASTBase &&) = delete;
+    ASTBase &operator=(const ASTBase &) = delete;
+    ASTBase &operator=(ASTBase &&) = delete;
     virtual util::ArenaPtr<T> duplicate(util::Arena &arena) const = 0;
     virtual util::ArenaPtr<T> duplicateRecursive(util::Arena &arena) const
     {
@@ -104,24 +137,29 @@ struct ASTBase
     /** line continuations are removed */
     std::string getSourceText(std::string bufferSource) const
     {
-        return location.getTextInputText(std::move(bufferSource));
+        return getLocation().getTextInputText(std::move(bufferSource));
     }
     /** line continuations are removed */
     std::string getSourceText() const
     {
-        return location.getTextInputText();
+        return getLocation().getTextInputText();
     }
     /** line continuations are not removed */
     std::string getRawSourceText(std::string bufferSource) const
     {
-        return location.getRawTextInputText(std::move(bufferSource));
+        return getLocation().getRawTextInputText(std::move(bufferSource));
     }
     /** line continuations are not removed */
     std::string getRawSourceText() const
     {
-        return location.getRawTextInputText();
+        return getLocation().getRawTextInputText();
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const = 0;
+
+protected:
+    /** not virtual: nodes are only destroyed by `util::Arena`, which knows their real type, and
+     * this lets nodes without other resources be trivially destructible */
+    ~ASTBase() = default;
 };
 }
 }
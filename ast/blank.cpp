@@ -22,14 +22,14 @@ namespace ast
 {
 void BlankOrEmpty::dump(std::ostream &os, ASTDumpState &dumpState) const
 {
-    os << dumpState.indent << location
+    os << dumpState.indent << getLocation()
        << ": BlankOrEmpty: " << ASTDumpState::escapedQuotedString(getRawSourceText())
        << std::endl;
 }
 
 void Blank::dump(std::ostream &os, ASTDumpState &dumpState) const
 {
-    os << dumpState.indent << location
+    os << dumpState.indent << getLocation()
        << ": Blank: " << ASTDumpState::escapedQuotedString(getRawSourceText())
        << std::endl;
 }
@@ -28,7 +28,7 @@ struct BlankOrEmpty : public ASTBase<BlankOrEmpty>
     using ASTBase<BlankOrEmpty>::ASTBase;
     bool isEmpty() noexcept
     {
-        return location.size() == 0;
+        return getLocation().size() == 0;
     }
     virtual util::ArenaPtr<BlankOrEmpty> duplicate(util::Arena &arena) const override
     {
@@ -0,0 +1,249 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "command.h"
+#include <ostream>
+
+namespace quick_shell
+{
+namespace ast
+{
+void SimpleCommand::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": SimpleCommand" << std::endl;
+    initialBlanks->dump(os, dumpState);
+    for(auto &part : parts)
+    {
+        part.wordOrRedirection->dump(os, dumpState);
+        part.followingBlanks->dump(os, dumpState);
+    }
+    if(finalComment)
+        finalComment->dump(os, dumpState);
+}
+
+void CommandList::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": CommandList" << std::endl;
+    for(auto &part : parts)
+    {
+        part.command->dump(os, dumpState);
+        switch(part.terminator)
+        {
+        case Terminator::None:
+            break;
+        case Terminator::Semicolon:
+            os << dumpState.indent << ";" << std::endl;
+            break;
+        case Terminator::Ampersand:
+            os << dumpState.indent << "&" << std::endl;
+            break;
+        case Terminator::NewLine:
+            os << dumpState.indent << "NewLine" << std::endl;
+            break;
+        }
+    }
+}
+
+void AndOrList::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": AndOrList" << std::endl;
+    for(auto &part : parts)
+    {
+        switch(part.op)
+        {
+        case Operator::None:
+            break;
+        case Operator::And:
+            os << dumpState.indent << "&&" << std::endl;
+            break;
+        case Operator::Or:
+            os << dumpState.indent << "||" << std::endl;
+            break;
+        }
+        part.command->dump(os, dumpState);
+    }
+}
+
+void Pipeline::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": Pipeline";
+    if(isTimed)
+        os << (isTimePosix ? " time -p" : " time");
+    if(isNegated)
+        os << " !";
+    os << std::endl;
+    for(std::size_t i = 0; i < parts.size(); i++)
+    {
+        if(i > 0)
+            os << dumpState.indent << (parts[i - 1].pipesStandardError ? "|&" : "|") << std::endl;
+        parts[i].command->dump(os, dumpState);
+    }
+}
+
+void CompoundCommand::dumpRedirections(std::ostream &os, ASTDumpState &dumpState) const
+{
+    for(auto &redirection : redirections)
+        redirection->dump(os, dumpState);
+}
+
+void BraceGroup::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": BraceGroup" << std::endl;
+    body->dump(os, dumpState);
+    dumpRedirections(os, dumpState);
+}
+
+void Subshell::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": Subshell" << std::endl;
+    body->dump(os, dumpState);
+    dumpRedirections(os, dumpState);
+}
+
+void IfCommand::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": IfCommand" << std::endl;
+    for(std::size_t i = 0; i < clauses.size(); i++)
+    {
+        os << dumpState.indent << (i == 0 ? "if" : "elif") << std::endl;
+        clauses[i].condition->dump(os, dumpState);
+        os << dumpState.indent << "then" << std::endl;
+        clauses[i].body->dump(os, dumpState);
+    }
+    if(elseBody)
+    {
+        os << dumpState.indent << "else" << std::endl;
+        elseBody->dump(os, dumpState);
+    }
+    dumpRedirections(os, dumpState);
+}
+
+void WhileCommand::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": WhileCommand" << (isUntil ? "<Until>" : "") << std::endl;
+    condition->dump(os, dumpState);
+    os << dumpState.indent << "do" << std::endl;
+    body->dump(os, dumpState);
+    dumpRedirections(os, dumpState);
+}
+
+void ForCommand::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": ForCommand" << (isSelect ? "<Select>" : "") << std::endl;
+    name->dump(os, dumpState);
+    if(hasWordList)
+    {
+        os << dumpState.indent << "in" << std::endl;
+        for(auto &word : words)
+            word->dump(os, dumpState);
+    }
+    os << dumpState.indent << "do" << std::endl;
+    body->dump(os, dumpState);
+    dumpRedirections(os, dumpState);
+}
+
+void CaseItem::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": CaseItem";
+    switch(terminator)
+    {
+    case Terminator::None:
+        break;
+    case Terminator::Break:
+        os << ": ;;";
+        break;
+    case Terminator::FallThrough:
+        os << ": ;&";
+        break;
+    case Terminator::Continue:
+        os << ": ;;&";
+        break;
+    }
+    os << std::endl;
+    for(auto &pattern : patterns)
+        pattern->dump(os, dumpState);
+    if(body)
+        body->dump(os, dumpState);
+}
+
+void CaseCommand::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": CaseCommand" << std::endl;
+    word->dump(os, dumpState);
+    for(auto &item : items)
+        item->dump(os, dumpState);
+    dumpRedirections(os, dumpState);
+}
+
+void ConditionalCommand::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": ConditionalCommand" << std::endl;
+    expression->dump(os, dumpState);
+    dumpRedirections(os, dumpState);
+}
+
+void LazyFunctionBody::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": LazyFunctionBody" << std::endl;
+    dumpRedirections(os, dumpState);
+}
+
+void FunctionDefinition::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": FunctionDefinition" << std::endl;
+    name->dump(os, dumpState);
+    body->dump(os, dumpState);
+}
+
+void CoprocCommand::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": CoprocCommand" << std::endl;
+    if(name)
+        name->dump(os, dumpState);
+    command->dump(os, dumpState);
+}
+}
+}
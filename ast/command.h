@@ -16,12 +16,15 @@
 #ifndef AST_COMMAND_H_
 #define AST_COMMAND_H_
 
-#include <vector>
 #include <utility>
 #include "ast_base.h"
 #include "word_or_redirection.h"
 #include "blank.h"
 #include "comment.h"
+#include "word.h"
+#include "redirection.h"
+#include "conditional_expression.h"
+#include "../util/arena_vector.h"
 
 namespace quick_shell
 {
@@ -48,12 +51,13 @@ struct SimpleCommand final : public Command
         {
         }
     };
+    typedef util::ArenaVector<Part, 3> Parts;
     util::ArenaPtr<BlankOrEmpty> initialBlanks;
-    std::vector<Part> parts;
+    Parts parts;
     util::ArenaPtr<Comment> finalComment;
     SimpleCommand(const input::LocationSpan &location,
                   util::ArenaPtr<BlankOrEmpty> initialBlanks,
-                  std::vector<Part> parts,
+                  Parts parts,
                   util::ArenaPtr<Comment> finalComment) noexcept
         : Command(location),
           initialBlanks(std::move(initialBlanks)),
@@ -63,7 +67,407 @@ struct SimpleCommand final : public Command
     }
     virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
     {
-        return arena.allocate<Command>(*this);
+        return arena.allocate<SimpleCommand>(
+            getLocation(), initialBlanks, Parts(parts, arena), finalComment);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** commands separated by `;`, `&` or newlines */
+struct CommandList final : public Command
+{
+    enum class Terminator
+    {
+        None,
+        Semicolon,
+        Ampersand,
+        NewLine,
+    };
+    struct Part final
+    {
+        util::ArenaPtr<Command> command;
+        Terminator terminator;
+        constexpr Part(util::ArenaPtr<Command> command, Terminator terminator) noexcept
+            : command(std::move(command)),
+              terminator(terminator)
+        {
+        }
+        constexpr Part() noexcept : command(), terminator(Terminator::None)
+        {
+        }
+    };
+    typedef util::ArenaVector<Part, 2> Parts;
+    Parts parts;
+    CommandList(const input::LocationSpan &location, Parts parts) noexcept
+        : Command(location),
+          parts(std::move(parts))
+    {
+    }
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<CommandList>(getLocation(), Parts(parts, arena));
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** pipelines separated by `&&` or `||` */
+struct AndOrList final : public Command
+{
+    enum class Operator
+    {
+        /** for the first part */
+        None,
+        And,
+        Or,
+    };
+    struct Part final
+    {
+        /** the operator before `command` */
+        Operator op;
+        util::ArenaPtr<Command> command;
+        constexpr Part(Operator op, util::ArenaPtr<Command> command) noexcept
+            : op(op),
+              command(std::move(command))
+        {
+        }
+        constexpr Part() noexcept : op(Operator::None), command()
+        {
+        }
+    };
+    typedef util::ArenaVector<Part, 2> Parts;
+    Parts parts;
+    AndOrList(const input::LocationSpan &location, Parts parts) noexcept : Command(location),
+                                                                          parts(std::move(parts))
+    {
+    }
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<AndOrList>(getLocation(), Parts(parts, arena));
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+struct Pipeline final : public Command
+{
+    struct Part final
+    {
+        util::ArenaPtr<Command> command;
+        /** true if followed by `|&` instead of `|` */
+        bool pipesStandardError;
+        constexpr Part(util::ArenaPtr<Command> command, bool pipesStandardError) noexcept
+            : command(std::move(command)),
+              pipesStandardError(pipesStandardError)
+        {
+        }
+        constexpr Part() noexcept : command(), pipesStandardError(false)
+        {
+        }
+    };
+    typedef util::ArenaVector<Part, 2> Parts;
+    Parts parts;
+    /** starts with `!` */
+    bool isNegated;
+    /** starts with `time` */
+    bool isTimed;
+    /** starts with `time -p` */
+    bool isTimePosix;
+    Pipeline(const input::LocationSpan &location,
+             Parts parts,
+             bool isNegated,
+             bool isTimed,
+             bool isTimePosix) noexcept : Command(location),
+                                          parts(std::move(parts)),
+                                          isNegated(isNegated),
+                                          isTimed(isTimed),
+                                          isTimePosix(isTimePosix)
+    {
+    }
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<Pipeline>(
+            getLocation(), Parts(parts, arena), isNegated, isTimed, isTimePosix);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** a command that can be followed by redirections that apply to all of it */
+struct CompoundCommand : public Command
+{
+    typedef util::ArenaVector<util::ArenaPtr<Redirection>, 1> Redirections;
+    Redirections redirections;
+    CompoundCommand(const input::LocationSpan &location, Redirections redirections) noexcept
+        : Command(location),
+          redirections(std::move(redirections))
+    {
+    }
+
+protected:
+    void dumpRedirections(std::ostream &os, ASTDumpState &dumpState) const;
+};
+
+/** `{ list; }` */
+struct BraceGroup final : public CompoundCommand
+{
+    util::ArenaPtr<Command> body;
+    BraceGroup(const input::LocationSpan &location,
+               Redirections redirections,
+               util::ArenaPtr<Command> body) noexcept
+        : CompoundCommand(location, std::move(redirections)),
+          body(std::move(body))
+    {
+    }
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<BraceGroup>(getLocation(), Redirections(redirections, arena), body);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** `( list )` */
+struct Subshell final : public CompoundCommand
+{
+    util::ArenaPtr<Command> body;
+    Subshell(const input::LocationSpan &location,
+             Redirections redirections,
+             util::ArenaPtr<Command> body) noexcept
+        : CompoundCommand(location, std::move(redirections)),
+          body(std::move(body))
+    {
+    }
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<Subshell>(getLocation(), Redirections(redirections, arena), body);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+struct IfCommand final : public CompoundCommand
+{
+    /** the `if` clause, then the `elif` clauses */
+    struct Clause final
+    {
+        util::ArenaPtr<Command> condition;
+        util::ArenaPtr<Command> body;
+        constexpr Clause(util::ArenaPtr<Command> condition, util::ArenaPtr<Command> body) noexcept
+            : condition(std::move(condition)),
+              body(std::move(body))
+        {
+        }
+        constexpr Clause() noexcept : condition(), body()
+        {
+        }
+    };
+    typedef util::ArenaVector<Clause, 1> Clauses;
+    Clauses clauses;
+    /** null if there is no `else` */
+    util::ArenaPtr<Command> elseBody;
+    IfCommand(const input::LocationSpan &location,
+              Redirections redirections,
+              Clauses clauses,
+              util::ArenaPtr<Command> elseBody) noexcept
+        : CompoundCommand(location, std::move(redirections)),
+          clauses(std::move(clauses)),
+          elseBody(std::move(elseBody))
+    {
+    }
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<IfCommand>(
+            getLocation(), Redirections(redirections, arena), Clauses(clauses, arena), elseBody);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** `while` or `until` */
+struct WhileCommand final : public CompoundCommand
+{
+    bool isUntil;
+    util::ArenaPtr<Command> condition;
+    util::ArenaPtr<Command> body;
+    WhileCommand(const input::LocationSpan &location,
+                 Redirections redirections,
+                 bool isUntil,
+                 util::ArenaPtr<Command> condition,
+                 util::ArenaPtr<Command> body) noexcept
+        : CompoundCommand(location, std::move(redirections)),
+          isUntil(isUntil),
+          condition(std::move(condition)),
+          body(std::move(body))
+    {
+    }
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<WhileCommand>(
+            getLocation(), Redirections(redirections, arena), isUntil, condition, body);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** `for` or `select` */
+struct ForCommand final : public CompoundCommand
+{
+    typedef util::ArenaVector<util::ArenaPtr<Word>, 3> Words;
+    bool isSelect;
+    util::ArenaPtr<Word> name;
+    /** false if there's no `in`, so the loop is over the positional parameters */
+    bool hasWordList;
+    Words words;
+    util::ArenaPtr<Command> body;
+    ForCommand(const input::LocationSpan &location,
+               Redirections redirections,
+               bool isSelect,
+               util::ArenaPtr<Word> name,
+               bool hasWordList,
+               Words words,
+               util::ArenaPtr<Command> body) noexcept
+        : CompoundCommand(location, std::move(redirections)),
+          isSelect(isSelect),
+          name(std::move(name)),
+          hasWordList(hasWordList),
+          words(std::move(words)),
+          body(std::move(body))
+    {
+    }
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<ForCommand>(getLocation(),
+                                          Redirections(redirections, arena),
+                                          isSelect,
+                                          name,
+                                          hasWordList,
+                                          Words(words, arena),
+                                          body);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** one `pattern | pattern) list ;;` of a `case` command */
+struct CaseItem final : public ASTBase<CaseItem>
+{
+    enum class Terminator
+    {
+        /** the last item can leave out its terminator */
+        None,
+        /** `;;` */
+        Break,
+        /** `;&` */
+        FallThrough,
+        /** `;;&` */
+        Continue,
+    };
+    typedef util::ArenaVector<util::ArenaPtr<Word>, 2> Patterns;
+    Patterns patterns;
+    /** null if the item has no commands */
+    util::ArenaPtr<Command> body;
+    Terminator terminator;
+    CaseItem(const input::LocationSpan &location,
+             Patterns patterns,
+             util::ArenaPtr<Command> body,
+             Terminator terminator) noexcept : ASTBase<CaseItem>(location),
+                                               patterns(std::move(patterns)),
+                                               body(std::move(body)),
+                                               terminator(terminator)
+    {
+    }
+    virtual util::ArenaPtr<CaseItem> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<CaseItem>(getLocation(), Patterns(patterns, arena), body, terminator);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+struct CaseCommand final : public CompoundCommand
+{
+    typedef util::ArenaVector<util::ArenaPtr<CaseItem>, 3> Items;
+    util::ArenaPtr<Word> word;
+    Items items;
+    CaseCommand(const input::LocationSpan &location,
+                Redirections redirections,
+                util::ArenaPtr<Word> word,
+                Items items) noexcept : CompoundCommand(location, std::move(redirections)),
+                                        word(std::move(word)),
+                                        items(std::move(items))
+    {
+    }
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<CaseCommand>(
+            getLocation(), Redirections(redirections, arena), word, Items(items, arena));
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** `[[ expression ]]` */
+struct ConditionalCommand final : public CompoundCommand
+{
+    util::ArenaPtr<ConditionalExpression> expression;
+    ConditionalCommand(const input::LocationSpan &location,
+                       Redirections redirections,
+                       util::ArenaPtr<ConditionalExpression> expression) noexcept
+        : CompoundCommand(location, std::move(redirections)),
+          expression(std::move(expression))
+    {
+    }
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<ConditionalCommand>(
+            getLocation(), Redirections(redirections, arena), expression);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** the body of a function that `parser::Parser` skipped over in lazy mode; it is parsed into a
+ * `BraceGroup` or `Subshell` by `parser::Parser::getFunctionBody` the first time it's needed */
+struct LazyFunctionBody final : public CompoundCommand
+{
+    using CompoundCommand::CompoundCommand;
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<LazyFunctionBody>(getLocation(), Redirections(redirections, arena));
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** `name() compound-command` or `function name compound-command` */
+struct FunctionDefinition final : public Command
+{
+    util::ArenaPtr<Word> name;
+    /** includes the redirections for when the function runs */
+    util::ArenaPtr<CompoundCommand> body;
+    bool usesFunctionKeyword;
+    FunctionDefinition(const input::LocationSpan &location,
+                       util::ArenaPtr<Word> name,
+                       util::ArenaPtr<CompoundCommand> body,
+                       bool usesFunctionKeyword) noexcept
+        : Command(location),
+          name(std::move(name)),
+          body(std::move(body)),
+          usesFunctionKeyword(usesFunctionKeyword)
+    {
+    }
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<FunctionDefinition>(getLocation(), name, body, usesFunctionKeyword);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** `coproc [name] command` */
+struct CoprocCommand final : public Command
+{
+    /** null for the default name */
+    util::ArenaPtr<Word> name;
+    util::ArenaPtr<Command> command;
+    CoprocCommand(const input::LocationSpan &location,
+                  util::ArenaPtr<Word> name,
+                  util::ArenaPtr<Command> command) noexcept : Command(location),
+                                                              name(std::move(name)),
+                                                              command(std::move(command))
+    {
+    }
+    virtual util::ArenaPtr<Command> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<CoprocCommand>(getLocation(), name, command);
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
 };
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "conditional_expression.h"
+#include <ostream>
+
+namespace quick_shell
+{
+namespace ast
+{
+void ConditionalWordExpression::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": ConditionalWordExpression" << std::endl;
+    word->dump(os, dumpState);
+}
+
+void ConditionalUnaryExpression::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation()
+       << ": ConditionalUnaryExpression: " << ASTDumpState::escapedQuotedString(operatorText)
+       << std::endl;
+    operand->dump(os, dumpState);
+}
+
+void ConditionalBinaryExpression::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation()
+       << ": ConditionalBinaryExpression: " << ASTDumpState::escapedQuotedString(operatorText)
+       << std::endl;
+    left->dump(os, dumpState);
+    right->dump(os, dumpState);
+}
+
+void ConditionalNotExpression::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": ConditionalNotExpression" << std::endl;
+    operand->dump(os, dumpState);
+}
+
+void ConditionalAndOrExpression::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": ConditionalAndOrExpression: " << (isOr ? "||" : "&&") << std::endl;
+    left->dump(os, dumpState);
+    right->dump(os, dumpState);
+}
+}
+}
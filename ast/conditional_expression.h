@@ -0,0 +1,137 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AST_CONDITIONAL_EXPRESSION_H_
+#define AST_CONDITIONAL_EXPRESSION_H_
+
+#include <utility>
+#include "ast_base.h"
+#include "word.h"
+#include "../util/string_view.h"
+
+namespace quick_shell
+{
+namespace ast
+{
+/** an expression inside `[[ ]]` */
+struct ConditionalExpression : public ASTBase<ConditionalExpression>
+{
+    using ASTBase<ConditionalExpression>::ASTBase;
+};
+
+/** a word by itself, which is true if it isn't empty */
+struct ConditionalWordExpression final : public ConditionalExpression
+{
+    util::ArenaPtr<Word> word;
+    ConditionalWordExpression(const input::LocationSpan &location,
+                              util::ArenaPtr<Word> word) noexcept
+        : ConditionalExpression(location),
+          word(std::move(word))
+    {
+    }
+    virtual util::ArenaPtr<ConditionalExpression> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<ConditionalWordExpression>(*this);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** a test like `-f file`; `operatorText` is a string literal, so it doesn't depend on any arena
+ * or symbol table */
+struct ConditionalUnaryExpression final : public ConditionalExpression
+{
+    util::string_view operatorText;
+    util::ArenaPtr<Word> operand;
+    ConditionalUnaryExpression(const input::LocationSpan &location,
+                               util::string_view operatorText,
+                               util::ArenaPtr<Word> operand) noexcept
+        : ConditionalExpression(location),
+          operatorText(operatorText),
+          operand(std::move(operand))
+    {
+    }
+    virtual util::ArenaPtr<ConditionalExpression> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<ConditionalUnaryExpression>(*this);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** a test like `a == b` or `a < b`; `operatorText` is a string literal, like in
+ * `ConditionalUnaryExpression` */
+struct ConditionalBinaryExpression final : public ConditionalExpression
+{
+    util::ArenaPtr<Word> left;
+    util::string_view operatorText;
+    util::ArenaPtr<Word> right;
+    ConditionalBinaryExpression(const input::LocationSpan &location,
+                                util::ArenaPtr<Word> left,
+                                util::string_view operatorText,
+                                util::ArenaPtr<Word> right) noexcept
+        : ConditionalExpression(location),
+          left(std::move(left)),
+          operatorText(operatorText),
+          right(std::move(right))
+    {
+    }
+    virtual util::ArenaPtr<ConditionalExpression> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<ConditionalBinaryExpression>(*this);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+struct ConditionalNotExpression final : public ConditionalExpression
+{
+    util::ArenaPtr<ConditionalExpression> operand;
+    ConditionalNotExpression(const input::LocationSpan &location,
+                             util::ArenaPtr<ConditionalExpression> operand) noexcept
+        : ConditionalExpression(location),
+          operand(std::move(operand))
+    {
+    }
+    virtual util::ArenaPtr<ConditionalExpression> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<ConditionalNotExpression>(*this);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+/** `&&` or `||` */
+struct ConditionalAndOrExpression final : public ConditionalExpression
+{
+    bool isOr;
+    util::ArenaPtr<ConditionalExpression> left;
+    util::ArenaPtr<ConditionalExpression> right;
+    ConditionalAndOrExpression(const input::LocationSpan &location,
+                               bool isOr,
+                               util::ArenaPtr<ConditionalExpression> left,
+                               util::ArenaPtr<ConditionalExpression> right) noexcept
+        : ConditionalExpression(location),
+          isOr(isOr),
+          left(std::move(left)),
+          right(std::move(right))
+    {
+    }
+    virtual util::ArenaPtr<ConditionalExpression> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<ConditionalAndOrExpression>(*this);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+}
+}
+
+#endif /* AST_CONDITIONAL_EXPRESSION_H_ */
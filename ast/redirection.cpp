@@ -0,0 +1,43 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "redirection.h"
+#include <ostream>
+
+namespace quick_shell
+{
+namespace ast
+{
+void HereDocument::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent << getLocation() << ": HereDocument" << (isQuoted ? "<Quoted>" : "")
+       << ": " << ASTDumpState::escapedQuotedString(getRawSourceText()) << std::endl;
+}
+
+void Redirection::dump(std::ostream &os, ASTDumpState &dumpState) const
+{
+    os << dumpState.indent;
+    ASTDumpState::PushIndent pushIndent(dumpState);
+    os << getLocation() << ": Redirection: ";
+    if(fileDescriptor >= 0)
+        os << fileDescriptor;
+    os << getKindString(kind) << std::endl;
+    target->dump(os, dumpState);
+    if(hereDocument)
+        hereDocument->dump(os, dumpState);
+}
+}
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef AST_REDIRECTION_H_
+#define AST_REDIRECTION_H_
+
+#include <utility>
+#include "ast_base.h"
+#include "word.h"
+#include "word_or_redirection.h"
+#include "../util/string_view.h"
+#include "../util/compiler_intrinsics.h"
+
+namespace quick_shell
+{
+namespace ast
+{
+/** the body of a here-document, from the line after the redirection up to but not including the
+ * delimiter line */
+struct HereDocument final : public ASTBase<HereDocument>
+{
+    /** true if any part of the delimiter was quoted, so the body isn't expanded */
+    bool isQuoted;
+    HereDocument(const input::LocationSpan &location, bool isQuoted) noexcept
+        : ASTBase<HereDocument>(location),
+          isQuoted(isQuoted)
+    {
+    }
+    virtual util::ArenaPtr<HereDocument> duplicate(util::Arena &arena) const override
+    {
+        return arena.allocate<HereDocument>(*this);
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+
+struct Redirection final : public WordOrRedirection
+{
+    enum class Kind
+    {
+        Input, // "<"
+        Output, // ">"
+        Append, // ">>"
+        Clobber, // ">|"
+        DuplicateInput, // "<&"
+        DuplicateOutput, // ">&"
+        ReadWrite, // "<>"
+        HereDocument, // "<<"
+        HereDocumentStripTabs, // "<<-"
+        HereString, // "<<<"
+        OutputAndError, // "&>"
+        AppendOutputAndError, // "&>>"
+    };
+    static util::string_view getKindString(Kind kind) noexcept
+    {
+        switch(kind)
+        {
+        case Kind::Input:
+            return "<";
+        case Kind::Output:
+            return ">";
+        case Kind::Append:
+            return ">>";
+        case Kind::Clobber:
+            return ">|";
+        case Kind::DuplicateInput:
+            return "<&";
+        case Kind::DuplicateOutput:
+            return ">&";
+        case Kind::ReadWrite:
+            return "<>";
+        case Kind::HereDocument:
+            return "<<";
+        case Kind::HereDocumentStripTabs:
+            return "<<-";
+        case Kind::HereString:
+            return "<<<";
+        case Kind::OutputAndError:
+            return "&>";
+        case Kind::AppendOutputAndError:
+            return "&>>";
+        }
+        UNREACHABLE();
+        return "";
+    }
+    static constexpr bool isHereDocument(Kind kind) noexcept
+    {
+        return kind == Kind::HereDocument || kind == Kind::HereDocumentStripTabs;
+    }
+    Kind kind;
+    /** the explicit file descriptor before the operator, or -1 for the operator's default */
+    int fileDescriptor;
+    /** the file name, file descriptor, here-string or here-document delimiter */
+    util::ArenaPtr<Word> target;
+    /** for here-documents; filled in once the parser reaches the end of the line */
+    util::ArenaPtr<HereDocument> hereDocument;
+    Redirection(const input::LocationSpan &location,
+                Kind kind,
+                int fileDescriptor,
+                util::ArenaPtr<Word> target) noexcept
+        : WordOrRedirection(location),
+          kind(kind),
+          fileDescriptor(fileDescriptor),
+          target(std::move(target)),
+          hereDocument()
+    {
+    }
+    virtual util::ArenaPtr<WordOrRedirection> duplicate(util::Arena &arena) const override
+    {
+        auto retval = arena.allocate<Redirection>(getLocation(), kind, fileDescriptor, target);
+        retval->hereDocument = hereDocument;
+        return retval;
+    }
+    virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
+};
+}
+}
+
+#endif /* AST_REDIRECTION_H_ */
@@ -16,6 +16,7 @@
 #include "word.h"
 #include "word_part.h"
 #include <ostream>
+#include <cstring>
 
 namespace quick_shell
 {
@@ -23,9 +24,17 @@ namespace ast
 {
 util::ArenaPtr<WordOrRedirection> Word::duplicateRecursive(util::Arena &arena) const
 {
-    auto retval = arena.allocate<Word>(*this);
+    auto retval = arena.allocate<Word>(getLocation(), WordParts(wordParts, arena));
+    retval->literalSymbol = literalSymbol;
+    // so the copy doesn't depend on the original's arena
     for(auto &wordPart : retval->wordParts)
-        wordPart = wordPart->duplicateRecursive(arena);
+    {
+        if(wordPart.isCookedTextInline() || wordPart.cookedTextSize == 0)
+            continue;
+        auto *text = static_cast<char *>(arena.allocateBytes(wordPart.cookedTextSize, 1));
+        std::memcpy(text, wordPart.cookedTextPointer, wordPart.cookedTextSize);
+        wordPart.cookedTextPointer = text;
+    }
     return retval;
 }
 
@@ -33,11 +42,14 @@ void Word::dump(std::ostream &os, ASTDumpState &dumpState) const
 {
     os << dumpState.indent;
     ASTDumpState::PushIndent pushIndent(dumpState);
-    os << location << ": Word" << std::endl;
-    for(auto &wordPart : wordParts)
-    {
-    	wordPart->dump(os, dumpState);
-    }
+    os << getLocation() << ": Word" << std::endl;
+    // the part nodes are only needed while they're dumped
+    util::Arena viewArena;
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+    viewArena.setContext(getLocation().input);
+#endif
+    for(std::size_t i = 0; i < wordParts.size(); i++)
+        makeWordPart(i, viewArena)->dump(os, dumpState);
 }
 }
 }
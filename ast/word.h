@@ -16,33 +16,49 @@
 #ifndef AST_WORD_H_
 #define AST_WORD_H_
 
-#include <vector>
 #include "word_or_redirection.h"
+#include "word_part.h"
+#include "../util/arena_vector.h"
 
 namespace quick_shell
 {
 namespace ast
 {
-struct WordPart;
-
 struct Word final : public WordOrRedirection
 {
-    std::vector<util::ArenaPtr<WordPart>> wordParts;
-    Word(const input::LocationSpan &location, std::vector<util::ArenaPtr<WordPart>> wordParts)
-        : WordOrRedirection(location), wordParts(std::move(wordParts))
+    /** most words are a single part, which is stored inline */
+    typedef util::ArenaVector<CompactWordPart, 1> WordParts;
+    WordParts wordParts;
+    /** the word's value after quote removal, interned when parsed, if the word is a command name,
+     * a function name or the variable name of a `coproc` or `for` command and is entirely literal
+     * text; invalid otherwise */
+    util::SymbolId literalSymbol;
+    Word(const input::LocationSpan &location, WordParts wordParts)
+        : WordOrRedirection(location), wordParts(std::move(wordParts)), literalSymbol()
     {
     }
     Word(const input::LocationSpan &location,
-         std::initializer_list<util::ArenaPtr<WordPart>> wordParts)
-        : WordOrRedirection(location), wordParts(wordParts)
+         util::Arena &arena,
+         std::initializer_list<CompactWordPart> wordParts)
+        : WordOrRedirection(location), wordParts(arena, wordParts), literalSymbol()
+    {
+    }
+    explicit Word(const input::LocationSpan &location)
+        : WordOrRedirection(location), wordParts(), literalSymbol()
     {
     }
-    explicit Word(const input::LocationSpan &location) : WordOrRedirection(location), wordParts()
+    /** makes the `WordPart` node for `wordParts[index]` in `arena`; with
+     * `QUICK_SHELL_COMPACT_ARENA_PTR`, `arena`'s context must be this word's input */
+    util::ArenaPtr<WordPart> makeWordPart(std::size_t index, util::Arena &arena) const
     {
+        return wordParts[index].makeWordPart(arena, getLocation().input);
     }
+    /** the copy shares its parts' cooked text with this word */
     virtual util::ArenaPtr<WordOrRedirection> duplicate(util::Arena &arena) const override
     {
-        return arena.allocate<Word>(*this);
+        auto retval = arena.allocate<Word>(getLocation(), WordParts(wordParts, arena));
+        retval->literalSymbol = literalSymbol;
+        return retval;
     }
     virtual util::ArenaPtr<WordOrRedirection> duplicateRecursive(util::Arena &arena) const override;
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
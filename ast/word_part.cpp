@@ -19,22 +19,126 @@ namespace quick_shell
 {
 namespace ast
 {
+namespace
+{
+template <template <WordPart::QuoteKind> class T, typename... Args>
+util::ArenaPtr<WordPart> makeWithQuoteKind(util::Arena &arena,
+                                           WordPart::QuoteKind quoteKind,
+                                           Args &&... args)
+{
+    switch(quoteKind)
+    {
+    case WordPart::QuoteKind::Unquoted:
+        return arena.allocate<T<WordPart::QuoteKind::Unquoted>>(std::forward<Args>(args)...);
+    case WordPart::QuoteKind::SingleQuote:
+        return arena.allocate<T<WordPart::QuoteKind::SingleQuote>>(std::forward<Args>(args)...);
+    case WordPart::QuoteKind::DoubleQuote:
+        return arena.allocate<T<WordPart::QuoteKind::DoubleQuote>>(std::forward<Args>(args)...);
+    case WordPart::QuoteKind::EscapeInterpretingSingleQuote:
+        return arena.allocate<T<WordPart::QuoteKind::EscapeInterpretingSingleQuote>>(
+            std::forward<Args>(args)...);
+    case WordPart::QuoteKind::LocalizedDoubleQuote:
+        return arena.allocate<T<WordPart::QuoteKind::LocalizedDoubleQuote>>(
+            std::forward<Args>(args)...);
+    }
+    UNREACHABLE();
+    return nullptr;
+}
+
+template <bool isStart>
+util::ArenaPtr<WordPart> makeQuoteWordPart(util::Arena &arena,
+                                           WordPart::QuoteKind quoteKind,
+                                           const input::LocationSpan &location)
+{
+    switch(quoteKind)
+    {
+    case WordPart::QuoteKind::Unquoted:
+        break;
+    case WordPart::QuoteKind::SingleQuote:
+        return arena.allocate<QuoteWordPart<isStart, WordPart::QuoteKind::SingleQuote>>(location);
+    case WordPart::QuoteKind::DoubleQuote:
+        return arena.allocate<QuoteWordPart<isStart, WordPart::QuoteKind::DoubleQuote>>(location);
+    case WordPart::QuoteKind::EscapeInterpretingSingleQuote:
+        return arena.allocate<
+            QuoteWordPart<isStart, WordPart::QuoteKind::EscapeInterpretingSingleQuote>>(location);
+    case WordPart::QuoteKind::LocalizedDoubleQuote:
+        return arena.allocate<QuoteWordPart<isStart, WordPart::QuoteKind::LocalizedDoubleQuote>>(
+            location);
+    }
+    UNREACHABLE();
+    return nullptr;
+}
+}
+
+util::ArenaPtr<WordPart> CompactWordPart::makeWordPart(util::Arena &arena,
+                                                       input::TextInput *textInput) const
+{
+    input::LocationSpan location(getSimpleLocationSpan(), textInput);
+    auto cookedText = getCookedText();
+    switch(kind)
+    {
+    case Kind::QuoteStart:
+        return makeQuoteWordPart<true>(arena, quoteKind, location);
+    case Kind::QuoteStop:
+        return makeQuoteWordPart<false>(arena, quoteKind, location);
+    case Kind::Text:
+        return makeWithQuoteKind<TextWordPart>(arena, quoteKind, location, cookedText);
+    case Kind::AssignmentVariableName:
+        return arena.allocate<AssignmentVariableNameWordPart>(location, cookedText, symbol);
+    case Kind::AssignmentEqualSign:
+        return arena.allocate<AssignmentEqualSignWordPart>(location, cookedText);
+    case Kind::AssignmentPlusEqualSign:
+        return arena.allocate<AssignmentPlusEqualSignWordPart>(location, cookedText);
+    case Kind::ReservedWord:
+        return GenericReservedWordPart::make(arena, location, getReservedWord());
+    case Kind::SimpleEscapeSequence:
+        assert(cookedText.size() == 1);
+        return makeWithQuoteKind<SimpleEscapeSequenceWordPart>(
+            arena, quoteKind, location, cookedText[0]);
+    case Kind::BashBugEscapeSequence:
+        return makeWithQuoteKind<BashBugEscapeSequenceWordPart>(
+            arena, quoteKind, location, static_cast<std::string>(cookedText));
+    case Kind::HexEscapeSequence:
+        assert(cookedText.size() == 1);
+        return makeWithQuoteKind<HexEscapeSequenceWordPart>(
+            arena, quoteKind, location, cookedText[0]);
+    case Kind::OctalEscapeSequence:
+        assert(cookedText.size() == 1);
+        return makeWithQuoteKind<OctalEscapeSequenceWordPart>(
+            arena, quoteKind, location, cookedText[0]);
+    case Kind::UnicodeEscapeSequence:
+    {
+        util::EncodedUTF8CodePoint value;
+        std::memcpy(value.bytes, cookedText.data(), cookedText.size());
+        value.bytesUsed = cookedText.size();
+        return makeWithQuoteKind<UnicodeEscapeSequenceWordPart>(
+            arena, quoteKind, location, value);
+    }
+    case Kind::CommandSubstitution:
+        // the parser doesn't make command substitutions yet
+        UNIMPLEMENTED();
+        return nullptr;
+    }
+    UNREACHABLE();
+    return nullptr;
+}
+
 void AssignmentVariableNameWordPart::dump(std::ostream &os, ASTDumpState &dumpState) const
 {
-    os << dumpState.indent << location << ": AssignmentVariableNameWordPart: "
+    os << dumpState.indent << getLocation() << ": AssignmentVariableNameWordPart: "
        << ASTDumpState::escapedQuotedString(getRawSourceText()) << std::endl;
 }
 
 void AssignmentEqualSignWordPart::dump(std::ostream &os, ASTDumpState &dumpState) const
 {
-    os << dumpState.indent << location
+    os << dumpState.indent << getLocation()
        << ": AssignmentEqualSignWordPart: " << ASTDumpState::escapedQuotedString(getRawSourceText())
        << std::endl;
 }
 
 void AssignmentPlusEqualSignWordPart::dump(std::ostream &os, ASTDumpState &dumpState) const
 {
-    os << dumpState.indent << location << ": AssignmentPlusEqualSignWordPart: "
+    os << dumpState.indent << getLocation() << ": AssignmentPlusEqualSignWordPart: "
        << ASTDumpState::escapedQuotedString(getRawSourceText()) << std::endl;
 }
 }
@@ -19,9 +19,12 @@
 #include <string>
 #include <cassert>
 #include <utility>
+#include <cstdint>
+#include <cstring>
 #include <ostream>
 #include "ast_base.h"
 #include "../util/string_view.h"
+#include "../util/symbol_table.h"
 #include "../util/compiler_intrinsics.h"
 #include "../parser/reserved_word.h"
 #include "../util/unicode.h"
@@ -32,10 +35,12 @@ namespace ast
 {
 using parser::ReservedWord;
 
+struct CompactWordPart;
+
 struct WordPart : public ASTBase<WordPart>
 {
     using ASTBase<WordPart>::ASTBase;
-    enum class QuoteKind
+    enum class QuoteKind : std::uint8_t
     {
         Unquoted,
         SingleQuote,
@@ -116,6 +121,136 @@ struct WordPart : public ASTBase<WordPart>
     {
         return QuotePart::Other;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept = 0;
+    /** the literal text of this part, stored when it was parsed: line continuations are removed
+     * where they apply, and escape sequences give their value. Empty for parts without literal
+     * text, or if the text wasn't stored. */
+    virtual util::string_view getCookedText() const noexcept
+    {
+        return util::string_view();
+    }
+};
+
+/** a word part as plain data, for walking words without virtual calls or RTTI.
+ *
+ * `Word` keeps its parts only in this form, in one contiguous array. The `WordPart` nodes are
+ * views of it, made by `makeWordPart` when they're needed.
+ * */
+struct CompactWordPart final
+{
+    enum class Kind : std::uint8_t
+    {
+        QuoteStart,
+        QuoteStop,
+        Text,
+        AssignmentVariableName,
+        AssignmentEqualSign,
+        AssignmentPlusEqualSign,
+        ReservedWord,
+        SimpleEscapeSequence,
+        BashBugEscapeSequence,
+        HexEscapeSequence,
+        OctalEscapeSequence,
+        UnicodeEscapeSequence,
+        CommandSubstitution,
+    };
+    static constexpr std::size_t maxValueSize = util::EncodedUTF8CodePoint::maxSize;
+    Kind kind;
+    WordPart::QuoteKind quoteKind;
+    /** the `ReservedWord` for reserved words */
+    std::uint8_t subKind;
+    std::uint32_t cookedTextSize;
+    /** escape sequence values are stored inline, other cooked text is in the arena */
+    union
+    {
+        char inlineCookedText[maxValueSize];
+        const char *cookedTextPointer;
+    };
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+    input::CompactLocationSpan location;
+#else
+    input::SimpleLocationSpan location;
+#endif
+    /** the variable name, interned when parsed, for `AssignmentVariableName`; invalid otherwise
+     * or if not interned */
+    util::SymbolId symbol;
+    CompactWordPart(Kind kind,
+                    WordPart::QuoteKind quoteKind,
+                    const input::SimpleLocationSpan &location,
+                    util::string_view cookedText = util::string_view(),
+                    util::SymbolId symbol = util::SymbolId()) noexcept
+        : kind(kind),
+          quoteKind(quoteKind),
+          subKind(0),
+          cookedTextSize(static_cast<std::uint32_t>(cookedText.size())),
+          cookedTextPointer(cookedText.data()),
+          location(location),
+          symbol(symbol)
+    {
+        assert(cookedTextSize == cookedText.size());
+        if(isCookedTextInline())
+        {
+            assert(cookedText.size() <= maxValueSize);
+            for(std::size_t i = 0; i < cookedText.size(); i++)
+                inlineCookedText[i] = cookedText[i];
+        }
+    }
+    CompactWordPart(ReservedWord reservedWord,
+                    const input::SimpleLocationSpan &location,
+                    util::string_view cookedText) noexcept
+        : CompactWordPart(Kind::ReservedWord, WordPart::QuoteKind::Unquoted, location, cookedText)
+    {
+        subKind = static_cast<std::uint8_t>(reservedWord);
+    }
+    bool isCookedTextInline() const noexcept
+    {
+        switch(kind)
+        {
+        case Kind::SimpleEscapeSequence:
+        case Kind::BashBugEscapeSequence:
+        case Kind::HexEscapeSequence:
+        case Kind::OctalEscapeSequence:
+        case Kind::UnicodeEscapeSequence:
+            return true;
+        default:
+            return false;
+        }
+    }
+    WordPart::QuotePart getQuotePart() const noexcept
+    {
+        switch(kind)
+        {
+        case Kind::QuoteStart:
+            return WordPart::QuotePart::Start;
+        case Kind::QuoteStop:
+            return WordPart::QuotePart::Stop;
+        default:
+            return WordPart::QuotePart::Other;
+        }
+    }
+    ReservedWord getReservedWord() const noexcept
+    {
+        assert(kind == Kind::ReservedWord);
+        return static_cast<ReservedWord>(subKind);
+    }
+    /** same as `WordPart::getCookedText` */
+    util::string_view getCookedText() const noexcept
+    {
+        if(isCookedTextInline())
+            return util::string_view(inlineCookedText, cookedTextSize);
+        return util::string_view(cookedTextPointer, cookedTextSize);
+    }
+    input::SimpleLocationSpan getSimpleLocationSpan() const noexcept
+    {
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+        return location.getSimpleLocationSpan();
+#else
+        return location;
+#endif
+    }
+    /** makes the `WordPart` node for this part in `arena`. The node's cooked text is shared with
+     * this part. With `QUICK_SHELL_COMPACT_ARENA_PTR`, `arena`'s context must be `textInput`. */
+    util::ArenaPtr<WordPart> makeWordPart(util::Arena &arena, input::TextInput *textInput) const;
 };
 
 struct GenericQuoteWordPart : public WordPart
@@ -136,30 +271,71 @@ struct QuoteWordPart final : public GenericQuoteWordPart
     {
         return quoteKind;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept override
+    {
+        return CompactWordPart(isStart ? CompactWordPart::Kind::QuoteStart :
+                                         CompactWordPart::Kind::QuoteStop,
+                               quoteKind,
+                               getSimpleLocationSpan());
+    }
     virtual util::ArenaPtr<WordPart> duplicate(util::Arena &arena) const override
     {
         return arena.allocate<QuoteWordPart>(*this);
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override
     {
-        os << dumpState.indent << location << ": QuoteWordPart<" << (isStart ? "Start" : "Stop")
-           << ", " << getQuoteKindString(quoteKind)
+        os << dumpState.indent << getLocation() << ": QuoteWordPart<"
+           << (isStart ? "Start" : "Stop") << ", " << getQuoteKindString(quoteKind)
            << ">: " << ASTDumpState::escapedQuotedString(getRawSourceText()) << std::endl;
     }
 };
 
 struct GenericTextWordPart : public WordPart
 {
-    using WordPart::WordPart;
+    /** in the arena; empty if not stored */
+    util::string_view cookedText;
+    explicit GenericTextWordPart(const input::LocationSpan &location,
+                                 util::string_view cookedText = util::string_view()) noexcept
+        : WordPart(location),
+          cookedText(cookedText)
+    {
+    }
     virtual QuotePart getQuotePart() const noexcept override final
     {
         return QuotePart::Other;
     }
+    virtual util::string_view getCookedText() const noexcept override final
+    {
+        return cookedText;
+    }
+
+protected:
+    /** for `duplicate`, so the copy doesn't depend on the original's arena */
+    template <typename T>
+    static util::ArenaPtr<WordPart> duplicateWithCookedText(const T &wordPart, util::Arena &arena)
+    {
+        auto retval = arena.allocate<T>(wordPart);
+        if(!wordPart.cookedText.empty())
+        {
+            auto *text = static_cast<char *>(arena.allocateBytes(wordPart.cookedText.size(), 1));
+            std::memcpy(text, wordPart.cookedText.data(), wordPart.cookedText.size());
+            retval->cookedText = util::string_view(text, wordPart.cookedText.size());
+        }
+        return retval;
+    }
 };
 
 struct GenericVariableNameWordPart : public GenericTextWordPart
 {
-    using GenericTextWordPart::GenericTextWordPart;
+    /** the variable name, interned when parsed; invalid if not interned */
+    util::SymbolId symbol;
+    explicit GenericVariableNameWordPart(const input::LocationSpan &location,
+                                         util::string_view cookedText = util::string_view(),
+                                         util::SymbolId symbol = util::SymbolId()) noexcept
+        : GenericTextWordPart(location, cookedText),
+          symbol(symbol)
+    {
+    }
 };
 
 struct AssignmentVariableNameWordPart final : public GenericVariableNameWordPart
@@ -169,9 +345,17 @@ struct AssignmentVariableNameWordPart final : public GenericVariableNameWordPart
     {
         return QuoteKind::Unquoted;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept override
+    {
+        return CompactWordPart(CompactWordPart::Kind::AssignmentVariableName,
+                               QuoteKind::Unquoted,
+                               getSimpleLocationSpan(),
+                               cookedText,
+                               symbol);
+    }
     virtual util::ArenaPtr<WordPart> duplicate(util::Arena &arena) const override
     {
-        return arena.allocate<AssignmentVariableNameWordPart>(*this);
+        return duplicateWithCookedText(*this, arena);
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
 };
@@ -214,9 +398,16 @@ struct AssignmentEqualSignWordPart final : public AssignmentOperatorWordPart
     {
         return AssignmentOperator::Equals;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept override
+    {
+        return CompactWordPart(CompactWordPart::Kind::AssignmentEqualSign,
+                               QuoteKind::Unquoted,
+                               getSimpleLocationSpan(),
+                               cookedText);
+    }
     virtual util::ArenaPtr<WordPart> duplicate(util::Arena &arena) const override
     {
-        return arena.allocate<AssignmentEqualSignWordPart>(*this);
+        return duplicateWithCookedText(*this, arena);
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
 };
@@ -228,9 +419,16 @@ struct AssignmentPlusEqualSignWordPart final : public AssignmentOperatorWordPart
     {
         return AssignmentOperator::PlusEquals;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept override
+    {
+        return CompactWordPart(CompactWordPart::Kind::AssignmentPlusEqualSign,
+                               QuoteKind::Unquoted,
+                               getSimpleLocationSpan(),
+                               cookedText);
+    }
     virtual util::ArenaPtr<WordPart> duplicate(util::Arena &arena) const override
     {
-        return arena.allocate<AssignmentPlusEqualSignWordPart>(*this);
+        return duplicateWithCookedText(*this, arena);
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override;
 };
@@ -243,13 +441,19 @@ struct TextWordPart final : public GenericTextWordPart
     {
         return quoteKind;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept override
+    {
+        return CompactWordPart(
+            CompactWordPart::Kind::Text, quoteKind, getSimpleLocationSpan(), cookedText);
+    }
     virtual util::ArenaPtr<WordPart> duplicate(util::Arena &arena) const override
     {
-        return arena.allocate<TextWordPart>(*this);
+        return duplicateWithCookedText(*this, arena);
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override
     {
-        os << dumpState.indent << location << ": TextWordPart<" << getQuoteKindString(quoteKind)
+        os << dumpState.indent << getLocation() << ": TextWordPart<"
+           << getQuoteKindString(quoteKind)
            << ">: " << ASTDumpState::escapedQuotedString(getRawSourceText()) << std::endl;
     }
 };
@@ -275,13 +479,17 @@ struct ReservedWordPart final : public GenericReservedWordPart
     {
         return reservedWord;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept override
+    {
+        return CompactWordPart(reservedWord, getSimpleLocationSpan(), cookedText);
+    }
     virtual util::ArenaPtr<WordPart> duplicate(util::Arena &arena) const override
     {
         return arena.allocate<ReservedWordPart>(*this);
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override
     {
-        os << dumpState.indent << location << ": ReservedWordPart<"
+        os << dumpState.indent << getLocation() << ": ReservedWordPart<"
            << getReservedWordName(reservedWord)
            << ">: " << ASTDumpState::escapedQuotedString(getRawSourceText()) << std::endl;
     }
@@ -290,52 +498,53 @@ struct ReservedWordPart final : public GenericReservedWordPart
 inline util::ArenaPtr<GenericReservedWordPart> GenericReservedWordPart::make(
     util::Arena &arena, const input::LocationSpan &location, ReservedWord reservedWord)
 {
+    auto text = getReservedWordString(reservedWord);
     switch(reservedWord)
     {
     case ReservedWord::ExMark:
-        return arena.allocate<ReservedWordPart<ReservedWord::ExMark>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::ExMark>>(location, text);
     case ReservedWord::DoubleLBracket:
-        return arena.allocate<ReservedWordPart<ReservedWord::DoubleLBracket>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::DoubleLBracket>>(location, text);
     case ReservedWord::DoubleRBracket:
-        return arena.allocate<ReservedWordPart<ReservedWord::DoubleRBracket>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::DoubleRBracket>>(location, text);
     case ReservedWord::Case:
-        return arena.allocate<ReservedWordPart<ReservedWord::Case>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::Case>>(location, text);
     case ReservedWord::Coproc:
-        return arena.allocate<ReservedWordPart<ReservedWord::Coproc>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::Coproc>>(location, text);
     case ReservedWord::Do:
-        return arena.allocate<ReservedWordPart<ReservedWord::Do>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::Do>>(location, text);
     case ReservedWord::Done:
-        return arena.allocate<ReservedWordPart<ReservedWord::Done>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::Done>>(location, text);
     case ReservedWord::ElIf:
-        return arena.allocate<ReservedWordPart<ReservedWord::ElIf>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::ElIf>>(location, text);
     case ReservedWord::Else:
-        return arena.allocate<ReservedWordPart<ReservedWord::Else>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::Else>>(location, text);
     case ReservedWord::Esac:
-        return arena.allocate<ReservedWordPart<ReservedWord::Esac>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::Esac>>(location, text);
     case ReservedWord::Fi:
-        return arena.allocate<ReservedWordPart<ReservedWord::Fi>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::Fi>>(location, text);
     case ReservedWord::For:
-        return arena.allocate<ReservedWordPart<ReservedWord::For>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::For>>(location, text);
     case ReservedWord::Function:
-        return arena.allocate<ReservedWordPart<ReservedWord::Function>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::Function>>(location, text);
     case ReservedWord::If:
-        return arena.allocate<ReservedWordPart<ReservedWord::If>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::If>>(location, text);
     case ReservedWord::In:
-        return arena.allocate<ReservedWordPart<ReservedWord::In>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::In>>(location, text);
     case ReservedWord::Select:
-        return arena.allocate<ReservedWordPart<ReservedWord::Select>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::Select>>(location, text);
     case ReservedWord::Then:
-        return arena.allocate<ReservedWordPart<ReservedWord::Then>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::Then>>(location, text);
     case ReservedWord::Time:
-        return arena.allocate<ReservedWordPart<ReservedWord::Time>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::Time>>(location, text);
     case ReservedWord::Until:
-        return arena.allocate<ReservedWordPart<ReservedWord::Until>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::Until>>(location, text);
     case ReservedWord::While:
-        return arena.allocate<ReservedWordPart<ReservedWord::While>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::While>>(location, text);
     case ReservedWord::LBrace:
-        return arena.allocate<ReservedWordPart<ReservedWord::LBrace>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::LBrace>>(location, text);
     case ReservedWord::RBrace:
-        return arena.allocate<ReservedWordPart<ReservedWord::RBrace>>(location);
+        return arena.allocate<ReservedWordPart<ReservedWord::RBrace>>(location, text);
     }
     UNREACHABLE();
     return nullptr;
@@ -349,6 +558,10 @@ struct GenericEscapeSequenceWordPart : public WordPart
     {
         return QuotePart::Other;
     }
+    virtual util::string_view getCookedText() const noexcept override final
+    {
+        return getValue();
+    }
 };
 
 struct GenericSimpleEscapeSequenceWordPart : public GenericEscapeSequenceWordPart
@@ -374,13 +587,20 @@ struct SimpleEscapeSequenceWordPart final : public GenericSimpleEscapeSequenceWo
     {
         return quoteKind;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept override
+    {
+        return CompactWordPart(CompactWordPart::Kind::SimpleEscapeSequence,
+                               quoteKind,
+                               getSimpleLocationSpan(),
+                               getValue());
+    }
     virtual util::ArenaPtr<WordPart> duplicate(util::Arena &arena) const override
     {
         return arena.allocate<SimpleEscapeSequenceWordPart>(*this);
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override
     {
-        os << dumpState.indent << location << ": SimpleEscapeSequenceWordPart<"
+        os << dumpState.indent << getLocation() << ": SimpleEscapeSequenceWordPart<"
            << getQuoteKindString(quoteKind)
            << ">(value=" << ASTDumpState::escapedQuotedString(getValue())
            << "): " << ASTDumpState::escapedQuotedString(getRawSourceText()) << std::endl;
@@ -410,13 +630,20 @@ struct BashBugEscapeSequenceWordPart final : public GenericBashBugEscapeSequence
     {
         return quoteKind;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept override
+    {
+        return CompactWordPart(CompactWordPart::Kind::BashBugEscapeSequence,
+                               quoteKind,
+                               getSimpleLocationSpan(),
+                               getValue());
+    }
     virtual util::ArenaPtr<WordPart> duplicate(util::Arena &arena) const override
     {
         return arena.allocate<BashBugEscapeSequenceWordPart>(*this);
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override
     {
-        os << dumpState.indent << location << ": BashBugEscapeSequenceWordPart<"
+        os << dumpState.indent << getLocation() << ": BashBugEscapeSequenceWordPart<"
            << getQuoteKindString(quoteKind)
            << ">(value=" << ASTDumpState::escapedQuotedString(getValue())
            << "): " << ASTDumpState::escapedQuotedString(getRawSourceText()) << std::endl;
@@ -446,13 +673,20 @@ struct HexEscapeSequenceWordPart final : public GenericHexEscapeSequenceWordPart
     {
         return quoteKind;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept override
+    {
+        return CompactWordPart(CompactWordPart::Kind::HexEscapeSequence,
+                               quoteKind,
+                               getSimpleLocationSpan(),
+                               getValue());
+    }
     virtual util::ArenaPtr<WordPart> duplicate(util::Arena &arena) const override
     {
         return arena.allocate<HexEscapeSequenceWordPart>(*this);
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override
     {
-        os << dumpState.indent << location << ": HexEscapeSequenceWordPart<"
+        os << dumpState.indent << getLocation() << ": HexEscapeSequenceWordPart<"
            << getQuoteKindString(quoteKind)
            << ">(value=" << ASTDumpState::escapedQuotedString(getValue())
            << "): " << ASTDumpState::escapedQuotedString(getRawSourceText()) << std::endl;
@@ -482,13 +716,20 @@ struct OctalEscapeSequenceWordPart final : public GenericOctalEscapeSequenceWord
     {
         return quoteKind;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept override
+    {
+        return CompactWordPart(CompactWordPart::Kind::OctalEscapeSequence,
+                               quoteKind,
+                               getSimpleLocationSpan(),
+                               getValue());
+    }
     virtual util::ArenaPtr<WordPart> duplicate(util::Arena &arena) const override
     {
         return arena.allocate<OctalEscapeSequenceWordPart>(*this);
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override
     {
-        os << dumpState.indent << location << ": OctalEscapeSequenceWordPart<"
+        os << dumpState.indent << getLocation() << ": OctalEscapeSequenceWordPart<"
            << getQuoteKindString(quoteKind)
            << ">(value=" << ASTDumpState::escapedQuotedString(getValue())
            << "): " << ASTDumpState::escapedQuotedString(getRawSourceText()) << std::endl;
@@ -518,13 +759,20 @@ struct UnicodeEscapeSequenceWordPart final : public GenericUnicodeEscapeSequence
     {
         return quoteKind;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept override
+    {
+        return CompactWordPart(CompactWordPart::Kind::UnicodeEscapeSequence,
+                               quoteKind,
+                               getSimpleLocationSpan(),
+                               getValue());
+    }
     virtual util::ArenaPtr<WordPart> duplicate(util::Arena &arena) const override
     {
         return arena.allocate<UnicodeEscapeSequenceWordPart>(*this);
     }
     virtual void dump(std::ostream &os, ASTDumpState &dumpState) const override
     {
-        os << dumpState.indent << location << ": UnicodeEscapeSequenceWordPart<"
+        os << dumpState.indent << getLocation() << ": UnicodeEscapeSequenceWordPart<"
            << getQuoteKindString(quoteKind)
            << ">(value=" << ASTDumpState::escapedQuotedString(getValue())
            << "): " << ASTDumpState::escapedQuotedString(getRawSourceText()) << std::endl;
@@ -573,6 +821,12 @@ struct CommandSubstitution final : public GenericCommandSubstitution
     {
         return quoteKind;
     }
+    virtual CompactWordPart getCompactWordPart() const noexcept override
+    {
+        return CompactWordPart(CompactWordPart::Kind::CommandSubstitution,
+                               quoteKind,
+                               getSimpleLocationSpan());
+    }
 };
 }
 }
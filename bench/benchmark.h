@@ -0,0 +1,79 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef BENCH_BENCHMARK_H_
+#define BENCH_BENCHMARK_H_
+
+#include <chrono>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace quick_shell
+{
+namespace bench
+{
+/** runs `fn` `repeatCount` times and returns the fastest run's time in seconds */
+template <typename Fn>
+double bestTime(std::size_t repeatCount, Fn &&fn)
+{
+    double retval = 0;
+    for(std::size_t i = 0; i < repeatCount; i++)
+    {
+        auto startTime = std::chrono::steady_clock::now();
+        fn();
+        double time =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        if(i == 0 || time < retval)
+            retval = time;
+    }
+    return retval;
+}
+
+inline std::string readFile(const std::string &fileName)
+{
+    std::ifstream is(fileName, std::ios::binary);
+    if(!is)
+        throw std::runtime_error("can't open " + fileName);
+    std::ostringstream os;
+    os << is.rdbuf();
+    return os.str();
+}
+
+/** the file named on the command line, or the repository's test.sh when run from the repository
+ * root */
+inline std::string readCorpus(int argc, char **argv)
+{
+    return readFile(argc > 1 ? argv[1] : "test.sh");
+}
+
+/** `text` repeated until it is at least `size` bytes */
+inline std::string repeatText(const std::string &text, std::size_t size)
+{
+    std::string retval;
+    if(text.empty())
+        return retval;
+    retval.reserve(size + text.size());
+    while(retval.size() < size)
+        retval += text;
+    return retval;
+}
+}
+}
+
+#endif /* BENCH_BENCHMARK_H_ */
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Word parsing throughput: parses a script (test.sh by default), repeated to 16 MB, as top-level
+ * commands.
+ *
+ * Every character that would start an operator, an expansion or a comment is escaped first and
+ * every line is made an argument list for `echo`, so each line is a simple command made of words,
+ * and the time goes to parseWord and the parse results around it rather than to the constructs the
+ * parser doesn't implement yet.
+ *
+ * Build from the repository root:
+ *     g++ -std=c++11 -O2 -DNDEBUG -I. bench/parse_word.cpp parser/parser.cpp parser/lexer.cpp \
+ *         input/text_input.cpp input/memory.cpp input/location.cpp ast/ast_base.cpp ast/blank.cpp \
+ *         ast/comment.cpp ast/command.cpp ast/conditional_expression.cpp ast/redirection.cpp \
+ *         ast/word.cpp ast/word_part.cpp util/arena.cpp util/symbol_table.cpp -o parse_word
+ */
+
+#include "benchmark.h"
+#include "../input/memory.h"
+#include "../parser/parser.h"
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+using namespace quick_shell;
+
+namespace
+{
+std::string makeWordsOnly(const std::string &text)
+{
+    std::string retval = "echo ";
+    retval.reserve(text.size() * 2);
+    for(std::size_t i = 0; i < text.size(); i++)
+    {
+        char ch = text[i];
+        if(ch == '\\' && i + 1 < text.size())
+        {
+            retval += ch;
+            retval += text[++i];
+            continue;
+        }
+        switch(ch)
+        {
+        case '$':
+        case '`':
+        case '!':
+        case '[':
+        case ']':
+        case '#':
+        case '(':
+        case ')':
+        case '{':
+        case '}':
+        case '<':
+        case '>':
+        case '&':
+        case '|':
+        case ';':
+            retval += '\\';
+            break;
+        }
+        retval += ch;
+        // keeps reserved words out of command position
+        if(ch == '\n')
+            retval += "echo ";
+    }
+    return retval;
+}
+}
+
+int main(int argc, char **argv)
+{
+    constexpr std::size_t textSize = 16 * 1000 * 1000;
+    constexpr std::size_t repeatCount = 7;
+    const std::string text =
+        bench::repeatText(makeWordsOnly(bench::readCorpus(argc, argv)), textSize);
+    input::MemoryTextInput textInput("benchmark", input::TextInputStyle(), text);
+    std::size_t commandCount = 0, errorCount = 0;
+    double time = bench::bestTime(repeatCount,
+                                  [&]()
+                                  {
+                                      util::Arena arena;
+                                      util::SymbolTable symbolTable;
+                                      parser::Parser parser(
+                                          textInput,
+                                          arena,
+                                          symbolTable,
+                                          parser::ParserDialect::getBashDialect());
+                                      commandCount = 0;
+                                      errorCount = 0;
+                                      while(true)
+                                      {
+                                          util::ArenaPtr<ast::Command> command;
+                                          try
+                                          {
+                                              auto result = parser.parseTopLevelCommand(command);
+                                              if(result == parser::ParseCommandResult::Quit)
+                                                  break;
+                                              if(result == parser::ParseCommandResult::Success)
+                                                  commandCount++;
+                                          }
+                                          catch(parser::ParseError &)
+                                          {
+                                              errorCount++;
+                                          }
+                                      }
+                                  });
+    double megabytes = text.size() / 1e6;
+    std::cout << "input: " << megabytes << " MB, " << commandCount << " commands, " << errorCount
+              << " errors, best of " << repeatCount << std::endl;
+    std::cout << "parseTopLevelCommand: " << time << " s, " << megabytes / time << " MB/s, "
+              << time * 1e9 / commandCount << " ns/command" << std::endl;
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Times stringToReservedWord against the sorted-table lookup it replaced, over the
+ * whitespace-separated tokens of a script (test.sh by default), and checks that they agree.
+ *
+ * Build from the repository root:
+ *     g++ -std=c++11 -O2 -DNDEBUG -I. bench/reserved_word.cpp -o reserved_word
+ */
+
+#include "benchmark.h"
+#include "../parser/reserved_word.h"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace quick_shell;
+
+namespace
+{
+/** the equal_range lookup that stringToReservedWord used before, as the baseline */
+util::variant<parser::ReservedWord> tableStringToReservedWord(util::string_view v) noexcept
+{
+    using parser::ReservedWord;
+    struct StringAndReservedWord
+    {
+        util::string_view string;
+        ReservedWord reservedWord;
+    };
+    struct Comparer
+    {
+        bool operator()(StringAndReservedWord a, util::string_view b) const noexcept
+        {
+            return a.string < b;
+        }
+        bool operator()(util::string_view a, StringAndReservedWord b) const noexcept
+        {
+            return a < b.string;
+        }
+    };
+    static const StringAndReservedWord mappingTable[] = {
+        {"!", ReservedWord::ExMark},
+        {"[[", ReservedWord::DoubleLBracket},
+        {"]]", ReservedWord::DoubleRBracket},
+        {"case", ReservedWord::Case},
+        {"coproc", ReservedWord::Coproc},
+        {"do", ReservedWord::Do},
+        {"done", ReservedWord::Done},
+        {"elif", ReservedWord::ElIf},
+        {"else", ReservedWord::Else},
+        {"esac", ReservedWord::Esac},
+        {"fi", ReservedWord::Fi},
+        {"for", ReservedWord::For},
+        {"function", ReservedWord::Function},
+        {"if", ReservedWord::If},
+        {"in", ReservedWord::In},
+        {"select", ReservedWord::Select},
+        {"then", ReservedWord::Then},
+        {"time", ReservedWord::Time},
+        {"until", ReservedWord::Until},
+        {"while", ReservedWord::While},
+        {"{", ReservedWord::LBrace},
+        {"}", ReservedWord::RBrace},
+    };
+    auto results =
+        std::equal_range(std::begin(mappingTable), std::end(mappingTable), v, Comparer());
+    if(results.first == results.second)
+        return util::variant<ReservedWord>();
+    return util::variant<ReservedWord>(results.first->reservedWord);
+}
+
+bool agree(util::string_view v)
+{
+    auto a = parser::stringToReservedWord(v);
+    auto b = tableStringToReservedWord(v);
+    if(a.is<parser::ReservedWord>() != b.is<parser::ReservedWord>())
+        return false;
+    return !a.is<parser::ReservedWord>()
+           || a.get<parser::ReservedWord>() == b.get<parser::ReservedWord>();
+}
+
+/** every string of up to 4 characters from the reserved words' alphabet */
+std::size_t countDisagreements()
+{
+    const std::string alphabet = "!{}[]abcdefghilnoprstuwxyz";
+    std::size_t retval = agree(util::string_view()) ? 0 : 1;
+    std::vector<std::string> strings(1);
+    for(std::size_t length = 1; length <= 4; length++)
+    {
+        std::vector<std::string> longerStrings;
+        for(auto &string : strings)
+        {
+            for(char ch : alphabet)
+            {
+                longerStrings.push_back(string + ch);
+                if(!agree(longerStrings.back()))
+                    retval++;
+            }
+        }
+        strings = std::move(longerStrings);
+    }
+    for(const char *word : {"coproc", "function", "select", "until", "while"})
+        if(!agree(word))
+            retval++;
+    return retval;
+}
+}
+
+int main(int argc, char **argv)
+{
+    constexpr std::size_t tokenCount = 1000 * 1000;
+    constexpr std::size_t repeatCount = 7;
+    std::size_t disagreements = countDisagreements();
+    std::istringstream corpus(bench::readCorpus(argc, argv));
+    std::vector<std::string> tokenStrings(std::istream_iterator<std::string>(corpus),
+                                          (std::istream_iterator<std::string>()));
+    if(tokenStrings.empty())
+    {
+        std::cerr << "no tokens in the input" << std::endl;
+        return 1;
+    }
+    std::vector<util::string_view> tokens;
+    while(tokens.size() < tokenCount)
+        for(auto &token : tokenStrings)
+            tokens.push_back(token);
+    std::size_t switchCount = 0, tableCount = 0;
+    double switchTime = bench::bestTime(repeatCount,
+                                        [&]()
+                                        {
+                                            switchCount = 0;
+                                            for(auto token : tokens)
+                                                if(parser::stringToReservedWord(token)
+                                                       .is<parser::ReservedWord>())
+                                                    switchCount++;
+                                        });
+    double tableTime = bench::bestTime(repeatCount,
+                                       [&]()
+                                       {
+                                           tableCount = 0;
+                                           for(auto token : tokens)
+                                               if(tableStringToReservedWord(token)
+                                                      .is<parser::ReservedWord>())
+                                                   tableCount++;
+                                       });
+    std::cout << "disagreements: " << disagreements << std::endl;
+    std::cout << tokens.size() << " tokens, " << switchCount << " reserved words, best of "
+              << repeatCount << std::endl;
+    std::cout << "stringToReservedWord: " << switchTime * 1e9 / tokens.size() << " ns/token"
+              << std::endl;
+    std::cout << "sorted table:         " << tableTime * 1e9 / tokens.size() << " ns/token"
+              << std::endl;
+    return disagreements == 0 && switchCount == tableCount ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Walks a 100 MB MemoryTextInput with TextInput::Iterator and with TextInput::operator[].
+ *
+ * Build from the repository root:
+ *     g++ -std=c++11 -O2 -DNDEBUG -I. bench/text_input_iterator.cpp input/text_input.cpp \
+ *         input/memory.cpp input/location.cpp -o text_input_iterator
+ * Only the public TextInput API is used, so building it on both sides of a change to TextInput
+ * compares them.
+ */
+
+#include "benchmark.h"
+#include "../input/memory.h"
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+using namespace quick_shell;
+
+int main()
+{
+    constexpr std::size_t textSize = 100 * 1000 * 1000;
+    constexpr std::size_t repeatCount = 5;
+    const std::string text = bench::repeatText("abc\ndef gh", textSize);
+    input::MemoryTextInput textInput("benchmark", input::TextInputStyle(), text);
+    // read everything once, so both loops only measure access
+    for(auto iter = textInput.begin(); *iter != input::eof; ++iter)
+    {
+    }
+    unsigned long checksum = 0;
+    double iteratorTime = bench::bestTime(repeatCount,
+                                          [&]()
+                                          {
+                                              for(auto iter = textInput.begin();
+                                                  *iter != input::eof;
+                                                  ++iter)
+                                                  checksum += *iter;
+                                          });
+    double indexTime = bench::bestTime(repeatCount,
+                                       [&]()
+                                       {
+                                           for(std::size_t i = 0; textInput[i] != input::eof; i++)
+                                               checksum += textInput[i];
+                                       });
+    double megabytes = text.size() / 1e6;
+    std::cout << "input: " << megabytes << " MB, best of " << repeatCount << std::endl;
+    std::cout << "Iterator::operator++: " << iteratorTime << " s, "
+              << megabytes / iteratorTime << " MB/s" << std::endl;
+    std::cout << "operator[]:           " << indexTime << " s, " << megabytes / indexTime
+              << " MB/s" << std::endl;
+    std::cout << "(checksum " << checksum << ")" << std::endl;
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "editable.h"
+#include <algorithm>
+#include <cstring>
+
+namespace quick_shell
+{
+namespace input
+{
+constexpr std::size_t EditableTextInput::maxPieceCount;
+
+EditableTextInput::EditableTextInput(std::string name,
+                                     const TextInputStyle &inputStyle,
+                                     util::string_view initialText)
+    : TextInput(std::move(name), inputStyle, false),
+      originalText(initialText.data(), initialText.size()),
+      addedText(),
+      pieces(),
+      textSize(initialText.size())
+{
+    if(textSize != 0)
+        pieces.push_back(Piece(0, textSize, false, 0));
+}
+
+std::size_t EditableTextInput::findPiece(std::size_t index) const noexcept
+{
+    if(index >= textSize)
+        return pieces.size();
+    auto iter = std::upper_bound(pieces.begin(),
+                                 pieces.end(),
+                                 index,
+                                 [](std::size_t index, const Piece &piece)
+                                 {
+                                     return index < piece.startIndex;
+                                 });
+    return iter - pieces.begin() - 1;
+}
+
+std::size_t EditableTextInput::splitPiecesAt(std::size_t index)
+{
+    std::size_t pieceIndex = findPiece(index);
+    if(pieceIndex == pieces.size() || pieces[pieceIndex].startIndex == index)
+        return pieceIndex;
+    auto &piece = pieces[pieceIndex];
+    std::size_t offset = index - piece.startIndex;
+    Piece secondPiece(index, piece.size - offset, piece.isAdded, piece.sourceIndex + offset);
+    piece.size = offset;
+    pieces.insert(pieces.begin() + pieceIndex + 1, secondPiece);
+    return pieceIndex + 1;
+}
+
+void EditableTextInput::mergePieces()
+{
+    originalText = getText();
+    addedText.clear();
+    pieces.clear();
+    if(textSize != 0)
+        pieces.push_back(Piece(0, textSize, false, 0));
+}
+
+std::size_t EditableTextInput::read(std::size_t startIndex,
+                                    unsigned char *buffer,
+                                    std::size_t bufferSize)
+{
+    std::size_t readCount = 0;
+    for(std::size_t pieceIndex = findPiece(startIndex);
+        readCount < bufferSize && pieceIndex < pieces.size();
+        pieceIndex++)
+    {
+        auto &piece = pieces[pieceIndex];
+        std::size_t offset = startIndex + readCount - piece.startIndex;
+        std::size_t count = std::min(piece.size - offset, bufferSize - readCount);
+        std::memcpy(buffer + readCount, getPieceText(piece) + offset, count);
+        readCount += count;
+    }
+    return readCount;
+}
+
+void EditableTextInput::replace(std::size_t beginIndex,
+                                std::size_t endIndex,
+                                util::string_view text)
+{
+    assert(beginIndex <= endIndex && endIndex <= textSize);
+    std::size_t pieceIndex = splitPiecesAt(beginIndex);
+    std::size_t endPieceIndex = splitPiecesAt(endIndex);
+    pieces.erase(pieces.begin() + pieceIndex, pieces.begin() + endPieceIndex);
+    if(!text.empty())
+    {
+        // typing extends the piece before, if it's at the end of addedText
+        if(pieceIndex > 0 && pieces[pieceIndex - 1].isAdded
+           && pieces[pieceIndex - 1].sourceIndex + pieces[pieceIndex - 1].size
+                  == addedText.size())
+        {
+            pieces[pieceIndex - 1].size += text.size();
+        }
+        else
+        {
+            pieces.insert(pieces.begin() + pieceIndex,
+                          Piece(beginIndex, text.size(), true, addedText.size()));
+            pieceIndex++;
+        }
+        addedText.append(text.data(), text.size());
+    }
+    for(; pieceIndex < pieces.size(); pieceIndex++)
+        pieces[pieceIndex].startIndex = pieces[pieceIndex].startIndex - (endIndex - beginIndex)
+                                        + text.size();
+    textSize = textSize - (endIndex - beginIndex) + text.size();
+    // deleted text stays in addedText, so merge once there's more of it than text
+    if(pieces.size() > maxPieceCount || addedText.size() > textSize)
+        mergePieces();
+    discardFrom(beginIndex);
+}
+
+std::string EditableTextInput::getText() const
+{
+    std::string retval;
+    retval.reserve(textSize);
+    for(auto &piece : pieces)
+        retval.append(getPieceText(piece), piece.size);
+    return retval;
+}
+}
+}
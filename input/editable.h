@@ -0,0 +1,101 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INPUT_EDITABLE_H_
+#define INPUT_EDITABLE_H_
+
+#include <string>
+#include <vector>
+#include "text_input.h"
+#include "../util/string_view.h"
+
+namespace quick_shell
+{
+namespace input
+{
+/** input whose text can be edited, for editors; the text is kept in a piece table, so an edit
+ * doesn't copy the text after it.
+ *
+ * After an edit, the input only reads the text again from the start of the edit on, so
+ * iterators, spans and locations before the edit stay valid.
+ * */
+class EditableTextInput final : public TextInput
+{
+private:
+    /** a run of the text that is in `originalText` or `addedText` */
+    struct Piece final
+    {
+        /** the index in the whole text */
+        std::size_t startIndex;
+        std::size_t size;
+        bool isAdded;
+        /** the index in `originalText` or `addedText` */
+        std::size_t sourceIndex;
+        constexpr Piece(std::size_t startIndex,
+                        std::size_t size,
+                        bool isAdded,
+                        std::size_t sourceIndex) noexcept : startIndex(startIndex),
+                                                            size(size),
+                                                            isAdded(isAdded),
+                                                            sourceIndex(sourceIndex)
+        {
+        }
+    };
+
+private:
+    /** more pieces than this are merged back into `originalText` */
+    static constexpr std::size_t maxPieceCount = 1024;
+
+private:
+    std::string originalText;
+    /** the text of all the edits, only ever appended to */
+    std::string addedText;
+    /** sorted by `startIndex`, without empty pieces */
+    std::vector<Piece> pieces;
+    std::size_t textSize;
+
+private:
+    const char *getPieceText(const Piece &piece) const noexcept
+    {
+        return (piece.isAdded ? addedText : originalText).data() + piece.sourceIndex;
+    }
+    /** returns the index of the piece containing `index`, or `pieces.size()` at the end */
+    std::size_t findPiece(std::size_t index) const noexcept;
+    /** makes `index` the start of a piece, unless it's at the end; returns that piece's index */
+    std::size_t splitPiecesAt(std::size_t index);
+    void mergePieces();
+
+protected:
+    virtual std::size_t read(std::size_t startIndex,
+                             unsigned char *buffer,
+                             std::size_t bufferSize) override;
+
+public:
+    EditableTextInput(std::string name,
+                      const TextInputStyle &inputStyle,
+                      util::string_view initialText);
+    std::size_t size() const noexcept
+    {
+        return textSize;
+    }
+    /** replaces the text from `beginIndex` to `endIndex` with `text` */
+    void replace(std::size_t beginIndex, std::size_t endIndex, util::string_view text);
+    /** the current text, copied out of the pieces */
+    std::string getText() const;
+};
+}
+}
+
+#endif /* INPUT_EDITABLE_H_ */
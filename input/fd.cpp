@@ -0,0 +1,85 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fd.h"
+#include <cerrno>
+#include <cassert>
+#include <system_error>
+
+namespace
+{
+/** returns the byte count or -1 with errno set, like `read(2)` */
+inline long readImplementation(int fd, unsigned char *buffer, std::size_t bufferSize) noexcept;
+}
+
+namespace quick_shell
+{
+namespace input
+{
+std::size_t FdTextInput::read(int fd,
+                              std::size_t startIndex,
+                              unsigned char *buffer,
+                              std::size_t bufferSize)
+{
+    assert(bufferSize > 0);
+    while(true)
+    {
+        long readCount = readImplementation(fd, buffer, bufferSize);
+        if(readCount >= 0)
+        {
+            assert(static_cast<std::size_t>(readCount) <= bufferSize);
+            return readCount;
+        }
+        if(errno == EINTR)
+            continue;
+        throw std::system_error(errno, std::generic_category(), "read failed");
+    }
+}
+
+std::size_t FdTextInput::read(std::size_t startIndex, unsigned char *buffer, std::size_t bufferSize)
+{
+    return read(fd, startIndex, buffer, bufferSize);
+}
+}
+}
+
+#if defined(__unix)
+#include <unistd.h>
+#include <limits>
+namespace
+{
+inline long readImplementation(int fd, unsigned char *buffer, std::size_t bufferSize) noexcept
+{
+    if(bufferSize > static_cast<std::size_t>(std::numeric_limits<ssize_t>::max()))
+        bufferSize = std::numeric_limits<ssize_t>::max();
+    return ::read(fd, static_cast<void *>(buffer), bufferSize);
+}
+}
+#elif defined(_WIN32)
+#include <io.h>
+#include <limits>
+namespace
+{
+inline long readImplementation(int fd, unsigned char *buffer, std::size_t bufferSize) noexcept
+{
+    if(bufferSize > static_cast<std::size_t>(std::numeric_limits<int>::max()))
+        bufferSize = std::numeric_limits<int>::max();
+    return _read(fd, static_cast<void *>(buffer), static_cast<unsigned>(bufferSize));
+}
+}
+#else
+#error unimplemented platform
+#endif
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INPUT_FD_H_
+#define INPUT_FD_H_
+
+#include "text_input.h"
+
+namespace quick_shell
+{
+namespace input
+{
+/** reads from a file descriptor with `read(2)` directly into the chunks.
+ *
+ * Doesn't take ownership of the file descriptor.
+ * */
+class FdTextInput final : public TextInput
+{
+private:
+    int fd;
+
+public:
+    /** returns 0 at EOF; retries on `EINTR`; may return less than `bufferSize` bytes.
+     *
+     * throws `std::system_error` on read errors.
+     * */
+    static std::size_t read(int fd,
+                            std::size_t startIndex,
+                            unsigned char *buffer,
+                            std::size_t bufferSize);
+
+protected:
+    virtual std::size_t read(std::size_t startIndex,
+                             unsigned char *buffer,
+                             std::size_t bufferSize) override;
+
+public:
+    FdTextInput(std::string name, const TextInputStyle &inputStyle, int fd, bool retryAfterEOF)
+        : TextInput(std::move(name), inputStyle, retryAfterEOF), fd(fd)
+    {
+    }
+    int getFd() const noexcept
+    {
+        return fd;
+    }
+};
+}
+}
+
+#endif /* INPUT_FD_H_ */
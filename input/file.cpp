@@ -16,7 +16,16 @@
 
 #include "file.h"
 #include "istream.h"
+#include "read_ahead.h"
 #include <fstream>
+#include <vector>
+
+namespace
+{
+/** returns nullptr if the file can't be memory-mapped */
+inline std::shared_ptr<const unsigned char> mapFileImplementation(const std::string &fileName,
+                                                                  std::size_t &mappedSize);
+}
 
 namespace quick_shell
 {
@@ -25,8 +34,19 @@ namespace input
 struct FileTextInput::Implementation final
 {
     std::ifstream is;
-    explicit Implementation(util::string_view fileName) : is()
+    std::shared_ptr<const unsigned char> mappedMemory;
+    std::size_t mappedMemorySize;
+    explicit Implementation(util::string_view fileName, bool useMemoryMapping)
+        : is(), mappedMemory(), mappedMemorySize(0)
     {
+        if(useMemoryMapping)
+        {
+            mappedMemory =
+                mapFileImplementation(static_cast<std::string>(fileName), mappedMemorySize);
+            if(mappedMemory)
+                return;
+            mappedMemorySize = 0;
+        }
         is.exceptions(std::ios::badbit | std::ios::failbit);
         is.open(static_cast<std::string>(fileName), std::ios::in | std::ios::binary);
     }
@@ -36,16 +56,108 @@ std::size_t FileTextInput::read(std::size_t startIndex,
                                 unsigned char *buffer,
                                 std::size_t bufferSize)
 {
+    if(!implementation->is.is_open()) // memory-mapped: all the text is already in the chunks
+        return 0;
     return IStreamTextInput::read(implementation->is, startIndex, buffer, bufferSize);
 }
 
 FileTextInput::FileTextInput(util::string_view name,
-                             util::string_view fileName,
+                             std::shared_ptr<Implementation> implementation,
                              const TextInputStyle &inputStyle,
                              bool retryAfterEOF)
-    : TextInput(static_cast<std::string>(name), inputStyle, retryAfterEOF),
-      implementation(std::make_shared<Implementation>(fileName))
+    : TextInput(static_cast<std::string>(name),
+                inputStyle,
+                implementation->mappedMemory,
+                implementation->mappedMemorySize,
+                std::vector<std::size_t>(),
+                retryAfterEOF),
+      implementation(std::move(implementation))
+{
+    // the chunks keep the mapping alive from now on
+    this->implementation->mappedMemory.reset();
+}
+
+FileTextInput::FileTextInput(util::string_view name,
+                             util::string_view fileName,
+                             const TextInputStyle &inputStyle,
+                             bool retryAfterEOF,
+                             bool useMemoryMapping)
+    : FileTextInput(name,
+                    std::make_shared<Implementation>(fileName, useMemoryMapping && !retryAfterEOF),
+                    inputStyle,
+                    retryAfterEOF)
 {
 }
+
+bool FileTextInput::isMemoryMapped() const noexcept
+{
+    return !implementation->is.is_open();
+}
+
+std::unique_ptr<TextInput> makeFileTextInput(util::string_view fileName,
+                                             const TextInputStyle &inputStyle,
+                                             bool retryAfterEOF,
+                                             bool readAhead)
+{
+    std::unique_ptr<FileTextInput> retval(
+        new FileTextInput(fileName, fileName, inputStyle, retryAfterEOF));
+    if(!readAhead || retval->isMemoryMapped())
+        return std::move(retval);
+    return std::unique_ptr<TextInput>(new ReadAheadTextInput(std::move(retval)));
+}
+}
+}
+
+#if defined(__unix)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits>
+namespace
+{
+inline std::shared_ptr<const unsigned char> mapFileImplementation(const std::string &fileName,
+                                                                  std::size_t &mappedSize)
+{
+    // check before opening: opening a FIFO a second time for the stream would lose its writer
+    struct stat statResult;
+    if(stat(fileName.c_str(), &statResult) != 0 || !S_ISREG(statResult.st_mode))
+        return nullptr; // let the stream report any errors
+    int fd = open(fileName.c_str(), O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+        return nullptr;
+    if(fstat(fd, &statResult) != 0 || !S_ISREG(statResult.st_mode) || statResult.st_size <= 0
+       || static_cast<unsigned long long>(statResult.st_size)
+              > std::numeric_limits<std::size_t>::max())
+    {
+        close(fd);
+        return nullptr;
+    }
+    std::size_t size = statResult.st_size;
+    void *memory = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping stays valid after closing the file
+    if(memory == MAP_FAILED)
+        return nullptr;
+    posix_madvise(memory, size, POSIX_MADV_SEQUENTIAL);
+    // the deleter is also called if allocating the control block fails
+    std::shared_ptr<const unsigned char> retval(static_cast<const unsigned char *>(memory),
+                                                [size](const unsigned char *memory)
+                                                {
+                                                    munmap(const_cast<unsigned char *>(memory),
+                                                           size);
+                                                });
+    mappedSize = size;
+    return retval;
+}
+}
+#else
+namespace
+{
+inline std::shared_ptr<const unsigned char> mapFileImplementation(const std::string &fileName,
+                                                                  std::size_t &mappedSize)
+{
+    return nullptr;
 }
 }
+#endif
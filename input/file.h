@@ -37,18 +37,38 @@ protected:
                              unsigned char *buffer,
                              std::size_t bufferSize) override;
 
+private:
+    FileTextInput(util::string_view name,
+                  std::shared_ptr<Implementation> implementation,
+                  const TextInputStyle &inputStyle,
+                  bool retryAfterEOF);
+
 public:
+    /** if `useMemoryMapping` is set, regular files are memory-mapped and read in place without
+     * copying. Pipes, FIFOs, and other special files, as well as files opened with
+     * `retryAfterEOF` set, are always read through a stream. */
     FileTextInput(util::string_view name,
                   util::string_view fileName,
                   const TextInputStyle &inputStyle = TextInputStyle(),
-                  bool retryAfterEOF = false);
+                  bool retryAfterEOF = false,
+                  bool useMemoryMapping = true);
     explicit FileTextInput(util::string_view name,
                            const TextInputStyle &inputStyle = TextInputStyle(),
-                           bool retryAfterEOF = false)
-        : FileTextInput(name, name, inputStyle, retryAfterEOF)
+                           bool retryAfterEOF = false,
+                           bool useMemoryMapping = true)
+        : FileTextInput(name, name, inputStyle, retryAfterEOF, useMemoryMapping)
     {
     }
+    /** if set, all the text is already in memory and `read` has nothing to do */
+    bool isMemoryMapped() const noexcept;
 };
+
+/** opens `fileName` as a `FileTextInput`. If `readAhead` is set and the file isn't memory-mapped,
+ * like a pipe or FIFO, it is read ahead on a worker thread with `ReadAheadTextInput`. */
+std::unique_ptr<TextInput> makeFileTextInput(util::string_view fileName,
+                                             const TextInputStyle &inputStyle = TextInputStyle(),
+                                             bool retryAfterEOF = false,
+                                             bool readAhead = false);
 }
 }
 
@@ -20,6 +20,7 @@
 #include <string>
 #include <cassert>
 #include <utility>
+#include <cstdint>
 
 namespace quick_shell
 {
@@ -283,6 +284,31 @@ struct LocationSpan : public SimpleLocationSpan
         return a.beginIndex != b.beginIndex || a.endIndex != b.endIndex || a.input != b.input;
     }
 };
+
+/** `SimpleLocationSpan` packed into 8 bytes, for storing in AST nodes when the input is known from
+ * somewhere else; only inputs shorter than 4 GiB can be represented */
+struct CompactLocationSpan final
+{
+    std::uint32_t beginIndex;
+    std::uint32_t length;
+    constexpr CompactLocationSpan() noexcept : beginIndex(0), length(0)
+    {
+    }
+    explicit CompactLocationSpan(const SimpleLocationSpan &locationSpan) noexcept
+        : beginIndex(static_cast<std::uint32_t>(locationSpan.beginIndex)),
+          length(static_cast<std::uint32_t>(locationSpan.size()))
+    {
+        assert(beginIndex == locationSpan.beginIndex && length == locationSpan.size());
+    }
+    constexpr SimpleLocationSpan getSimpleLocationSpan() const noexcept
+    {
+        return SimpleLocationSpan(beginIndex, static_cast<std::size_t>(beginIndex) + length);
+    }
+    constexpr LocationSpan getLocationSpan(TextInput *input) const noexcept
+    {
+        return LocationSpan(getSimpleLocationSpan(), input);
+    }
+};
 }
 }
 
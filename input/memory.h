@@ -41,7 +41,7 @@ public:
                     inputStyle,
                     std::move(memory),
                     memorySize,
-                    std::set<std::size_t>(),
+                    std::vector<std::size_t>(),
                     false)
     {
     }
@@ -49,7 +49,8 @@ public:
                     const TextInputStyle &inputStyle,
                     const unsigned char *memory,
                     std::size_t memorySize)
-        : TextInput(std::move(name), inputStyle, memory, memorySize, std::set<std::size_t>(), false)
+        : TextInput(
+              std::move(name), inputStyle, memory, memorySize, std::vector<std::size_t>(), false)
     {
     }
     MemoryTextInput(std::string name,
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "read_ahead.h"
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <vector>
+#include <cstring>
+#include <algorithm>
+#include <cassert>
+
+namespace quick_shell
+{
+namespace input
+{
+constexpr std::size_t ReadAheadTextInput::defaultReadAheadChunkCount;
+
+/** single-producer/single-consumer ring of buffers.
+ *
+ * The worker thread is the only writer of `writeCount` and of the slots that aren't yet written,
+ * `read` is the only writer of `readCount` and `readOffset`. The mutex is only used for sleeping
+ * when the ring is full or empty.
+ * */
+struct ReadAheadTextInput::Implementation final
+{
+    static constexpr std::size_t slotSize = 4096;
+    struct Slot final
+    {
+        std::unique_ptr<unsigned char[]> buffer;
+        /** 0 for EOF or an error */
+        std::size_t size;
+        std::exception_ptr error;
+        Slot() : buffer(new unsigned char[slotSize]), size(0), error()
+        {
+        }
+    };
+    TextInput &source;
+    /** only used by the worker thread, or by `read` if there's no worker */
+    std::size_t sourceIndex;
+    std::vector<Slot> slots;
+    std::atomic<std::size_t> writeCount;
+    std::atomic<std::size_t> readCount;
+    std::size_t readOffset;
+    std::atomic<bool> stopRequested;
+    std::atomic<bool> workerWaiting;
+    std::atomic<bool> readerWaiting;
+    std::mutex waitMutex;
+    std::condition_variable waitCondition;
+    std::thread worker;
+    Implementation(TextInput &source, std::size_t slotCount)
+        : source(source),
+          sourceIndex(0),
+          slots(slotCount),
+          writeCount(0),
+          readCount(0),
+          readOffset(0),
+          stopRequested(false),
+          workerWaiting(false),
+          readerWaiting(false),
+          waitMutex(),
+          waitCondition(),
+          worker()
+    {
+    }
+    /** reads the next contiguous part of `source` into `buffer`; returns 0 at EOF */
+    std::size_t readSource(unsigned char *buffer, std::size_t bufferSize)
+    {
+        auto span = source.getContiguousSpan(sourceIndex);
+        if(span.empty())
+        {
+            sourceIndex += eofSize;
+            return 0;
+        }
+        std::size_t size = std::min(span.size(), bufferSize);
+        std::memcpy(buffer, span.begin(), size);
+        sourceIndex += size;
+        // we don't need anything already copied, so let the source release it
+        source.setLowWaterMark(sourceIndex);
+        return size;
+    }
+    template <typename Fn>
+    void waitUntil(std::atomic<bool> &waiting, Fn &&isDone)
+    {
+        if(isDone())
+            return;
+        std::unique_lock<std::mutex> lockIt(waitMutex);
+        waiting.store(true);
+        while(!isDone())
+            waitCondition.wait(lockIt);
+        waiting.store(false);
+    }
+    void wake(std::atomic<bool> &waiting)
+    {
+        if(waiting.load())
+        {
+            std::unique_lock<std::mutex> lockIt(waitMutex);
+            waitCondition.notify_all();
+        }
+    }
+    void runWorker() noexcept
+    {
+        while(true)
+        {
+            std::size_t index = writeCount.load(std::memory_order_relaxed);
+            waitUntil(workerWaiting,
+                      [&]()
+                      {
+                          return stopRequested.load()
+                                 || index - readCount.load() < slots.size();
+                      });
+            if(stopRequested.load())
+                return;
+            auto &slot = slots[index % slots.size()];
+            try
+            {
+                slot.size = readSource(slot.buffer.get(), slotSize);
+            }
+            catch(...)
+            {
+                slot.size = 0;
+                slot.error = std::current_exception();
+            }
+            writeCount.store(index + 1);
+            wake(readerWaiting);
+            if(slot.size == 0) // EOF or error: the reader won't get past this slot
+                return;
+        }
+    }
+    std::size_t read(unsigned char *buffer, std::size_t bufferSize)
+    {
+        std::size_t index = readCount.load(std::memory_order_relaxed);
+        waitUntil(readerWaiting,
+                  [&]()
+                  {
+                      return writeCount.load() != index;
+                  });
+        auto &slot = slots[index % slots.size()];
+        if(slot.error)
+            std::rethrow_exception(slot.error);
+        if(slot.size == 0)
+            return 0;
+        assert(readOffset < slot.size);
+        std::size_t size = std::min(slot.size - readOffset, bufferSize);
+        std::memcpy(buffer, slot.buffer.get() + readOffset, size);
+        readOffset += size;
+        if(readOffset == slot.size)
+        {
+            readOffset = 0;
+            readCount.store(index + 1);
+            wake(workerWaiting);
+        }
+        return size;
+    }
+};
+
+constexpr std::size_t ReadAheadTextInput::Implementation::slotSize;
+
+ReadAheadTextInput::ReadAheadTextInput(std::unique_ptr<TextInput> sourceIn,
+                                       std::size_t readAheadChunkCount)
+    : TextInput(sourceIn->getName(), sourceIn->getInputStyle(), sourceIn->getRetryAfterEOF()),
+      source(std::move(sourceIn)),
+      implementation()
+{
+    assert(readAheadChunkCount > 0);
+    implementation.reset(new Implementation(*source, readAheadChunkCount));
+    if(!retryAfterEOF)
+    {
+        auto *implementation = this->implementation.get();
+        implementation->worker = std::thread([implementation]()
+                                             {
+                                                 implementation->runWorker();
+                                             });
+    }
+}
+
+ReadAheadTextInput::~ReadAheadTextInput()
+{
+    if(implementation->worker.joinable())
+    {
+        implementation->stopRequested.store(true);
+        implementation->wake(implementation->workerWaiting);
+        implementation->worker.join();
+    }
+}
+
+std::size_t ReadAheadTextInput::read(std::size_t startIndex,
+                                     unsigned char *buffer,
+                                     std::size_t bufferSize)
+{
+    if(!implementation->worker.joinable())
+        return implementation->readSource(buffer, bufferSize);
+    return implementation->read(buffer, bufferSize);
+}
+}
+}
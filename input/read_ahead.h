@@ -0,0 +1,63 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef INPUT_READ_AHEAD_H_
+#define INPUT_READ_AHEAD_H_
+
+#include <memory>
+
+#include "text_input.h"
+
+namespace quick_shell
+{
+namespace input
+{
+/** reads `source` ahead on a worker thread, so reading from slow sources overlaps with parsing.
+ *
+ * The worker fills a ring of `readAheadChunkCount` buffers that `read` copies out of. If
+ * `source` retries after EOF (interactive input), there is no worker and reads go straight to
+ * `source`, keeping its blocking behavior.
+ * */
+class ReadAheadTextInput final : public TextInput
+{
+private:
+    struct Implementation;
+
+private:
+    std::unique_ptr<TextInput> source;
+    std::unique_ptr<Implementation> implementation;
+
+public:
+    static constexpr std::size_t defaultReadAheadChunkCount = 8;
+
+protected:
+    virtual std::size_t read(std::size_t startIndex,
+                             unsigned char *buffer,
+                             std::size_t bufferSize) override;
+
+public:
+    explicit ReadAheadTextInput(std::unique_ptr<TextInput> source,
+                                std::size_t readAheadChunkCount = defaultReadAheadChunkCount);
+    /** waits for the worker to finish its current read of `source` */
+    ~ReadAheadTextInput();
+    TextInput &getSource() const noexcept
+    {
+        return *source;
+    }
+};
+}
+}
+
+#endif /* INPUT_READ_AHEAD_H_ */
@@ -15,22 +15,28 @@
  */
 
 #include "stdin.h"
-#include "istream.h"
-#include <iostream>
+#include "fd.h"
+#include "read_ahead.h"
 
 namespace
 {
 inline bool isStdInATerminalImplementation() noexcept;
+inline int getStdInFdImplementation() noexcept;
 }
 
 namespace quick_shell
 {
 namespace input
 {
-std::unique_ptr<TextInput> makeStdInTextInput(const TextInputStyle &inputStyle, bool retryAfterEOF)
+std::unique_ptr<TextInput> makeStdInTextInput(const TextInputStyle &inputStyle,
+                                              bool retryAfterEOF,
+                                              bool readAhead)
 {
-    return std::unique_ptr<TextInput>(
-        new IStreamTextInput("stdin", inputStyle, std::cin, retryAfterEOF));
+    std::unique_ptr<TextInput> retval(
+        new FdTextInput("stdin", inputStyle, getStdInFdImplementation(), retryAfterEOF));
+    if(!readAhead || retryAfterEOF)
+        return retval;
+    return std::unique_ptr<TextInput>(new ReadAheadTextInput(std::move(retval)));
 }
 
 bool isStdInATerminal() noexcept
@@ -48,6 +54,10 @@ inline bool isStdInATerminalImplementation() noexcept
 {
     return isatty(STDIN_FILENO);
 }
+inline int getStdInFdImplementation() noexcept
+{
+    return STDIN_FILENO;
+}
 }
 #elif defined(_WIN32)
 #include <io.h>
@@ -58,6 +68,10 @@ inline bool isStdInATerminalImplementation() noexcept
 {
     return _isatty(STDIN_FILENO);
 }
+inline int getStdInFdImplementation() noexcept
+{
+    return _fileno(stdin);
+}
 }
 #else
 #error unimplemented platform
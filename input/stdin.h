@@ -24,7 +24,11 @@ namespace quick_shell
 {
 namespace input
 {
-std::unique_ptr<TextInput> makeStdInTextInput(const TextInputStyle &inputStyle, bool retryAfterEOF);
+/** if `readAhead` is set and `retryAfterEOF` isn't, stdin is read ahead on a worker thread with
+ * `ReadAheadTextInput`, which helps when it is a pipe from a slow command */
+std::unique_ptr<TextInput> makeStdInTextInput(const TextInputStyle &inputStyle,
+                                              bool retryAfterEOF,
+                                              bool readAhead = false);
 bool isStdInATerminal() noexcept;
 }
 }
@@ -16,6 +16,7 @@
 #include <iostream>
 
 #include "text_input.h"
+#include "../util/byte_scan.h"
 
 namespace quick_shell
 {
@@ -31,15 +32,6 @@ std::ostream &operator<<(std::ostream &os, const LineAndColumn &v)
 
 constexpr std::size_t TextInput::eofSize;
 
-TextInput::Chunk::Chunk(std::shared_ptr<unsigned char> memory) : memory(memory.get())
-{
-    freeArg = static_cast<void *>(new std::shared_ptr<unsigned char>(std::move(memory)));
-    freeFn = [](void *freeArg)
-    {
-        delete static_cast<std::shared_ptr<unsigned char> *>(freeArg);
-    };
-}
-
 void TextInput::readTo(std::size_t targetIndex)
 {
 #ifndef NDEBUG
@@ -51,7 +43,7 @@ void TextInput::readTo(std::size_t targetIndex)
     {
         if(!retryAfterEOF && !eofPositions.empty())
             return;
-        std::size_t chunkIndex = validMemorySize / chunkSize;
+        std::size_t chunkIndex = validMemorySize / chunkSize - releasedChunkCount;
         if(chunkIndex >= chunks.size())
             chunks.push_back(Chunk(AllocateTag{}));
         assert(chunkIndex < chunks.size());
@@ -65,7 +57,8 @@ void TextInput::readTo(std::size_t targetIndex)
         assert(readCount <= spaceLeft);
         if(readCount == 0)
         {
-            eofPositions.insert(startIndex);
+            eofPositions.push_back(startIndex);
+            chunk.setHasEOF();
             *memory = '\0';
             validMemorySize++;
         }
@@ -76,47 +69,227 @@ void TextInput::readTo(std::size_t targetIndex)
     }
 }
 
-template <typename Fn>
-void TextInput::updateLineStartIndexesHelper(Fn &&fn)
+std::size_t TextInput::readToEnd()
+{
+    assert(!retryAfterEOF);
+    while(eofPositions.empty())
+        readTo(validMemorySize);
+    updateLineStartIndexes();
+    updateLineContinuationIndexes();
+    return eofPositions.front();
+}
+
+void TextInput::discardFrom(std::size_t index)
+{
+    assert(index >= lowWaterMark);
+    if(index >= validMemorySize)
+        return;
+    validMemorySize = index;
+    eofPositions.erase(std::lower_bound(eofPositions.begin(), eofPositions.end(), index),
+                       eofPositions.end());
+    // keep the chunk containing index, since reading continues in it
+    std::size_t chunkCount = (index + chunkSize - 1) / chunkSize - releasedChunkCount;
+    if(chunkCount < chunks.size())
+        chunks.erase(chunks.begin() + chunkCount, chunks.end());
+    if(index % chunkSize != 0)
+    {
+        getChunk(index).clearHasEOF();
+        markEOFChunks();
+    }
+    // whether a newline or line continuation ends just before index can depend on the text after
+    // it, so rescan from the start of the line before index
+    lineStartIndexes.erase(
+        std::lower_bound(lineStartIndexes.begin(), lineStartIndexes.end(), index),
+        lineStartIndexes.end());
+    std::size_t lineStartIndex = lineStartIndexes.empty() ? lowWaterMark : lineStartIndexes.back();
+    if(validLineStartIndexesIndex > lineStartIndex)
+        validLineStartIndexesIndex = lineStartIndex;
+    // a backslash followed by CRLF is the furthest a line continuation reaches
+    std::size_t lineContinuationIndex = index >= lowWaterMark + 2 ? index - 2 : lowWaterMark;
+    lineContinuationIndexes.erase(std::lower_bound(lineContinuationIndexes.begin(),
+                                                   lineContinuationIndexes.end(),
+                                                   lineContinuationIndex),
+                                  lineContinuationIndexes.end());
+    if(validLineContinuationIndexesIndex > lineContinuationIndex)
+        validLineContinuationIndexesIndex = lineContinuationIndex;
+}
+
+void TextInput::setLowWaterMark(std::size_t index)
+{
+    if(index <= lowWaterMark)
+        return;
+    if(index > validMemorySize)
+        index = validMemorySize;
+    if(index >= validLineStartIndexesIndex)
+        updateLineStartIndexes();
+    auto lineStartIter = std::upper_bound(lineStartIndexes.begin(), lineStartIndexes.end(), index);
+    if(lineStartIter == lineStartIndexes.begin())
+        return;
+    --lineStartIter;
+    if(*lineStartIter <= lowWaterMark)
+        return;
+    lowWaterMark = *lineStartIter;
+    releasedLineStartCount += lineStartIter - lineStartIndexes.begin();
+    lineStartIndexes.erase(lineStartIndexes.begin(), lineStartIter);
+    std::size_t newReleasedChunkCount = lowWaterMark / chunkSize;
+    if(newReleasedChunkCount > releasedChunkCount)
+    {
+        std::size_t releaseCount = newReleasedChunkCount - releasedChunkCount;
+        assert(releaseCount <= chunks.size());
+        chunks.erase(chunks.begin(), chunks.begin() + releaseCount);
+        releasedChunkCount = newReleasedChunkCount;
+    }
+    lineContinuationIndexes.erase(
+        lineContinuationIndexes.begin(),
+        std::lower_bound(
+            lineContinuationIndexes.begin(), lineContinuationIndexes.end(), lowWaterMark));
+    if(validLineContinuationIndexesIndex < lowWaterMark)
+        validLineContinuationIndexesIndex = lowWaterMark;
+    if(retryAfterEOF)
+    {
+        // without retryAfterEOF, the first EOF is needed to know to stop reading
+        eofPositions.erase(eofPositions.begin(),
+                           std::lower_bound(eofPositions.begin(),
+                                            eofPositions.end(),
+                                            releasedChunkCount * chunkSize));
+    }
+}
+
+template <unsigned char... newLineBytes>
+void TextInput::updateLineStartIndexesHelper()
 {
     std::size_t endIndex = validMemorySize;
-    std::size_t startIndex = validLineStartIndexesIndex;
-    assert(endIndex > startIndex);
-    auto iter = iteratorAt(validLineStartIndexesIndex);
-    for(std::size_t i = validLineStartIndexesIndex; i < validMemorySize; i++)
+    std::size_t index = validLineStartIndexesIndex;
+    assert(endIndex > index);
+    // the index of the LF in the last CRLF found, so it isn't counted again
+    std::size_t skipIndex = -1;
+    bool lastCharacterIsPendingCR = false;
+    while(index < endIndex)
     {
-        int ch = *iter;
-        if(i + 1 < validMemorySize)
+        if(isEOFPosition(index))
         {
-            int ch2 = *++iter;
-            if(isNewLinePair(ch, ch2, inputStyle))
-            {
-                fn(i + 2);
-                continue;
-            }
+            lineStartIndexes.push_back(index + 1);
+            index++;
+            continue;
         }
-        if(isNewLine(ch, inputStyle) || ch == eof)
-            fn(i + 1);
+        std::size_t rangeEndIndex = getNextSpecialIndex(index);
+        assert(rangeEndIndex > index);
+        const unsigned char *rangeBegin = &readNonspecial(index);
+        const unsigned char *rangeEnd = &readNonspecial(rangeEndIndex - 1) + 1;
+        util::forEachByteOf<newLineBytes...>(
+            rangeBegin,
+            rangeEnd,
+            [&](const unsigned char *position)
+            {
+                std::size_t newLineIndex = index + (position - rangeBegin);
+                if(*position == '\n')
+                {
+                    if(newLineIndex != skipIndex)
+                        lineStartIndexes.push_back(newLineIndex + 1);
+                    return;
+                }
+                assert(*position == '\r');
+                if(inputStyle.allowCRLFAsNewLine)
+                {
+                    if(newLineIndex + 1 >= endIndex)
+                    {
+                        // we can't tell if it's a CRLF until the next character is read
+                        lastCharacterIsPendingCR = true;
+                        return;
+                    }
+                    if(!isEOFPosition(newLineIndex + 1)
+                       && readNonspecial(newLineIndex + 1) == '\n')
+                    {
+                        lineStartIndexes.push_back(newLineIndex + 2);
+                        skipIndex = newLineIndex + 1;
+                        return;
+                    }
+                }
+                if(inputStyle.allowCRAsNewLine)
+                    lineStartIndexes.push_back(newLineIndex + 1);
+            });
+        index = rangeEndIndex;
     }
     assert(validMemorySize == endIndex); // verify that we haven't read any more
+    validLineStartIndexesIndex = lastCharacterIsPendingCR ? endIndex - 1 : endIndex;
 }
 
 void TextInput::updateLineStartIndexes()
 {
     if(validLineStartIndexesIndex < validMemorySize)
     {
-        std::size_t lineStartIndexCount = lineStartIndexes.size();
-        updateLineStartIndexesHelper([&](std::size_t index)
-                                     {
-                                         lineStartIndexCount++;
-                                     });
-        lineStartIndexes.reserve(lineStartIndexCount);
-        updateLineStartIndexesHelper([&](std::size_t index)
-                                     {
-                                         lineStartIndexes.push_back(index);
-                                     });
-        validLineStartIndexesIndex = validMemorySize;
+        bool scanForCR = inputStyle.allowCRAsNewLine || inputStyle.allowCRLFAsNewLine;
+        bool scanForLF = inputStyle.allowLFAsNewLine;
+        if(scanForCR && scanForLF)
+            updateLineStartIndexesHelper<'\r', '\n'>();
+        else if(scanForCR)
+            updateLineStartIndexesHelper<'\r'>();
+        else if(scanForLF)
+            updateLineStartIndexesHelper<'\n'>();
+        else
+            updateLineStartIndexesHelper<>();
+    }
+}
+
+void TextInput::updateLineContinuationIndexes()
+{
+    std::size_t endIndex = validMemorySize;
+    std::size_t index = validLineContinuationIndexesIndex;
+    // index of a backslash at the end of what's been read so far, that may start a line
+    // continuation depending on what's read next
+    std::size_t pendingIndex = -1;
+    while(index < endIndex && pendingIndex == static_cast<std::size_t>(-1))
+    {
+        if(isEOFPosition(index))
+        {
+            index++;
+            continue;
+        }
+        std::size_t rangeEndIndex = getNextSpecialIndex(index);
+        assert(rangeEndIndex > index);
+        const unsigned char *rangeBegin = &readNonspecial(index);
+        const unsigned char *rangeEnd = &readNonspecial(rangeEndIndex - 1) + 1;
+        for(auto *position = util::findFirstByteOf<'\\'>(rangeBegin, rangeEnd);
+            position != rangeEnd;
+            position = util::findFirstByteOf<'\\'>(position + 1, rangeEnd))
+        {
+            std::size_t backslashIndex = index + (position - rangeBegin);
+            if(backslashIndex + 1 >= endIndex)
+            {
+                pendingIndex = backslashIndex;
+                break;
+            }
+            if(isEOFPosition(backslashIndex + 1))
+                continue;
+            int ch = readNonspecial(backslashIndex + 1);
+            if(ch == '\r')
+            {
+                if(inputStyle.allowCRLFAsNewLine)
+                {
+                    if(backslashIndex + 2 >= endIndex)
+                    {
+                        pendingIndex = backslashIndex;
+                        break;
+                    }
+                    if(!isEOFPosition(backslashIndex + 2)
+                       && readNonspecial(backslashIndex + 2) == '\n')
+                    {
+                        lineContinuationIndexes.push_back(backslashIndex);
+                        continue;
+                    }
+                }
+                if(inputStyle.allowCRAsNewLine)
+                    lineContinuationIndexes.push_back(backslashIndex);
+            }
+            else if(ch == '\n' && inputStyle.allowLFAsNewLine)
+            {
+                lineContinuationIndexes.push_back(backslashIndex);
+            }
+        }
+        index = rangeEndIndex;
     }
+    validLineContinuationIndexesIndex =
+        pendingIndex != static_cast<std::size_t>(-1) ? pendingIndex : endIndex;
 }
 
 constexpr char UnescapingIterator::escapeCharacter;
@@ -20,12 +20,12 @@
 #include <utility>
 #include <memory>
 #include <vector>
-#include <set>
 #include <type_traits>
 #include <cassert>
 #include <iosfwd>
 #include <algorithm>
 #include "location.h"
+#include "../util/byte_scan.h"
 
 namespace quick_shell
 {
@@ -113,6 +113,38 @@ struct LineAndIndex final
     }
 };
 
+/** a contiguous range of bytes in a `TextInput`, for scanning many bytes at once */
+struct ContiguousSpan final
+{
+    const unsigned char *beginPointer;
+    const unsigned char *endPointer;
+    constexpr ContiguousSpan() noexcept : beginPointer(nullptr), endPointer(nullptr)
+    {
+    }
+    constexpr ContiguousSpan(const unsigned char *beginPointer,
+                             const unsigned char *endPointer) noexcept
+        : beginPointer(beginPointer),
+          endPointer(endPointer)
+    {
+    }
+    constexpr const unsigned char *begin() const noexcept
+    {
+        return beginPointer;
+    }
+    constexpr const unsigned char *end() const noexcept
+    {
+        return endPointer;
+    }
+    constexpr std::size_t size() const noexcept
+    {
+        return endPointer - beginPointer;
+    }
+    constexpr bool empty() const noexcept
+    {
+        return endPointer == beginPointer;
+    }
+};
+
 class TextInput
 {
     TextInput(const TextInput &) = delete;
@@ -130,6 +162,15 @@ protected:
 protected:
     const bool retryAfterEOF;
 
+protected:
+    /** forgets the text from `index` on, so it is read again with `read` when it's needed; for
+     * inputs whose text can change. Iterators and spans at or after `index` are invalidated, and
+     * locations there refer to the new text.
+     *
+     * The chunks from `index` on must not be initial text that is used in place.
+     * */
+    void discardFrom(std::size_t index);
+
 private:
     static constexpr std::size_t chunkSize = 4096;
     struct AllocateTag
@@ -143,13 +184,17 @@ private:
         unsigned char *memory;
         void *freeArg;
         FreeFn freeFn;
+        bool containsEOF;
         static void deleteFreeFn(void *memory) noexcept
         {
             delete[] static_cast<unsigned char *>(memory);
         }
 
     public:
-        constexpr Chunk() noexcept : memory(nullptr), freeArg(nullptr), freeFn(nullptr)
+        constexpr Chunk() noexcept : memory(nullptr),
+                                     freeArg(nullptr),
+                                     freeFn(nullptr),
+                                     containsEOF(false)
         {
         }
         explicit Chunk(AllocateTag) : Chunk(new unsigned char[chunkSize])
@@ -157,26 +202,32 @@ private:
         }
         constexpr explicit Chunk(unsigned char *memory) noexcept : memory(memory),
                                                                    freeArg(memory),
-                                                                   freeFn(deleteFreeFn)
+                                                                   freeFn(deleteFreeFn),
+                                                                   containsEOF(false)
         {
         }
         explicit Chunk(unsigned char *memory, FreeFn deleter) noexcept : memory(memory),
                                                                          freeArg(memory),
-                                                                         freeFn(deleter)
+                                                                         freeFn(deleter),
+                                                                         containsEOF(false)
         {
         }
         explicit Chunk(unsigned char *memory, void *freeArg, FreeFn deleter) noexcept
             : memory(memory),
               freeArg(freeArg),
-              freeFn(deleter)
+              freeFn(deleter),
+              containsEOF(false)
         {
         }
-        explicit Chunk(std::shared_ptr<unsigned char> memory);
-        Chunk(Chunk &&rt) noexcept : memory(rt.memory), freeArg(rt.freeArg), freeFn(rt.freeFn)
+        Chunk(Chunk &&rt) noexcept : memory(rt.memory),
+                                     freeArg(rt.freeArg),
+                                     freeFn(rt.freeFn),
+                                     containsEOF(rt.containsEOF)
         {
             rt.memory = nullptr;
             rt.freeArg = nullptr;
             rt.freeFn = nullptr;
+            rt.containsEOF = false;
         }
         ~Chunk()
         {
@@ -189,6 +240,7 @@ private:
             swap(memory, other.memory);
             swap(freeArg, other.freeArg);
             swap(freeFn, other.freeFn);
+            swap(containsEOF, other.containsEOF);
         }
         Chunk &operator=(Chunk rt) noexcept
         {
@@ -213,6 +265,40 @@ private:
         {
             return memory != nullptr;
         }
+        /** true if any position in this chunk is an EOF, so chunks without one can skip looking
+         * at `eofPositions` */
+        bool hasEOF() const noexcept
+        {
+            return containsEOF;
+        }
+        void setHasEOF() noexcept
+        {
+            containsEOF = true;
+        }
+        void clearHasEOF() noexcept
+        {
+            containsEOF = false;
+        }
+    };
+    /** keeps initial text passed in as a `std::shared_ptr` alive until the last chunk pointing
+     * into it is destroyed, without needing a separate allocation per chunk */
+    struct SharedMemory final
+    {
+        std::shared_ptr<const unsigned char> memory;
+        std::size_t referenceCount;
+        explicit SharedMemory(std::shared_ptr<const unsigned char> memory,
+                              std::size_t referenceCount) noexcept
+            : memory(std::move(memory)),
+              referenceCount(referenceCount)
+        {
+        }
+        static void release(void *sharedMemory) noexcept
+        {
+            auto *self = static_cast<SharedMemory *>(sharedMemory);
+            assert(self->referenceCount > 0);
+            if(--self->referenceCount == 0)
+                delete self;
+        }
     };
 
 private:
@@ -220,7 +306,8 @@ private:
     std::string name;
     std::vector<Chunk> chunks;
     std::size_t validMemorySize;
-    std::set<std::size_t> eofPositions;
+    /** sorted; EOF positions are only ever added at the end of the valid memory */
+    std::vector<std::size_t> eofPositions;
 
     /** doesn't have first line to save memory */
     std::vector<std::size_t> lineStartIndexes;
@@ -228,22 +315,56 @@ private:
     /** index where all line start indexes before are in lineStartIndexes */
     std::size_t validLineStartIndexesIndex;
 
+    /** indexes of the backslashes that start line continuations */
+    std::vector<std::size_t> lineContinuationIndexes;
+
+    /** index where all line continuations before are in lineContinuationIndexes */
+    std::size_t validLineContinuationIndexesIndex;
+
+    /** start of the first line that is still kept; see `setLowWaterMark` */
+    std::size_t lowWaterMark;
+    /** number of chunks released from the front of `chunks` */
+    std::size_t releasedChunkCount;
+    /** number of entries released from the front of `lineStartIndexes` */
+    std::size_t releasedLineStartCount;
+
 private:
+    /** returns the chunk containing `index` */
+    Chunk &getChunk(std::size_t index) noexcept
+    {
+        assert(index >= releasedChunkCount * chunkSize);
+        return chunks[index / chunkSize - releasedChunkCount];
+    }
+    const Chunk &getChunk(std::size_t index) const noexcept
+    {
+        assert(index >= releasedChunkCount * chunkSize);
+        return chunks[index / chunkSize - releasedChunkCount];
+    }
     std::size_t getNextEOF(std::size_t index) const
     {
-        auto iter = eofPositions.lower_bound(index);
+        auto iter = std::lower_bound(eofPositions.begin(), eofPositions.end(), index);
         if(iter == eofPositions.end())
             return -1;
         return *iter;
     }
+    bool isEOFPosition(std::size_t index) const
+    {
+        assert(index < validMemorySize);
+        if(!getChunk(index).hasEOF())
+            return false;
+        return std::binary_search(eofPositions.begin(), eofPositions.end(), index);
+    }
     std::size_t getNextSpecialIndex(std::size_t index) const
     {
-        std::size_t retval = getNextEOF(index);
+        std::size_t retval = (index / chunkSize) * chunkSize + chunkSize;
         if(retval > validMemorySize)
             retval = validMemorySize;
-        std::size_t nextChunkStartIndex = (index / chunkSize) * chunkSize + chunkSize;
-        if(retval > nextChunkStartIndex)
-            retval = nextChunkStartIndex;
+        if(retval > index && getChunk(index).hasEOF())
+        {
+            std::size_t nextEOF = getNextEOF(index);
+            if(retval > nextEOF)
+                retval = nextEOF;
+        }
         if(retval < index)
             retval = index;
         return retval;
@@ -251,12 +372,22 @@ private:
     unsigned char &readNonspecial(std::size_t index) const noexcept
     {
         assert(index < validMemorySize);
-        return chunks[index / chunkSize][index % chunkSize];
+        return getChunk(index)[index % chunkSize];
     }
     void readTo(std::size_t targetIndex);
+    void markEOFChunks() noexcept
+    {
+        assert(std::is_sorted(eofPositions.begin(), eofPositions.end()));
+        for(std::size_t eofPosition : eofPositions)
+        {
+            assert(eofPosition < validMemorySize);
+            getChunk(eofPosition).setHasEOF();
+        }
+    }
     void updateLineStartIndexes();
-    template <typename Fn>
-    void updateLineStartIndexesHelper(Fn &&fn);
+    template <unsigned char... newLineBytes>
+    void updateLineStartIndexesHelper();
+    void updateLineContinuationIndexes();
 
 public:
     explicit TextInput(
@@ -264,7 +395,7 @@ public:
         const TextInputStyle &inputStyle,
         std::shared_ptr<const unsigned char> memory, // initial text, appended to by read
         std::size_t memorySize,
-        std::set<std::size_t> eofPositions, // EOF positions for initial text
+        std::vector<std::size_t> eofPositions, // sorted EOF positions for initial text
         bool retryAfterEOF)
         : retryAfterEOF(retryAfterEOF),
           inputStyle(inputStyle),
@@ -273,14 +404,27 @@ public:
           validMemorySize(memorySize),
           eofPositions(std::move(eofPositions)),
           lineStartIndexes(),
-          validLineStartIndexesIndex()
+          validLineStartIndexesIndex(),
+          lineContinuationIndexes(),
+          validLineContinuationIndexesIndex(),
+          lowWaterMark(0),
+          releasedChunkCount(0),
+          releasedLineStartCount(0)
     {
         assert(memorySize == 0 || memory != nullptr);
         chunks.reserve((memorySize + chunkSize - 1) / chunkSize);
-        for(std::size_t i = 0; i + 1 < memorySize / chunkSize; i++)
+        std::size_t fullChunkCount = memorySize / chunkSize;
+        if(fullChunkCount > 0)
         {
-            chunks.push_back(Chunk(std::shared_ptr<unsigned char>(
-                memory, const_cast<unsigned char *>(memory.get() + i * chunkSize))));
+            // full chunks are used in place; the last partial chunk is copied since read appends
+            // to it
+            auto *sharedMemory = new SharedMemory(memory, fullChunkCount);
+            for(std::size_t i = 0; i < fullChunkCount; i++)
+            {
+                chunks.push_back(Chunk(const_cast<unsigned char *>(memory.get() + i * chunkSize),
+                                       static_cast<void *>(sharedMemory),
+                                       SharedMemory::release));
+            }
         }
         std::size_t sizeLeft = memorySize % chunkSize;
         if(sizeLeft)
@@ -291,12 +435,14 @@ public:
                 lastChunk[i] = source[i];
             chunks.push_back(std::move(lastChunk));
         }
+        markEOFChunks();
     }
     explicit TextInput(std::string name,
                        const TextInputStyle &inputStyle,
                        const unsigned char *memory, // initial text, appended to by read
                        std::size_t memorySize,
-                       std::set<std::size_t> eofPositions, // EOF positions for initial text
+                       std::vector<std::size_t> eofPositions, // sorted EOF positions
+                                                              // for initial text
                        bool retryAfterEOF)
         : retryAfterEOF(retryAfterEOF),
           inputStyle(inputStyle),
@@ -305,16 +451,21 @@ public:
           validMemorySize(memorySize),
           eofPositions(std::move(eofPositions)),
           lineStartIndexes(),
-          validLineStartIndexesIndex()
+          validLineStartIndexesIndex(),
+          lineContinuationIndexes(),
+          validLineContinuationIndexesIndex(),
+          lowWaterMark(0),
+          releasedChunkCount(0),
+          releasedLineStartCount(0)
     {
         assert(memorySize == 0 || memory != nullptr);
         chunks.reserve((memorySize + chunkSize - 1) / chunkSize);
-        for(std::size_t i = 0; i + 1 < memorySize / chunkSize; i++)
+        for(std::size_t i = 0; i < memorySize / chunkSize; i++)
         {
             auto chunk = Chunk(AllocateTag{});
             const unsigned char *source = memory + i * chunkSize;
             for(std::size_t j = 0; j < chunkSize; j++)
-                chunk[i] = source[i];
+                chunk[j] = source[j];
             chunks.push_back(std::move(chunk));
         }
         std::size_t sizeLeft = memorySize % chunkSize;
@@ -326,9 +477,11 @@ public:
                 lastChunk[i] = source[i];
             chunks.push_back(std::move(lastChunk));
         }
+        markEOFChunks();
     }
     explicit TextInput(std::string name, const TextInputStyle &inputStyle, bool retryAfterEOF)
-        : TextInput(std::move(name), inputStyle, nullptr, 0, std::set<std::size_t>(), retryAfterEOF)
+        : TextInput(
+              std::move(name), inputStyle, nullptr, 0, std::vector<std::size_t>(), retryAfterEOF)
     {
     }
     virtual ~TextInput() = default;
@@ -344,6 +497,10 @@ public:
     {
         name = newName;
     }
+    bool getRetryAfterEOF() const noexcept
+    {
+        return retryAfterEOF;
+    }
     const TextInputStyle &getInputStyle() const noexcept
     {
         return inputStyle;
@@ -353,51 +510,128 @@ public:
         if(inputStyle == newInputStyle)
             return;
         inputStyle = newInputStyle;
-        lineStartIndexes.clear();
-        validLineStartIndexesIndex = 0;
+        // line starts before the low-water mark were already released, so keep them as is
+        lineStartIndexes.erase(
+            std::upper_bound(lineStartIndexes.begin(), lineStartIndexes.end(), lowWaterMark),
+            lineStartIndexes.end());
+        validLineStartIndexesIndex = lowWaterMark;
+        lineContinuationIndexes.clear();
+        validLineContinuationIndexesIndex = lowWaterMark;
+    }
+    /** declares that nothing before `index` will be accessed again, for bounded memory use when
+     * reading endless input.
+     *
+     * The chunks and line starts before the start of the line containing `index` are released.
+     * Line numbers stay correct, and iterators, locations and line/column lookups at or after the
+     * start of that line stay valid. Lowering the mark has no effect.
+     * */
+    void setLowWaterMark(std::size_t index);
+    std::size_t getLowWaterMark() const noexcept
+    {
+        return lowWaterMark;
+    }
+    /** the index up to which text has been read with `read`. Iterators, spans and lookups only
+     * look at text before it, so it bounds how far anything has looked since the text from there
+     * on was last discarded. */
+    std::size_t getReadEndIndex() const noexcept
+    {
+        return validMemorySize;
     }
+    /** reads the rest of the input and finishes the line start and line continuation tables,
+     * then returns the index of the first EOF. The input must not have `retryAfterEOF` set.
+     *
+     * Afterwards, reading the input through iterators and looking up lines doesn't change the
+     * `TextInput`, so it is safe from several threads at once, as long as nothing calls
+     * `setInputStyle` or `setLowWaterMark` in the meantime.
+     * */
+    std::size_t readToEnd();
     LineAndIndex getLineAndStartIndex(std::size_t index)
     {
+        assert(index >= lowWaterMark);
         if(index >= validMemorySize)
         {
-            if(!retryAfterEOF && !eofPositions.empty() && index >= *eofPositions.begin())
+            if(!retryAfterEOF && !eofPositions.empty() && index >= eofPositions.front())
             {
                 updateLineStartIndexes();
                 std::size_t lastLineStart = lineStartIndexes.empty() ? 0 : lineStartIndexes.back();
-                return LineAndIndex(lineStartIndexes.size() + 1 + index - lastLineStart, index);
+                return LineAndIndex(
+                    releasedLineStartCount + lineStartIndexes.size() + 1 + index - lastLineStart,
+                    index);
             }
             readTo(index);
             if(index >= validMemorySize)
             {
                 updateLineStartIndexes();
                 std::size_t lastLineStart = lineStartIndexes.empty() ? 0 : lineStartIndexes.back();
-                return LineAndIndex(lineStartIndexes.size() + 1 + index - lastLineStart, index);
+                return LineAndIndex(
+                    releasedLineStartCount + lineStartIndexes.size() + 1 + index - lastLineStart,
+                    index);
             }
         }
         if(index >= validLineStartIndexesIndex)
             updateLineStartIndexes();
-        std::size_t line =
-            1 + lineStartIndexes.size()
+        std::size_t lineStartIndexesIndex =
+            lineStartIndexes.size()
             + (lineStartIndexes.rbegin() - std::lower_bound(lineStartIndexes.rbegin(),
                                                             lineStartIndexes.rend(),
                                                             index,
                                                             std::greater<std::size_t>()));
-        return LineAndIndex(line, line <= 1 ? 0 : lineStartIndexes[line - 2]);
+        std::size_t line = 1 + releasedLineStartCount + lineStartIndexesIndex;
+        return LineAndIndex(line, line <= 1 ? 0 : lineStartIndexes[lineStartIndexesIndex - 1]);
+    }
+    /** returns the first index at or after `index` that may start a line continuation: either a
+     * backslash that starts a line continuation or the first position that hasn't been read and
+     * checked yet. */
+    std::size_t getNextPossibleLineContinuationIndex(std::size_t index)
+    {
+        if(index >= validLineContinuationIndexesIndex)
+        {
+            updateLineContinuationIndexes();
+            if(index >= validLineContinuationIndexesIndex)
+                return index;
+        }
+        auto iter =
+            std::lower_bound(lineContinuationIndexes.begin(), lineContinuationIndexes.end(), index);
+        if(iter == lineContinuationIndexes.end())
+            return validLineContinuationIndexesIndex;
+        return *iter;
     }
     int operator[](std::size_t index)
     {
         if(index >= validMemorySize)
         {
-            if(!retryAfterEOF && !eofPositions.empty() && index >= *eofPositions.begin())
+            if(!retryAfterEOF && !eofPositions.empty() && index >= eofPositions.front())
                 return eof;
             readTo(index);
             if(index >= validMemorySize)
                 return eof;
         }
-        if(eofPositions.count(index) != 0)
+        if(isEOFPosition(index))
             return eof;
         return readNonspecial(index);
     }
+    /** returns the largest contiguous range of bytes starting at `index`, reading more input if
+     * needed.
+     *
+     * The range stops before the next EOF or chunk boundary, so it is empty only if `index` is at
+     * an EOF. The bytes stay valid until `setLowWaterMark` releases the chunk they are in, or
+     * until `discardFrom` discards them.
+     * */
+    ContiguousSpan getContiguousSpan(std::size_t index)
+    {
+        if(index >= validMemorySize)
+        {
+            if(!retryAfterEOF && !eofPositions.empty() && index >= eofPositions.front())
+                return ContiguousSpan();
+            readTo(index);
+            if(index >= validMemorySize)
+                return ContiguousSpan();
+        }
+        std::size_t nextSpecialIndex = getNextSpecialIndex(index);
+        if(nextSpecialIndex == index)
+            return ContiguousSpan();
+        return ContiguousSpan(&readNonspecial(index), &readNonspecial(nextSpecialIndex - 1) + 1);
+    }
     /** iterator for TextInput.
      *
      * Never reaches `TextInput::end()`; `operator*()` will just keep returning `input::eof`
@@ -489,6 +723,38 @@ public:
             operator++();
             return retval;
         }
+        /** moves forward by `count` positions */
+        Iterator &advance(std::size_t count)
+        {
+            assert(input);
+            if(count < static_cast<std::size_t>(rangeEnd - rangeCurrent))
+            {
+                index += count;
+                rangeCurrent += count;
+                value = *rangeCurrent;
+            }
+            else if(count != 0)
+            {
+                *this = Iterator(input, index + count);
+            }
+            return *this;
+        }
+        /** returns the contiguous bytes starting at this iterator; see
+         * `TextInput::getContiguousSpan` */
+        ContiguousSpan getContiguousSpan()
+        {
+            assert(input);
+            if(rangeCurrent == rangeEnd)
+            {
+                auto span = input->getContiguousSpan(index);
+                if(span.empty())
+                    return span;
+                rangeCurrent = span.begin();
+                rangeEnd = span.end();
+                value = *rangeCurrent;
+            }
+            return ContiguousSpan(rangeCurrent, rangeEnd);
+        }
         bool operator==(const Iterator &rt) const noexcept
         {
             return index == rt.index;
@@ -646,9 +912,12 @@ public:
 private:
     mutable TextInput::Iterator iter;
     mutable bool isAtValidLocation;
+    /** there are no line continuations from `iter` up to this index */
+    mutable std::size_t nextPossibleLineContinuationIndex;
     void moveToValidLocation() const
     {
-        auto textInputStyle = iter.getLocation().input->getInputStyle();
+        auto *input = iter.getLocation().input;
+        auto textInputStyle = input->getInputStyle();
         while(*iter == '\\')
         {
             auto iter2 = iter;
@@ -681,16 +950,21 @@ private:
             }
             break;
         }
+        nextPossibleLineContinuationIndex = input->getNextPossibleLineContinuationIndex(
+            iter.getIndex() + (*iter == '\\' ? 1 : 0));
         isAtValidLocation = true;
     }
 
 public:
     explicit LineContinuationRemovingIterator(const TextInput::Iterator &iter) noexcept
         : iter(iter),
-          isAtValidLocation(false)
+          isAtValidLocation(false),
+          nextPossibleLineContinuationIndex(0)
     {
     }
-    LineContinuationRemovingIterator() noexcept : iter(), isAtValidLocation(true)
+    LineContinuationRemovingIterator() noexcept : iter(),
+                                                  isAtValidLocation(true),
+                                                  nextPossibleLineContinuationIndex(0)
     {
     }
     const int *operator->() const
@@ -710,7 +984,7 @@ public:
         if(!isAtValidLocation)
             moveToValidLocation();
         ++iter;
-        isAtValidLocation = false;
+        isAtValidLocation = iter.getIndex() < nextPossibleLineContinuationIndex;
         return *this;
     }
     LineContinuationRemovingIterator operator++(int)
@@ -719,6 +993,33 @@ public:
         operator++();
         return retval;
     }
+    /** returns the contiguous bytes starting at this iterator that contain no line continuations.
+     *
+     * The span stops before any backslash after the first byte, since it may start a line
+     * continuation, so it can be empty only at an EOF.
+     * */
+    ContiguousSpan getContiguousSpan() const
+    {
+        if(!isAtValidLocation)
+            moveToValidLocation();
+        auto span = iter.getContiguousSpan();
+        if(span.empty())
+            return span;
+        return ContiguousSpan(span.begin(),
+                              util::findFirstByteOf<'\\'>(span.begin() + 1, span.end()));
+    }
+    /** moves forward by `count` positions, which must be no more than the size of the span
+     * returned by `getContiguousSpan` */
+    LineContinuationRemovingIterator &advance(std::size_t count)
+    {
+        if(count == 0)
+            return *this;
+        if(!isAtValidLocation)
+            moveToValidLocation();
+        iter.advance(count);
+        isAtValidLocation = iter.getIndex() < nextPossibleLineContinuationIndex;
+        return *this;
+    }
     bool operator==(const LineContinuationRemovingIterator &rt) const
     {
         if(iter == rt.iter)
@@ -32,6 +32,7 @@ int main()
     input::FileTextInput ti("test.sh");
 #endif
     util::Arena arena;
-    parser::Parser parser(ti, arena, parser::ParserDialect::getBashDialect());
+    util::SymbolTable symbolTable;
+    parser::Parser parser(ti, arena, symbolTable, parser::ParserDialect::getBashDialect());
     parser.test();
 }
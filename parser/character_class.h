@@ -0,0 +1,181 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PARSER_CHARACTER_CLASS_H_
+#define PARSER_CHARACTER_CLASS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include "../input/text_input.h"
+#include "../util/type_traits.h"
+
+namespace quick_shell
+{
+namespace parser
+{
+/** bits for the lexical classes of a character */
+struct CharacterClass final
+{
+    typedef std::uint16_t Bits;
+    static constexpr Bits blank = 0x1;
+    /** a newline by itself */
+    static constexpr Bits newLine = 0x2;
+    /** a CR that is a newline only if followed by a LF; the other bits are for when it isn't */
+    static constexpr Bits crlfStart = 0x4;
+    /** blank, newline, or one of `|&;()<>` */
+    static constexpr Bits metacharacter = 0x8;
+    static constexpr Bits eof = 0x10;
+    static constexpr Bits nameStart = 0x20;
+    static constexpr Bits nameContinue = 0x40;
+    static constexpr Bits simpleWordStart = 0x80;
+    static constexpr Bits simpleWordContinue = 0x100;
+    /** can start a word, except that a backquote can't when nested in backquotes */
+    static constexpr Bits wordStart = 0x200;
+    /** metacharacter or EOF; a backquote also ends a word when nested in backquotes */
+    static constexpr Bits unquotedWordEnd = 0x400;
+    /** the bits for a CR followed by a LF when `crlfStart` is set */
+    static constexpr Bits crlfNewLine = newLine | metacharacter | unquotedWordEnd;
+
+    static constexpr bool isBlank(int ch) noexcept
+    {
+        return ch == ' ' || ch == '\t';
+    }
+    static constexpr bool isNewLine(int ch,
+                                    bool allowCRAsNewLine,
+                                    bool allowLFAsNewLine) noexcept
+    {
+        return (ch == '\r' && allowCRAsNewLine) || (ch == '\n' && allowLFAsNewLine);
+    }
+    static constexpr bool isMetacharacter(int ch,
+                                          bool allowCRAsNewLine,
+                                          bool allowLFAsNewLine) noexcept
+    {
+        return ch == '|' || ch == '&' || ch == ';' || ch == '(' || ch == ')' || ch == '<'
+               || ch == '>' || isBlank(ch) || isNewLine(ch, allowCRAsNewLine, allowLFAsNewLine);
+    }
+    static constexpr bool isNameStart(int ch) noexcept
+    {
+        return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_';
+    }
+    static constexpr bool isNameContinue(int ch) noexcept
+    {
+        return isNameStart(ch) || (ch >= '0' && ch <= '9');
+    }
+    static constexpr bool isSimpleWordContinue(int ch,
+                                               bool allowCRAsNewLine,
+                                               bool allowLFAsNewLine) noexcept
+    {
+        return ch != input::eof && ch != '\"' && ch != '\'' && ch != '!' && ch != '$'
+               && ch != '`' && ch != '\\'
+               && !isMetacharacter(ch, allowCRAsNewLine, allowLFAsNewLine);
+    }
+    static constexpr bool isSimpleWordStart(int ch,
+                                            bool allowCRAsNewLine,
+                                            bool allowLFAsNewLine) noexcept
+    {
+        return ch != '#' && isSimpleWordContinue(ch, allowCRAsNewLine, allowLFAsNewLine);
+    }
+    static constexpr Bits classify(int ch,
+                                   bool allowCRLFAsNewLine,
+                                   bool allowCRAsNewLine,
+                                   bool allowLFAsNewLine) noexcept
+    {
+        return static_cast<Bits>(
+            (isBlank(ch) ? blank : 0)
+            | (isNewLine(ch, allowCRAsNewLine, allowLFAsNewLine) ? newLine : 0)
+            | (ch == '\r' && allowCRLFAsNewLine && !allowCRAsNewLine ? crlfStart : 0)
+            | (isMetacharacter(ch, allowCRAsNewLine, allowLFAsNewLine) ? metacharacter : 0)
+            | (ch == input::eof ? eof : 0)
+            | (isNameStart(ch) ? nameStart : 0)
+            | (isNameContinue(ch) ? nameContinue : 0)
+            | (isSimpleWordStart(ch, allowCRAsNewLine, allowLFAsNewLine) ? simpleWordStart : 0)
+            | (isSimpleWordContinue(ch, allowCRAsNewLine, allowLFAsNewLine) ? simpleWordContinue :
+                                                                              0)
+            | (isSimpleWordStart(ch, allowCRAsNewLine, allowLFAsNewLine) || ch == '\"'
+                       || ch == '\'' || ch == '!' || ch == '$' || ch == '`' || ch == '\\' ?
+                   wordStart :
+                   0)
+            | (ch == input::eof || isMetacharacter(ch, allowCRAsNewLine, allowLFAsNewLine) ?
+                   unquotedWordEnd :
+                   0));
+    }
+};
+
+static_assert(input::eof == -1, "character class tables assume EOF is just before byte 0");
+
+/** `CharacterClass` bits for EOF and every byte, for one combination of the newline options in
+ * `input::TextInputStyle`. Index with `ch - input::eof`. */
+template <bool allowCRLFAsNewLine,
+          bool allowCRAsNewLine,
+          bool allowLFAsNewLine,
+          typename Indexes = util::MakeIndexSequence<257>::type>
+struct CharacterClassTable;
+
+template <bool allowCRLFAsNewLine,
+          bool allowCRAsNewLine,
+          bool allowLFAsNewLine,
+          std::size_t... indexes>
+struct CharacterClassTable<allowCRLFAsNewLine,
+                           allowCRAsNewLine,
+                           allowLFAsNewLine,
+                           util::IndexSequence<indexes...>>
+    final
+{
+    static constexpr CharacterClass::Bits table[sizeof...(indexes)] = {
+        CharacterClass::classify(static_cast<int>(indexes) + input::eof,
+                                 allowCRLFAsNewLine,
+                                 allowCRAsNewLine,
+                                 allowLFAsNewLine)...};
+};
+
+template <bool allowCRLFAsNewLine,
+          bool allowCRAsNewLine,
+          bool allowLFAsNewLine,
+          std::size_t... indexes>
+constexpr CharacterClass::Bits CharacterClassTable<allowCRLFAsNewLine,
+                                                   allowCRAsNewLine,
+                                                   allowLFAsNewLine,
+                                                   util::IndexSequence<indexes...>>::
+    table[sizeof...(indexes)];
+
+inline const CharacterClass::Bits *getCharacterClassTable(
+    const input::TextInputStyle &textInputStyle) noexcept
+{
+    if(textInputStyle.allowCRLFAsNewLine)
+    {
+        if(textInputStyle.allowCRAsNewLine)
+        {
+            if(textInputStyle.allowLFAsNewLine)
+                return CharacterClassTable<true, true, true>::table;
+            return CharacterClassTable<true, true, false>::table;
+        }
+        if(textInputStyle.allowLFAsNewLine)
+            return CharacterClassTable<true, false, true>::table;
+        return CharacterClassTable<true, false, false>::table;
+    }
+    if(textInputStyle.allowCRAsNewLine)
+    {
+        if(textInputStyle.allowLFAsNewLine)
+            return CharacterClassTable<false, true, true>::table;
+        return CharacterClassTable<false, true, false>::table;
+    }
+    if(textInputStyle.allowLFAsNewLine)
+        return CharacterClassTable<false, false, true>::table;
+    return CharacterClassTable<false, false, false>::table;
+}
+}
+}
+
+#endif /* PARSER_CHARACTER_CLASS_H_ */
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "incremental_parser.h"
+#include <algorithm>
+#include <iterator>
+
+namespace quick_shell
+{
+namespace parser
+{
+IncrementalParser::IncrementalParser(input::EditableTextInput &textInput,
+                                     util::SymbolTable &symbolTable,
+                                     const ParserDialect &dialect)
+    : textInput(textInput), symbolTable(symbolTable), dialect(dialect), items()
+{
+    reparse(0, 0, 0);
+}
+
+void IncrementalParser::reparse(std::size_t beginIndex,
+                                std::size_t oldEndIndex,
+                                std::size_t newSize)
+{
+    std::size_t removedSize = oldEndIndex - beginIndex;
+    // an item can change if its parse looked at the edited text
+    std::size_t firstItemIndex = std::find_if(items.begin(),
+                                              items.end(),
+                                              [&](const TopLevelItem &item)
+                                              {
+                                                  return item.readEndIndex > beginIndex;
+                                              })
+                                 - items.begin();
+    std::size_t index = 0;
+    if(firstItemIndex < items.size())
+        index = items[firstItemIndex].location.beginIndex;
+    else if(!items.empty())
+        index = items.back().location.endIndex;
+    auto arena = std::make_shared<util::Arena>();
+    Parser parser(textInput, *arena, symbolTable, dialect);
+    parser.setTopLevelIndex(index);
+    std::vector<TopLevelItem> newItems;
+    std::size_t oldItemIndex = firstItemIndex;
+    bool isAfterError = false;
+    for(;;)
+    {
+        // the text from the start of an old item after the edit on hasn't changed, so once a new
+        // item ends where one of those starts, the rest of the old items are still right
+        while(oldItemIndex < items.size()
+              && (items[oldItemIndex].location.beginIndex < oldEndIndex
+                  || items[oldItemIndex].location.beginIndex - removedSize + newSize < index))
+            oldItemIndex++;
+        // error recovery resumes at the next line, which needn't be where the old items were
+        // split, so only a command ending there is a real match
+        if(!isAfterError && oldItemIndex < items.size()
+           && items[oldItemIndex].location.beginIndex - removedSize + newSize == index)
+            break;
+        util::ArenaPtr<ast::Command> command;
+        std::shared_ptr<const ParseError> error;
+        try
+        {
+            if(parser.parseTopLevelCommand(command) == ParseCommandResult::Quit)
+            {
+                oldItemIndex = items.size();
+                break;
+            }
+        }
+        catch(ParseError &v)
+        {
+            error = std::make_shared<const ParseError>(v);
+        }
+        std::size_t endIndex = parser.getTopLevelIndex();
+        // a command reads no further than the byte after it, but a syntax error can be found
+        // anywhere after reading ahead, so only the input's read position bounds it
+        std::size_t readEndIndex = endIndex + 1;
+        isAfterError = error != nullptr;
+        if(isAfterError)
+            readEndIndex = std::max(readEndIndex, textInput.getReadEndIndex());
+        newItems.push_back(TopLevelItem(input::SimpleLocationSpan(index, endIndex),
+                                        command,
+                                        std::move(error),
+                                        readEndIndex,
+                                        arena));
+        index = endIndex;
+    }
+    for(std::size_t i = oldItemIndex; i < items.size(); i++)
+    {
+        auto &item = items[i];
+        item.location = input::SimpleLocationSpan(item.location.beginIndex - removedSize + newSize,
+                                                  item.location.endIndex - removedSize + newSize);
+        item.readEndIndex = item.readEndIndex - removedSize + newSize;
+        item.indexOffset += static_cast<std::ptrdiff_t>(newSize)
+                            - static_cast<std::ptrdiff_t>(removedSize);
+    }
+    items.erase(items.begin() + firstItemIndex, items.begin() + oldItemIndex);
+    items.insert(items.begin() + firstItemIndex,
+                 std::make_move_iterator(newItems.begin()),
+                 std::make_move_iterator(newItems.end()));
+}
+}
+}
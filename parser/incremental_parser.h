@@ -0,0 +1,117 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PARSER_INCREMENTAL_PARSER_H_
+#define PARSER_INCREMENTAL_PARSER_H_
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "parser.h"
+#include "../input/editable.h"
+
+namespace quick_shell
+{
+namespace parser
+{
+/** keeps the top-level commands of an `input::EditableTextInput` parsed as it's edited, for
+ * editors and language servers.
+ *
+ * An edit only reparses the top-level commands from the first one whose parse read the edited
+ * text up to where the commands line up with the old ones again; the commands before and after
+ * that are kept.
+ * */
+class IncrementalParser final
+{
+    IncrementalParser(const IncrementalParser &) = delete;
+    IncrementalParser &operator=(const IncrementalParser &) = delete;
+
+public:
+    /** the result of one call to `Parser::parseTopLevelCommand`: a command, a blank or comment
+     * line, or a line with a syntax error */
+    struct TopLevelItem final
+    {
+        /** the text in the current input, up to and including the newline that ends it and
+         * the here-document bodies after that newline */
+        input::SimpleLocationSpan location;
+        /** null for blank and comment lines and syntax errors */
+        util::ArenaPtr<ast::Command> command;
+        /** null unless there's a syntax error */
+        std::shared_ptr<const ParseError> error;
+        /** the end of the text the parse could have looked at, in the current input. It's past
+         * `location.endIndex`, since how an item ends can depend on the byte after it, and for
+         * syntax errors it can be much further, like for a quote that isn't closed. */
+        std::size_t readEndIndex;
+        /** added to the indexes in `command` and `error` to get indexes in the current input.
+         *
+         * Items after an edit are kept as is, so this is the total size change of the edits
+         * before them since they were parsed. Locations in the AST still point to the input,
+         * but their indexes and line numbers are from when the item was parsed. */
+        std::ptrdiff_t indexOffset;
+        /** the arena `command` is in; shared by the items parsed together */
+        std::shared_ptr<util::Arena> arena;
+        TopLevelItem(input::SimpleLocationSpan location,
+                     util::ArenaPtr<ast::Command> command,
+                     std::shared_ptr<const ParseError> error,
+                     std::size_t readEndIndex,
+                     std::shared_ptr<util::Arena> arena) noexcept
+            : location(location),
+              command(std::move(command)),
+              error(std::move(error)),
+              readEndIndex(readEndIndex),
+              indexOffset(0),
+              arena(std::move(arena))
+        {
+        }
+    };
+
+private:
+    input::EditableTextInput &textInput;
+    util::SymbolTable &symbolTable;
+    const ParserDialect dialect;
+    /** in order, covering the input up to the last command */
+    std::vector<TopLevelItem> items;
+
+private:
+    /** reparses after replacing the text from `beginIndex` to `oldEndIndex` with `newSize`
+     * bytes */
+    void reparse(std::size_t beginIndex, std::size_t oldEndIndex, std::size_t newSize);
+
+public:
+    /** parses all of `textInput`, which must then only be edited through `replace` */
+    explicit IncrementalParser(
+        input::EditableTextInput &textInput,
+        util::SymbolTable &symbolTable,
+        const ParserDialect &dialect = ParserDialect::getQuickShellDialect());
+    /** replaces the text from `beginIndex` to `endIndex` with `text`, and reparses the
+     * top-level commands that the edit can change */
+    void replace(std::size_t beginIndex, std::size_t endIndex, util::string_view text)
+    {
+        textInput.replace(beginIndex, endIndex, text);
+        reparse(beginIndex, endIndex, text.size());
+    }
+    const std::vector<TopLevelItem> &getItems() const noexcept
+    {
+        return items;
+    }
+    input::EditableTextInput &getTextInput() const noexcept
+    {
+        return textInput;
+    }
+};
+}
+}
+
+#endif /* PARSER_INCREMENTAL_PARSER_H_ */
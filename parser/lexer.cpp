@@ -0,0 +1,208 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "lexer.h"
+#include "../util/byte_scan.h"
+#include <limits>
+
+namespace quick_shell
+{
+namespace parser
+{
+namespace
+{
+constexpr std::size_t maxTokenLength = std::numeric_limits<std::uint32_t>::max();
+
+/** returns the length of the newline starting with the CR at `index`, or 0 if it isn't one */
+std::size_t getCRNewLineLength(input::TextInput &textInput, std::size_t index)
+{
+    auto &textInputStyle = textInput.getInputStyle();
+    if(textInputStyle.allowCRLFAsNewLine)
+    {
+        auto span = textInput.getContiguousSpan(index + 1);
+        if(!span.empty() && *span.begin() == '\n')
+            return 2;
+    }
+    return textInputStyle.allowCRAsNewLine ? 1 : 0;
+}
+}
+
+inline input::ContiguousSpan TokenStream::getContiguousSpan(std::size_t index)
+{
+    if(index >= spanBeginIndex
+       && index - spanBeginIndex < static_cast<std::size_t>(spanEnd - spanBegin))
+        return input::ContiguousSpan(spanBegin + (index - spanBeginIndex), spanEnd);
+    auto retval = textInput->getContiguousSpan(index);
+    spanBegin = retval.begin();
+    spanEnd = retval.end();
+    spanBeginIndex = index;
+    blockBegin = nullptr;
+    blockEnd = nullptr;
+    return retval;
+}
+
+inline const unsigned char *TokenStream::findTextEnd(const unsigned char *position) noexcept
+{
+    while(position != spanEnd)
+    {
+        if(position < blockBegin || position >= blockEnd)
+        {
+            std::size_t count = spanEnd - position;
+            if(count > 64)
+                count = 64;
+            blockBegin = position;
+            blockEnd = position + count;
+            blockMask = util::getByteMask<'|',
+                                          '&',
+                                          ';',
+                                          '(',
+                                          ')',
+                                          '<',
+                                          '>',
+                                          '\'',
+                                          '\"',
+                                          '$',
+                                          '`',
+                                          '\\',
+                                          '#',
+                                          ' ',
+                                          '\t',
+                                          '\r',
+                                          '\n'>(position, count);
+        }
+        std::uint64_t mask = blockMask >> (position - blockBegin);
+        if(mask)
+            return position + util::countTrailingZeros(mask);
+        position = blockEnd;
+    }
+    return position;
+}
+
+void TokenStream::lexToken(std::size_t index)
+{
+    auto span = getContiguousSpan(index);
+    if(span.empty())
+    {
+        currentToken = Token(Token::Kind::EndOfFile, index, 0);
+        return;
+    }
+    auto &textInputStyle = textInput->getInputStyle();
+    unsigned char ch = *span.begin();
+    switch(ch)
+    {
+    case '|':
+    case '&':
+    case ';':
+    case '(':
+    case ')':
+    case '<':
+    case '>':
+        currentToken = Token(Token::Kind::Metacharacter, index, 1);
+        return;
+    case '\'':
+        currentToken = Token(Token::Kind::SingleQuote, index, 1);
+        return;
+    case '\"':
+        currentToken = Token(Token::Kind::DoubleQuote, index, 1);
+        return;
+    case '$':
+        currentToken = Token(Token::Kind::Dollar, index, 1);
+        return;
+    case '`':
+        currentToken = Token(Token::Kind::Backquote, index, 1);
+        return;
+    case '\\':
+        currentToken = Token(Token::Kind::Backslash, index, 1);
+        return;
+    case '#':
+        currentToken = Token(Token::Kind::Hash, index, 1);
+        return;
+    case ' ':
+    case '\t':
+    {
+        std::size_t endIndex = index;
+        while(endIndex - index < maxTokenLength)
+        {
+            auto *position = span.begin();
+            while(position != span.end() && (*position == ' ' || *position == '\t'))
+                ++position;
+            endIndex += position - span.begin();
+            if(position != span.end())
+                break;
+            span = getContiguousSpan(endIndex);
+            if(span.empty())
+                break;
+        }
+        if(endIndex - index > maxTokenLength)
+            endIndex = index + maxTokenLength;
+        currentToken = Token(Token::Kind::Blank, index, endIndex - index);
+        return;
+    }
+    case '\n':
+        if(textInputStyle.allowLFAsNewLine)
+        {
+            currentToken = Token(Token::Kind::NewLine, index, 1);
+            return;
+        }
+        // otherwise it's text
+        break;
+    case '\r':
+    {
+        auto newLineLength = getCRNewLineLength(*textInput, index);
+        if(newLineLength != 0)
+        {
+            currentToken = Token(Token::Kind::NewLine, index, newLineLength);
+            return;
+        }
+        // otherwise it's text
+        break;
+    }
+    default:
+        break;
+    }
+    // the first byte is text, so start scanning after it
+    std::size_t endIndex = index + 1;
+    auto *position = span.begin() + 1;
+    while(endIndex - index < maxTokenLength)
+    {
+        auto *stopPosition = findTextEnd(position);
+        endIndex += stopPosition - position;
+        if(stopPosition != span.end())
+        {
+            if(*stopPosition == '\n')
+            {
+                if(textInputStyle.allowLFAsNewLine)
+                    break;
+            }
+            else if(*stopPosition != '\r' || getCRNewLineLength(*textInput, endIndex) != 0)
+            {
+                break;
+            }
+            // a CR or LF that isn't a newline is text
+            endIndex++;
+            position = stopPosition + 1;
+            continue;
+        }
+        span = getContiguousSpan(endIndex);
+        if(span.empty())
+            break;
+        position = span.begin();
+    }
+    if(endIndex - index > maxTokenLength)
+        endIndex = index + maxTokenLength;
+    currentToken = Token(Token::Kind::Text, index, endIndex - index);
+}
+}
+}
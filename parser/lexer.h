@@ -0,0 +1,188 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PARSER_LEXER_H_
+#define PARSER_LEXER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include "../input/text_input.h"
+#include "../input/location.h"
+#include "../util/item_stream.h"
+#include "../util/string_view.h"
+#include "../util/compiler_intrinsics.h"
+
+namespace quick_shell
+{
+namespace parser
+{
+/** a run of input bytes that the lexer treats the same way, without any context like quoting.
+ *
+ * Line continuations aren't removed: they are a `Backslash` token followed by a `NewLine` token.
+ * */
+struct Token final
+{
+    enum class Kind : std::uint8_t
+    {
+        /** a run of bytes that aren't any of the other kinds */
+        Text,
+        /** a run of spaces and tabs */
+        Blank,
+        /** LF, CR or CRLF, as allowed by the input's `TextInputStyle` */
+        NewLine,
+        /** one of `|&;()<>` */
+        Metacharacter,
+        SingleQuote,
+        DoubleQuote,
+        Dollar,
+        Backquote,
+        Backslash,
+        Hash,
+        EndOfFile,
+    };
+    static util::string_view getKindString(Kind kind) noexcept
+    {
+        switch(kind)
+        {
+        case Kind::Text:
+            return "Text";
+        case Kind::Blank:
+            return "Blank";
+        case Kind::NewLine:
+            return "NewLine";
+        case Kind::Metacharacter:
+            return "Metacharacter";
+        case Kind::SingleQuote:
+            return "SingleQuote";
+        case Kind::DoubleQuote:
+            return "DoubleQuote";
+        case Kind::Dollar:
+            return "Dollar";
+        case Kind::Backquote:
+            return "Backquote";
+        case Kind::Backslash:
+            return "Backslash";
+        case Kind::Hash:
+            return "Hash";
+        case Kind::EndOfFile:
+            return "EndOfFile";
+        }
+        UNREACHABLE();
+        return "";
+    }
+    Kind kind;
+    std::uint32_t length;
+    std::size_t beginIndex;
+    constexpr Token() noexcept : kind(Kind::EndOfFile), length(0), beginIndex(0)
+    {
+    }
+    constexpr Token(Kind kind, std::size_t beginIndex, std::uint32_t length) noexcept
+        : kind(kind),
+          length(length),
+          beginIndex(beginIndex)
+    {
+    }
+    constexpr std::size_t getEndIndex() const noexcept
+    {
+        return beginIndex + length;
+    }
+    constexpr input::SimpleLocationSpan getSimpleLocationSpan() const noexcept
+    {
+        return input::SimpleLocationSpan(beginIndex, getEndIndex());
+    }
+    friend std::ostream &operator<<(std::ostream &os, const Token &token)
+    {
+        return os << getKindString(token.kind) << "@" << token.beginIndex << "+" << token.length;
+    }
+};
+
+/** item stream of the `Token`s in a `TextInput`, up to its first EOF.
+ *
+ * The input's contiguous spans are classified 64 bytes at a time with `util::getByteMask`, which
+ * uses SSE2 or AVX2 where available; tokens are then found from the bits of the mask. Copying a
+ * token stream is cheap; the copy continues independently from the same position.
+ * */
+class TokenStream final
+{
+private:
+    input::TextInput *textInput;
+    Token currentToken;
+    /** the contiguous span that the last token ended in, so most tokens don't need to ask
+     * `textInput` for it */
+    const unsigned char *spanBegin;
+    const unsigned char *spanEnd;
+    std::size_t spanBeginIndex;
+    /** up to 64 bytes of the current span, starting at `blockBegin`, with the bytes that can end a
+     * text token marked in `blockMask`, so short tokens don't each rescan the bytes after them */
+    const unsigned char *blockBegin;
+    const unsigned char *blockEnd;
+    std::uint64_t blockMask;
+
+private:
+    input::ContiguousSpan getContiguousSpan(std::size_t index);
+    const unsigned char *findTextEnd(const unsigned char *position) noexcept;
+    void lexToken(std::size_t index);
+
+public:
+    /** an empty stream */
+    constexpr TokenStream() noexcept : textInput(nullptr),
+                                       currentToken(),
+                                       spanBegin(nullptr),
+                                       spanEnd(nullptr),
+                                       spanBeginIndex(0),
+                                       blockBegin(nullptr),
+                                       blockEnd(nullptr),
+                                       blockMask(0)
+    {
+    }
+    explicit TokenStream(input::TextInput &textInput, std::size_t index = 0)
+        : textInput(&textInput),
+          currentToken(),
+          spanBegin(nullptr),
+          spanEnd(nullptr),
+          spanBeginIndex(0),
+          blockBegin(nullptr),
+          blockEnd(nullptr),
+          blockMask(0)
+    {
+        lexToken(index);
+    }
+    const Token &peek() const noexcept
+    {
+        return currentToken;
+    }
+    Token get()
+    {
+        auto retval = currentToken;
+        if(currentToken.kind != Token::Kind::EndOfFile)
+            lexToken(currentToken.getEndIndex());
+        return retval;
+    }
+    bool isAtEnd() const noexcept
+    {
+        return currentToken.kind == Token::Kind::EndOfFile;
+    }
+    input::TextInput *getTextInput() const noexcept
+    {
+        return textInput;
+    }
+};
+
+typedef util::ItemStreamIterator<TokenStream> TokenIterator;
+}
+}
+
+#endif /* PARSER_LEXER_H_ */
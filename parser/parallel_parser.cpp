@@ -0,0 +1,175 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "parallel_parser.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
+
+namespace quick_shell
+{
+namespace parser
+{
+namespace
+{
+/** smaller regions aren't worth a thread's time */
+constexpr std::size_t minimumRegionSize = 0x10000;
+/** more regions than threads, so threads that finish early can take over the rest */
+constexpr std::size_t regionsPerThread = 4;
+
+struct Region final
+{
+    std::size_t beginIndex;
+    std::size_t endIndex;
+    util::Arena arena;
+    util::SymbolTable symbolTable;
+    std::vector<util::SymbolId *> symbolIdReferences;
+    /** constructed before the workers start, since the constructor changes `textInput` */
+    std::unique_ptr<Parser> parser;
+    std::vector<util::ArenaPtr<ast::Command>> commands;
+    /** where parsing stopped; the same as `endIndex` unless the pre-scan was wrong */
+    std::size_t parsedEndIndex;
+    std::exception_ptr error;
+    Region(std::size_t beginIndex, std::size_t endIndex)
+        : beginIndex(beginIndex),
+          endIndex(endIndex),
+          arena(),
+          symbolTable(),
+          symbolIdReferences(),
+          parser(),
+          commands(),
+          parsedEndIndex(beginIndex),
+          error()
+    {
+    }
+};
+
+/** parses top-level commands until reaching `endIndex` or the end of the input */
+void parseCommands(Parser &parser,
+                   std::vector<util::ArenaPtr<ast::Command>> &commands,
+                   std::size_t endIndex = static_cast<std::size_t>(-1))
+{
+    while(parser.getTopLevelIndex() < endIndex)
+    {
+        util::ArenaPtr<ast::Command> command;
+        auto result = parser.parseTopLevelCommand(command);
+        if(result == ParseCommandResult::Quit)
+            break;
+        if(result == ParseCommandResult::Success)
+            commands.push_back(command);
+    }
+}
+
+void parseRegion(Region &region)
+{
+    try
+    {
+        parseCommands(*region.parser, region.commands, region.endIndex);
+    }
+    catch(...)
+    {
+        region.error = std::current_exception();
+    }
+    region.parsedEndIndex = region.parser->getTopLevelIndex();
+}
+}
+
+std::vector<util::ArenaPtr<ast::Command>> parseInParallel(input::TextInput &textInput,
+                                                          util::Arena &arena,
+                                                          util::SymbolTable &symbolTable,
+                                                          const ParserDialect &dialect,
+                                                          bool parseFunctionBodiesLazily,
+                                                          std::size_t threadCount)
+{
+    std::vector<util::ArenaPtr<ast::Command>> retval;
+    Parser parser(textInput, arena, symbolTable, dialect);
+    parser.setParseFunctionBodiesLazily(parseFunctionBodiesLazily);
+    if(threadCount == 0)
+        threadCount = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    if(threadCount == 1 || textInput.getRetryAfterEOF())
+    {
+        parseCommands(parser, retval);
+        return retval;
+    }
+    // after this, the workers can all read textInput at once
+    std::size_t endIndex = textInput.readToEnd();
+    std::size_t beginIndex = parser.getTopLevelIndex();
+    auto splitPoints = parser.findTopLevelSplitPoints(std::max(
+        minimumRegionSize, (endIndex - beginIndex) / (threadCount * regionsPerThread)));
+    if(splitPoints.empty())
+    {
+        parseCommands(parser, retval);
+        return retval;
+    }
+    splitPoints.push_back(endIndex);
+    std::vector<std::unique_ptr<Region>> regions;
+    regions.reserve(splitPoints.size());
+    for(std::size_t splitPoint : splitPoints)
+    {
+        std::unique_ptr<Region> region(new Region(beginIndex, splitPoint));
+        region->parser.reset(new Parser(textInput, region->arena, region->symbolTable, dialect));
+        region->parser->setParseFunctionBodiesLazily(parseFunctionBodiesLazily);
+        region->parser->setSymbolIdReferences(&region->symbolIdReferences);
+        region->parser->setTopLevelIndex(beginIndex);
+        regions.push_back(std::move(region));
+        beginIndex = splitPoint;
+    }
+    std::atomic<std::size_t> nextRegionIndex(0);
+    auto worker = [&]()
+    {
+        for(;;)
+        {
+            std::size_t regionIndex = nextRegionIndex.fetch_add(1, std::memory_order_relaxed);
+            if(regionIndex >= regions.size())
+                break;
+            parseRegion(*regions[regionIndex]);
+        }
+    };
+    std::vector<std::thread> threads;
+    threads.reserve(std::min(threadCount, regions.size()) - 1);
+    for(std::size_t i = 1; i < threadCount && i < regions.size(); i++)
+        threads.emplace_back(worker);
+    worker();
+    for(auto &thread : threads)
+        thread.join();
+    // stitch the regions together in source order
+    std::vector<util::SymbolId> symbolMap;
+    for(auto &region : regions)
+    {
+        if(region->error)
+            std::rethrow_exception(region->error);
+        // interning each region's symbols in order gives the ids a sequential parse would
+        symbolMap.resize(region->symbolTable.size() + 1);
+        for(std::uint32_t symbol = 1; symbol < symbolMap.size(); symbol++)
+            symbolMap[symbol] =
+                symbolTable.intern(region->symbolTable.getText(util::SymbolId(symbol)));
+        for(auto *symbolId : region->symbolIdReferences)
+            *symbolId = symbolMap[symbolId->value];
+        arena.merge(std::move(region->arena));
+        retval.insert(retval.end(), region->commands.begin(), region->commands.end());
+        if(region->parsedEndIndex != region->endIndex)
+        {
+            // the pre-scan split inside a command; the rest of the regions can't be used
+            parser.setTopLevelIndex(region->parsedEndIndex);
+            parseCommands(parser, retval);
+            break;
+        }
+    }
+    return retval;
+}
+}
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef PARSER_PARALLEL_PARSER_H_
+#define PARSER_PARALLEL_PARSER_H_
+
+#include <cstddef>
+#include <vector>
+#include "parser.h"
+
+namespace quick_shell
+{
+namespace parser
+{
+/** parses all the top-level commands in `textInput`, like calling
+ * `Parser::parseTopLevelCommand` until it returns `ParseCommandResult::Quit`, but on up to
+ * `threadCount` threads (0 for the hardware concurrency).
+ *
+ * A sequential pre-scan (`Parser::findTopLevelSplitPoints`) splits the input into regions at
+ * top-level command boundaries, then each region is parsed into its own arena and symbol table.
+ * These are moved into `arena` and `symbolTable` in source order, so the commands and symbol ids
+ * are the same as from a sequential parse. Throws the first `ParseError` in the input.
+ *
+ * The whole input is read first; inputs with `retryAfterEOF` set are parsed sequentially.
+ * */
+std::vector<util::ArenaPtr<ast::Command>> parseInParallel(
+    input::TextInput &textInput,
+    util::Arena &arena,
+    util::SymbolTable &symbolTable,
+    const ParserDialect &dialect = ParserDialect::getQuickShellDialect(),
+    bool parseFunctionBodiesLazily = false,
+    std::size_t threadCount = 0);
+}
+}
+
+#endif /* PARSER_PARALLEL_PARSER_H_ */
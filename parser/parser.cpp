@@ -20,27 +20,2280 @@ namespace quick_shell
 {
 namespace parser
 {
-void Parser::test()
+util::string_view Parser::getControlOperatorString(ControlOperator controlOperator) noexcept
+{
+    switch(controlOperator)
+    {
+    case ControlOperator::Semicolon:
+        return ";";
+    case ControlOperator::DoubleSemicolon:
+        return ";;";
+    case ControlOperator::SemicolonAmpersand:
+        return ";&";
+    case ControlOperator::DoubleSemicolonAmpersand:
+        return ";;&";
+    case ControlOperator::Ampersand:
+        return "&";
+    case ControlOperator::DoubleAmpersand:
+        return "&&";
+    case ControlOperator::Pipe:
+        return "|";
+    case ControlOperator::PipeAmpersand:
+        return "|&";
+    case ControlOperator::DoublePipe:
+        return "||";
+    case ControlOperator::LParen:
+        return "(";
+    case ControlOperator::RParen:
+        return ")";
+    }
+    UNREACHABLE();
+    return "";
+}
+
+bool Parser::parseControlOperator(input::LineContinuationRemovingIterator &textIter,
+                                  ControlOperator &controlOperator)
+{
+    auto textIter2 = textIter;
+    switch(*textIter2)
+    {
+    case ';':
+        ++textIter2;
+        if(*textIter2 == ';')
+        {
+            ++textIter2;
+            if(*textIter2 == '&')
+            {
+                ++textIter2;
+                controlOperator = ControlOperator::DoubleSemicolonAmpersand;
+            }
+            else
+            {
+                controlOperator = ControlOperator::DoubleSemicolon;
+            }
+        }
+        else if(*textIter2 == '&')
+        {
+            ++textIter2;
+            controlOperator = ControlOperator::SemicolonAmpersand;
+        }
+        else
+        {
+            controlOperator = ControlOperator::Semicolon;
+        }
+        break;
+    case '&':
+        ++textIter2;
+        if(*textIter2 == '>')
+            return false;
+        if(*textIter2 == '&')
+        {
+            ++textIter2;
+            controlOperator = ControlOperator::DoubleAmpersand;
+        }
+        else
+        {
+            controlOperator = ControlOperator::Ampersand;
+        }
+        break;
+    case '|':
+        ++textIter2;
+        if(*textIter2 == '&')
+        {
+            ++textIter2;
+            controlOperator = ControlOperator::PipeAmpersand;
+        }
+        else if(*textIter2 == '|')
+        {
+            ++textIter2;
+            controlOperator = ControlOperator::DoublePipe;
+        }
+        else
+        {
+            controlOperator = ControlOperator::Pipe;
+        }
+        break;
+    case '(':
+        ++textIter2;
+        controlOperator = ControlOperator::LParen;
+        break;
+    case ')':
+        ++textIter2;
+        controlOperator = ControlOperator::RParen;
+        break;
+    default:
+        return false;
+    }
+    textIter = textIter2;
+    return true;
+}
+
+bool Parser::parseRedirectionOperator(input::LineContinuationRemovingIterator &textIter,
+                                      int &fileDescriptor,
+                                      ast::Redirection::Kind &kind)
+{
+    typedef ast::Redirection::Kind Kind;
+    auto textIter2 = textIter;
+    fileDescriptor = -1;
+    if(*textIter2 == '&')
+    {
+        ++textIter2;
+        if(*textIter2 != '>')
+            return false;
+        ++textIter2;
+        if(*textIter2 == '>')
+        {
+            ++textIter2;
+            kind = Kind::AppendOutputAndError;
+        }
+        else
+        {
+            kind = Kind::OutputAndError;
+        }
+        textIter = textIter2;
+        return true;
+    }
+    int digitValue = parseDigit(textIter2);
+    if(digitValue >= 0)
+    {
+        fileDescriptor = digitValue;
+        while((digitValue = parseDigit(textIter2)) >= 0)
+        {
+            // too big to be a file descriptor, so it's just a word
+            if(fileDescriptor > (std::numeric_limits<int>::max() - digitValue) / 10)
+                return false;
+            fileDescriptor = fileDescriptor * 10 + digitValue;
+        }
+    }
+    if(*textIter2 == '<')
+    {
+        ++textIter2;
+        if(*textIter2 == '<')
+        {
+            ++textIter2;
+            if(*textIter2 == '<')
+            {
+                ++textIter2;
+                kind = Kind::HereString;
+            }
+            else if(*textIter2 == '-')
+            {
+                ++textIter2;
+                kind = Kind::HereDocumentStripTabs;
+            }
+            else
+            {
+                kind = Kind::HereDocument;
+            }
+        }
+        else if(*textIter2 == '&')
+        {
+            ++textIter2;
+            kind = Kind::DuplicateInput;
+        }
+        else if(*textIter2 == '>')
+        {
+            ++textIter2;
+            kind = Kind::ReadWrite;
+        }
+        else
+        {
+            kind = Kind::Input;
+        }
+    }
+    else if(*textIter2 == '>')
+    {
+        ++textIter2;
+        if(*textIter2 == '>')
+        {
+            ++textIter2;
+            kind = Kind::Append;
+        }
+        else if(*textIter2 == '&')
+        {
+            ++textIter2;
+            kind = Kind::DuplicateOutput;
+        }
+        else if(*textIter2 == '|')
+        {
+            ++textIter2;
+            kind = Kind::Clobber;
+        }
+        else
+        {
+            kind = Kind::Output;
+        }
+    }
+    else
+    {
+        return false;
+    }
+    textIter = textIter2;
+    return true;
+}
+
+bool Parser::parseReservedWord(input::LineContinuationRemovingIterator &textIter,
+                               ReservedWord &reservedWord)
+{
+    // longer than any reserved word, so longer words don't need to be read in full
+    char buffer[9];
+    std::size_t size = 0;
+    auto textIter2 = textIter;
+    while(size < sizeof(buffer))
+    {
+        if(!(getCharacterClasses(textIter2) & CharacterClass::simpleWordContinue)
+           && *textIter2 != '!')
+            break;
+        buffer[size++] = static_cast<char>(*textIter2);
+        ++textIter2;
+    }
+    if(size == 0 || !isUnquotedWordEndCharacter(textIter2, 0))
+        return false;
+    auto result = stringToReservedWord(util::string_view(buffer, size));
+    if(!result.is<ReservedWord>())
+        return false;
+    reservedWord = result.get<ReservedWord>();
+    textIter = textIter2;
+    return true;
+}
+
+bool Parser::isLiteralWord(const ast::Word &word) noexcept
+{
+    if(word.wordParts.empty())
+        return false;
+    for(auto &part : word.wordParts)
+        if(part.kind != ast::CompactWordPart::Kind::Text
+           || part.quoteKind != ast::WordPart::QuoteKind::Unquoted)
+            return false;
+    return true;
+}
+
+bool Parser::isNameWord(const ast::Word &word) noexcept
+{
+    if(!isLiteralWord(word))
+        return false;
+    bool isFirst = true;
+    for(auto &part : word.wordParts)
+    {
+        for(char ch : part.getCookedText())
+        {
+            if(isFirst ? !CharacterClass::isNameStart(ch) : !CharacterClass::isNameContinue(ch))
+                return false;
+            isFirst = false;
+        }
+    }
+    return !isFirst;
+}
+
+bool Parser::isAtCompoundCommand(const input::LineContinuationRemovingIterator &textIter)
+{
+    if(*textIter == '(')
+        return true;
+    ReservedWord reservedWord;
+    if(!parseReservedWord(copy(textIter), reservedWord))
+        return false;
+    switch(reservedWord)
+    {
+    case ReservedWord::LBrace:
+    case ReservedWord::If:
+    case ReservedWord::While:
+    case ReservedWord::Until:
+    case ReservedWord::For:
+    case ReservedWord::Select:
+    case ReservedWord::Case:
+    case ReservedWord::DoubleLBracket:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool Parser::isAtCompoundListEnd(const input::LineContinuationRemovingIterator &textIter)
+{
+    ControlOperator controlOperator;
+    if(*textIter == input::eof)
+        return true;
+    if(parseControlOperator(copy(textIter), controlOperator))
+    {
+        switch(controlOperator)
+        {
+        case ControlOperator::RParen:
+        case ControlOperator::DoubleSemicolon:
+        case ControlOperator::SemicolonAmpersand:
+        case ControlOperator::DoubleSemicolonAmpersand:
+            return true;
+        default:
+            return false;
+        }
+    }
+    ReservedWord reservedWord;
+    if(!parseReservedWord(copy(textIter), reservedWord))
+        return false;
+    switch(reservedWord)
+    {
+    case ReservedWord::Then:
+    case ReservedWord::Else:
+    case ReservedWord::ElIf:
+    case ReservedWord::Fi:
+    case ReservedWord::Do:
+    case ReservedWord::Done:
+    case ReservedWord::Esac:
+    case ReservedWord::RBrace:
+        return true;
+    default:
+        return false;
+    }
+}
+
+std::string Parser::getTokenDescription(input::SimpleLocation location)
 {
-    try
+    auto textIter = input::LineContinuationRemovingIterator(textInput.iteratorAt(location.index));
+    if(*textIter == input::eof)
+        return "end of file";
+    if(isAtNewLine(textIter))
+        return "newline";
+    ControlOperator controlOperator;
+    if(parseControlOperator(copy(textIter), controlOperator))
+        return "`" + std::string(getControlOperatorString(controlOperator)) + "`";
+    int fileDescriptor;
+    ast::Redirection::Kind kind;
+    if(parseRedirectionOperator(copy(textIter), fileDescriptor, kind))
+        return "`" + std::string(ast::Redirection::getKindString(kind)) + "`";
+    ReservedWord reservedWord;
+    if(parseReservedWord(copy(textIter), reservedWord))
+        return "`" + std::string(getReservedWordString(reservedWord)) + "`";
+    std::string retval = "`";
+    while(!isUnquotedWordEndCharacter(textIter, 0))
     {
-        auto textIter = input::LineContinuationRemovingIterator(textInput.begin());
-        auto result = parseWord(textIter, false, true, true);
+        retval += static_cast<char>(*textIter);
+        ++textIter;
+    }
+    return retval + "`";
+}
+
+ParseFailure Parser::unexpectedTokenError(input::SimpleLocation location) noexcept
+{
+    return parserError(
+        [](Parser &parser, input::SimpleLocation location, GenerateParseErrorFnArgument)
+        {
+            throw ParseError(input::Location(location, parser.textInput),
+                             "syntax error: unexpected " + parser.getTokenDescription(location));
+        },
+        location);
+}
+
+ParseFailure Parser::expectedTokenError(input::SimpleLocation location,
+                                        util::string_view expectedToken) noexcept
+{
+    return parserError(
+        [](Parser &parser, input::SimpleLocation location, GenerateParseErrorFnArgument argument)
+        {
+            std::ostringstream ss;
+            ss << "syntax error: expected `" << static_cast<const char *>(argument.object)
+               << "` but found " << parser.getTokenDescription(location);
+            throw ParseError(input::Location(location, parser.textInput), ss.str());
+        },
+        location,
+        static_cast<void *>(const_cast<char *>(expectedToken.data())));
+}
+
+ParseResult<> Parser::parseExpectedReservedWord(input::LineContinuationRemovingIterator &textIter,
+                                                ReservedWord expectedReservedWord)
+{
+    ReservedWord reservedWord;
+    auto textIter2 = textIter;
+    if(!parseReservedWord(textIter2, reservedWord) || reservedWord != expectedReservedWord)
+        return expectedTokenError(textIter.getLocation(),
+                                  getReservedWordString(expectedReservedWord));
+    textIter = textIter2;
+    return parserSuccess();
+}
+
+bool Parser::parseHereDocumentBody(input::TextInput::Iterator &textIter,
+                                   const std::string &delimiter,
+                                   bool stripTabs,
+                                   input::Location &bodyEndLocation)
+{
+    std::string line;
+    for(;;)
+    {
+        bodyEndLocation = textIter.getLocation();
+        if(*textIter == input::eof)
+            return false;
+        if(stripTabs)
+            while(*textIter == '\t')
+                ++textIter;
+        line.clear();
+        while(*textIter != input::eof && !parseNewLine(copy(textIter)))
+        {
+            line += static_cast<char>(*textIter);
+            ++textIter;
+        }
+        parseNewLine(textIter);
+        if(line == delimiter)
+            return true;
+    }
+}
+
+ParseResult<> Parser::parseHereDocumentBodies(input::TextInput::Iterator &textIter)
+{
+    std::string delimiter;
+    for(auto &redirection : pendingHereDocuments)
+    {
+        delimiter.clear();
+        bool isQuoted = false;
+        auto &word = *redirection->target;
+        for(auto &part : word.wordParts)
+        {
+            if(part.kind != ast::CompactWordPart::Kind::Text
+               || part.quoteKind != ast::WordPart::QuoteKind::Unquoted)
+                isQuoted = true;
+            auto text = part.getCookedText();
+            delimiter.append(text.data(), text.size());
+        }
+        auto bodyStartLocation = textIter.getLocation();
+        auto bodyEndLocation = bodyStartLocation;
+        // a missing delimiter line just ends the here-document at EOF
+        parseHereDocumentBody(
+            textIter,
+            delimiter,
+            redirection->kind == ast::Redirection::Kind::HereDocumentStripTabs,
+            bodyEndLocation);
+        redirection->hereDocument = arena.allocate<ast::HereDocument>(
+            input::LocationSpan(bodyStartLocation, bodyEndLocation), isQuoted);
+    }
+    pendingHereDocuments.clear();
+    return parserSuccess();
+}
+
+ParseResult<> Parser::parseNewLineAndHereDocuments(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto baseTextIter = textIter.getBaseIterator();
+    if(!parseNewLine(baseTextIter))
+        return expectedTokenError(textIter.getLocation(), "newline");
+    if(!pendingHereDocuments.empty())
+    {
+        auto result = parseHereDocumentBodies(baseTextIter);
+        if(!result)
+            return ParseFailure();
+    }
+    textIter = input::LineContinuationRemovingIterator(baseTextIter);
+    return parserSuccess();
+}
+
+ParseResult<> Parser::parseLineBreak(input::LineContinuationRemovingIterator &textIter)
+{
+    for(;;)
+    {
+        skipBlanks(textIter);
+        if(*textIter == '#')
+        {
+            auto result = parseComment(textIter, 0);
+            if(!result)
+                return ParseFailure();
+        }
+        if(!isAtNewLine(textIter))
+            return parserSuccess();
+        auto result = parseNewLineAndHereDocuments(textIter);
+        if(!result)
+            return ParseFailure();
+    }
+}
+
+ParseResult<util::ArenaPtr<ast::Command>> Parser::parseCommandList(
+    input::LineContinuationRemovingIterator &textIter, bool isTopLevel)
+{
+    typedef ast::CommandList::Terminator Terminator;
+    auto startLocation = textIter.getLocation();
+    auto endLocation = startLocation;
+    ast::CommandList::Parts parts;
+    for(;;)
+    {
+        auto command = parseAndOrList(textIter);
+        if(!command)
+            return ParseFailure();
+        auto terminator = Terminator::None;
+        auto textIter2 = textIter;
+        skipBlanks(textIter2);
+        ControlOperator controlOperator;
+        auto textIter3 = textIter2;
+        if(parseControlOperator(textIter3, controlOperator)
+           && (controlOperator == ControlOperator::Semicolon
+               || controlOperator == ControlOperator::Ampersand))
+        {
+            terminator = controlOperator == ControlOperator::Semicolon ? Terminator::Semicolon :
+                                                                         Terminator::Ampersand;
+            textIter = textIter3;
+        }
+        else if(!isTopLevel && (isAtNewLine(textIter2) || *textIter2 == '#'))
+        {
+            terminator = Terminator::NewLine;
+        }
+        endLocation = terminator == Terminator::NewLine ? textIter2.getLocation() :
+                                                          textIter.getLocation();
+        parts.emplace_back(arena, command.get(), terminator);
+        if(terminator == Terminator::None)
+            break;
+        textIter2 = textIter;
+        if(isTopLevel)
+        {
+            // stop before the newline, so nothing after it is read yet
+            skipBlanks(textIter2);
+            if(*textIter2 == input::eof || *textIter2 == '#' || isAtNewLine(textIter2))
+                break;
+        }
+        else
+        {
+            auto result = parseLineBreak(textIter2);
+            if(!result)
+                return ParseFailure();
+            if(isAtCompoundListEnd(textIter2))
+            {
+                textIter = textIter2;
+                break;
+            }
+        }
+        textIter = textIter2;
+    }
+    if(parts.size() == 1 && parts.front().terminator != Terminator::Ampersand)
+        return parserSuccess(parts.front().command);
+    return parserSuccess(util::ArenaPtr<ast::Command>(arena.allocate<ast::CommandList>(
+        input::LocationSpan(startLocation, endLocation), std::move(parts))));
+}
+
+ParseResult<util::ArenaPtr<ast::Command>> Parser::parseAndOrList(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    typedef ast::AndOrList::Operator Operator;
+    auto startLocation = textIter.getLocation();
+    auto firstCommand = parsePipeline(textIter);
+    if(!firstCommand)
+        return ParseFailure();
+    ast::AndOrList::Parts parts;
+    parts.emplace_back(arena, Operator::None, firstCommand.get());
+    for(;;)
+    {
+        auto textIter2 = textIter;
+        skipBlanks(textIter2);
+        ControlOperator controlOperator;
+        if(!parseControlOperator(textIter2, controlOperator)
+           || (controlOperator != ControlOperator::DoubleAmpersand
+               && controlOperator != ControlOperator::DoublePipe))
+            break;
+        auto result = parseLineBreak(textIter2);
         if(!result)
-            result.throwError(*this);
+            return ParseFailure();
+        auto command = parsePipeline(textIter2);
+        if(!command)
+            return ParseFailure();
+        parts.emplace_back(
+            arena,
+            controlOperator == ControlOperator::DoubleAmpersand ? Operator::And : Operator::Or,
+            command.get());
+        textIter = textIter2;
+    }
+    if(parts.size() == 1)
+        return firstCommand;
+    return parserSuccess(util::ArenaPtr<ast::Command>(arena.allocate<ast::AndOrList>(
+        input::LocationSpan(startLocation, textIter.getLocation()), std::move(parts))));
+}
+
+ParseResult<util::ArenaPtr<ast::Command>> Parser::parsePipeline(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    bool isNegated = false;
+    bool isTimed = false;
+    bool isTimePosix = false;
+    for(;;)
+    {
+        ReservedWord reservedWord;
+        auto textIter2 = textIter;
+        if(!parseReservedWord(textIter2, reservedWord))
+            break;
+        if(reservedWord == ReservedWord::ExMark)
+        {
+            isNegated = !isNegated;
+        }
+        else if(reservedWord == ReservedWord::Time && !isTimed)
+        {
+            isTimed = true;
+            auto textIter3 = textIter2;
+            skipBlanks(textIter3);
+            if(*textIter3 == '-')
+            {
+                ++textIter3;
+                if(*textIter3 == 'p')
+                {
+                    ++textIter3;
+                    if(isUnquotedWordEndCharacter(textIter3, 0))
+                    {
+                        isTimePosix = true;
+                        textIter2 = textIter3;
+                    }
+                }
+            }
+        }
         else
         {
-            ast::ASTDumpState dumpState;
-            result.get()->dump(std::cout, dumpState);
+            break;
         }
+        textIter = textIter2;
+        skipBlanks(textIter);
+    }
+    ast::Pipeline::Parts parts;
+    for(;;)
+    {
+        auto command = parseCommand(textIter);
+        if(!command)
+            return ParseFailure();
+        parts.emplace_back(arena, command.get(), false);
+        auto textIter2 = textIter;
+        skipBlanks(textIter2);
+        ControlOperator controlOperator;
+        if(!parseControlOperator(textIter2, controlOperator)
+           || (controlOperator != ControlOperator::Pipe
+               && controlOperator != ControlOperator::PipeAmpersand))
+            break;
+        parts.back().pipesStandardError = controlOperator == ControlOperator::PipeAmpersand;
+        auto result = parseLineBreak(textIter2);
+        if(!result)
+            return ParseFailure();
+        textIter = textIter2;
+    }
+    if(parts.size() == 1 && !isNegated && !isTimed)
+        return parserSuccess(parts.front().command);
+    return parserSuccess(util::ArenaPtr<ast::Command>(
+        arena.allocate<ast::Pipeline>(input::LocationSpan(startLocation, textIter.getLocation()),
+                                      std::move(parts),
+                                      isNegated,
+                                      isTimed,
+                                      isTimePosix)));
+}
+
+ParseResult<util::ArenaPtr<ast::Command>> Parser::parseCommand(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    ReservedWord reservedWord;
+    if(parseReservedWord(copy(textIter), reservedWord))
+    {
+        switch(reservedWord)
+        {
+        case ReservedWord::LBrace:
+        case ReservedWord::If:
+        case ReservedWord::While:
+        case ReservedWord::Until:
+        case ReservedWord::For:
+        case ReservedWord::Select:
+        case ReservedWord::Case:
+        case ReservedWord::DoubleLBracket:
+        {
+            auto result = parseCompoundCommand(textIter);
+            if(!result)
+                return ParseFailure();
+            return parserSuccess(util::ArenaPtr<ast::Command>(result.get()));
+        }
+        case ReservedWord::Function:
+            return parseFunctionKeywordDefinition(textIter);
+        case ReservedWord::Coproc:
+            return parseCoprocCommand(textIter);
+        case ReservedWord::DoubleRBracket:
+        case ReservedWord::In:
+            // only reserved in other places
+            return parseSimpleCommand(textIter);
+        case ReservedWord::ExMark:
+        case ReservedWord::Time:
+        case ReservedWord::Then:
+        case ReservedWord::Else:
+        case ReservedWord::ElIf:
+        case ReservedWord::Fi:
+        case ReservedWord::Do:
+        case ReservedWord::Done:
+        case ReservedWord::Esac:
+        case ReservedWord::RBrace:
+            return unexpectedTokenError(textIter);
+        }
+        UNREACHABLE();
+    }
+    if(*textIter == '(')
+    {
+        auto result = parseCompoundCommand(textIter);
+        if(!result)
+            return ParseFailure();
+        return parserSuccess(util::ArenaPtr<ast::Command>(result.get()));
+    }
+    if(isAtWordStart(textIter) || isAtRedirection(textIter))
+        return parseSimpleCommand(textIter);
+    return unexpectedTokenError(textIter);
+}
+
+ParseResult<util::ArenaPtr<ast::Redirection>> Parser::parseRedirection(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    int fileDescriptor;
+    ast::Redirection::Kind kind;
+    if(!parseRedirectionOperator(textIter, fileDescriptor, kind))
+        return parserErrorStaticString("missing redirection", textIter);
+    skipBlanks(textIter);
+    if(!isAtWordStart(textIter))
+        return unexpectedTokenError(textIter);
+    auto target = parseWord(textIter, 0, false, false);
+    if(!target)
+        return ParseFailure();
+    auto retval = arena.allocate<ast::Redirection>(
+        input::LocationSpan(startLocation, textIter.getLocation()),
+        kind,
+        fileDescriptor,
+        target.get());
+    if(ast::Redirection::isHereDocument(kind))
+        pendingHereDocuments.push_back(retval);
+    return parserSuccess(retval);
+}
+
+ParseResult<> Parser::parseRedirections(input::LineContinuationRemovingIterator &textIter,
+                                        ast::CompoundCommand::Redirections &redirections)
+{
+    for(;;)
+    {
+        auto textIter2 = textIter;
+        skipBlanks(textIter2);
+        if(!isAtRedirection(textIter2))
+            return parserSuccess();
+        auto redirection = parseRedirection(textIter2);
+        if(!redirection)
+            return ParseFailure();
+        redirections.push_back(arena, redirection.get());
+        textIter = textIter2;
+    }
+}
+
+ParseResult<util::ArenaPtr<ast::Command>> Parser::parseSimpleCommand(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    auto endLocation = startLocation;
+    ast::SimpleCommand::Parts parts;
+    util::ArenaPtr<ast::Comment> finalComment;
+    bool checkForVariableAssignment = true;
+    for(;;)
+    {
+        util::ArenaPtr<ast::WordOrRedirection> wordOrRedirection;
+        if(isAtRedirection(textIter))
+        {
+            auto redirection = parseRedirection(textIter);
+            if(!redirection)
+                return ParseFailure();
+            wordOrRedirection = redirection.get();
+        }
+        else if(isAtWordStart(textIter))
+        {
+            auto word = parseWord(textIter, 0, checkForVariableAssignment, false);
+            if(!word)
+                return ParseFailure();
+            if(checkForVariableAssignment
+               && word.get()->wordParts.front().kind
+                      != ast::CompactWordPart::Kind::AssignmentVariableName)
+            {
+                // the command name, or the name of a function being defined
+                checkForVariableAssignment = false;
+                internLiteralSymbol(*word.get());
+            }
+            if(parts.empty() && isLiteralWord(*word.get()))
+            {
+                auto textIter2 = textIter;
+                skipBlanks(textIter2);
+                if(*textIter2 == '(')
+                {
+                    textIter = textIter2;
+                    return parseFunctionDefinitionRest(textIter, startLocation, word.get(), false);
+                }
+            }
+            wordOrRedirection = word.get();
+        }
+        else
+        {
+            break;
+        }
+        endLocation = textIter.getLocation();
+        auto textIter2 = textIter;
+        skipBlanks(textIter2);
+        auto blanksLocation = input::LocationSpan(endLocation, textIter2.getLocation());
+        if(*textIter2 == '#')
+        {
+            parts.emplace_back(arena, wordOrRedirection, makeBlankOrEmpty(blanksLocation));
+            auto comment = parseComment(textIter2, 0);
+            if(!comment)
+                return ParseFailure();
+            finalComment = comment.get();
+            textIter = textIter2;
+            endLocation = textIter.getLocation();
+            break;
+        }
+        if(blanksLocation.size() == 0
+           || (!isAtWordStart(textIter2) && !isAtRedirection(textIter2)))
+        {
+            // leave trailing blanks for the enclosing command
+            parts.emplace_back(
+                arena,
+                wordOrRedirection,
+                makeBlankOrEmpty(input::LocationSpan(endLocation, endLocation)));
+            if(blanksLocation.size() == 0)
+                continue;
+            break;
+        }
+        parts.emplace_back(arena, wordOrRedirection, makeBlankOrEmpty(blanksLocation));
+        textIter = textIter2;
+    }
+    return parserSuccess(util::ArenaPtr<ast::Command>(arena.allocate<ast::SimpleCommand>(
+        input::LocationSpan(startLocation, endLocation),
+        makeBlankOrEmpty(input::LocationSpan(startLocation, startLocation)),
+        std::move(parts),
+        finalComment)));
+}
+
+ParseResult<util::ArenaPtr<ast::Command>> Parser::parseFunctionDefinitionRest(
+    input::LineContinuationRemovingIterator &textIter,
+    input::Location startLocation,
+    util::ArenaPtr<ast::Word> name,
+    bool usesFunctionKeyword)
+{
+    if(*textIter != '(')
+        return expectedTokenError(textIter.getLocation(), "(");
+    ++textIter;
+    skipBlanks(textIter);
+    if(*textIter != ')')
+        return expectedTokenError(textIter.getLocation(), ")");
+    ++textIter;
+    auto result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    if(!isAtCompoundCommand(textIter))
+        return unexpectedTokenError(textIter);
+    auto body = parseFunctionBody(textIter);
+    if(!body)
+        return ParseFailure();
+    return parserSuccess(util::ArenaPtr<ast::Command>(arena.allocate<ast::FunctionDefinition>(
+        input::LocationSpan(startLocation, textIter.getLocation()),
+        name,
+        body.get(),
+        usesFunctionKeyword)));
+}
+
+ParseResult<util::ArenaPtr<ast::Command>> Parser::parseFunctionKeywordDefinition(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    auto result = parseExpectedReservedWord(textIter, ReservedWord::Function);
+    if(!result)
+        return ParseFailure();
+    skipBlanks(textIter);
+    if(!isAtWordStart(textIter))
+        return unexpectedTokenError(textIter);
+    auto nameLocation = textIter.getLocation();
+    auto name = parseWord(textIter, 0, false, false);
+    if(!name)
+        return ParseFailure();
+    if(!isLiteralWord(*name.get()))
+        return parserErrorStaticString("invalid function name", nameLocation);
+    internLiteralSymbol(*name.get());
+    auto textIter2 = textIter;
+    skipBlanks(textIter2);
+    if(*textIter2 == '(')
+    {
+        textIter = textIter2;
+        return parseFunctionDefinitionRest(textIter, startLocation, name.get(), true);
+    }
+    result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    if(!isAtCompoundCommand(textIter))
+        return unexpectedTokenError(textIter);
+    auto body = parseFunctionBody(textIter);
+    if(!body)
+        return ParseFailure();
+    return parserSuccess(util::ArenaPtr<ast::Command>(arena.allocate<ast::FunctionDefinition>(
+        input::LocationSpan(startLocation, textIter.getLocation()), name.get(), body.get(), true)));
+}
+
+ParseResult<util::ArenaPtr<ast::Command>> Parser::parseCoprocCommand(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    auto result = parseExpectedReservedWord(textIter, ReservedWord::Coproc);
+    if(!result)
+        return ParseFailure();
+    skipBlanks(textIter);
+    util::ArenaPtr<ast::Word> name;
+    if(!isAtCompoundCommand(textIter) && isAtWordStart(textIter))
+    {
+        // `coproc NAME` is only a name if a compound command follows it
+        auto checkpointValue = checkpoint();
+        auto textIter2 = textIter;
+        auto word = parseWord(textIter2, 0, false, false);
+        if(word && isNameWord(*word.get()))
+        {
+            skipBlanks(textIter2);
+            if(isAtCompoundCommand(textIter2))
+            {
+                name = word.get();
+                internLiteralSymbol(*name);
+                textIter = textIter2;
+            }
+        }
+        if(!name)
+            rollbackTo(checkpointValue);
+    }
+    auto command = parseCommand(textIter);
+    if(!command)
+        return ParseFailure();
+    return parserSuccess(util::ArenaPtr<ast::Command>(arena.allocate<ast::CoprocCommand>(
+        input::LocationSpan(startLocation, textIter.getLocation()), name, command.get())));
+}
+
+ParseResult<util::ArenaPtr<ast::CompoundCommand>> Parser::parseCompoundCommand(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    ParseResult<util::ArenaPtr<ast::CompoundCommand>> retval = ParseFailure();
+    ReservedWord reservedWord;
+    if(*textIter == '(')
+    {
+        retval = parseSubshell(textIter);
     }
-    catch(ParseError &v)
+    else if(!parseReservedWord(copy(textIter), reservedWord))
     {
-        std::cerr << "error: " << v.what() << std::endl;
+        return unexpectedTokenError(textIter);
     }
-    catch(std::system_error &v)
+    else
     {
-        std::cerr << "internal error: " << v.what() << std::endl;
+        switch(reservedWord)
+        {
+        case ReservedWord::LBrace:
+            retval = parseBraceGroup(textIter);
+            break;
+        case ReservedWord::If:
+            retval = parseIfCommand(textIter);
+            break;
+        case ReservedWord::While:
+            retval = parseWhileCommand(textIter, false);
+            break;
+        case ReservedWord::Until:
+            retval = parseWhileCommand(textIter, true);
+            break;
+        case ReservedWord::For:
+            retval = parseForCommand(textIter, false);
+            break;
+        case ReservedWord::Select:
+            retval = parseForCommand(textIter, true);
+            break;
+        case ReservedWord::Case:
+            retval = parseCaseCommand(textIter);
+            break;
+        case ReservedWord::DoubleLBracket:
+            retval = parseConditionalCommand(textIter);
+            break;
+        default:
+            return unexpectedTokenError(textIter);
+        }
+    }
+    if(!retval)
+        return ParseFailure();
+    auto result = parseRedirections(textIter, retval.get()->redirections);
+    if(!result)
+        return ParseFailure();
+    return retval;
+}
+
+ParseResult<util::ArenaPtr<ast::CompoundCommand>> Parser::parseBraceGroup(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    auto result = parseExpectedReservedWord(textIter, ReservedWord::LBrace);
+    if(!result)
+        return ParseFailure();
+    result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    auto body = parseCommandList(textIter, false);
+    if(!body)
+        return ParseFailure();
+    result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    result = parseExpectedReservedWord(textIter, ReservedWord::RBrace);
+    if(!result)
+        return ParseFailure();
+    return parserSuccess(util::ArenaPtr<ast::CompoundCommand>(
+        arena.allocate<ast::BraceGroup>(input::LocationSpan(startLocation, textIter.getLocation()),
+                                        ast::CompoundCommand::Redirections(),
+                                        body.get())));
+}
+
+ParseResult<util::ArenaPtr<ast::CompoundCommand>> Parser::parseSubshell(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    if(*textIter != '(')
+        return expectedTokenError(textIter.getLocation(), "(");
+    ++textIter;
+    if(*textIter == '(')
+        return parserErrorStaticString("arithmetic commands are not supported", startLocation);
+    auto result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    auto body = parseCommandList(textIter, false);
+    if(!body)
+        return ParseFailure();
+    result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    if(*textIter != ')')
+        return expectedTokenError(textIter.getLocation(), ")");
+    ++textIter;
+    return parserSuccess(util::ArenaPtr<ast::CompoundCommand>(
+        arena.allocate<ast::Subshell>(input::LocationSpan(startLocation, textIter.getLocation()),
+                                      ast::CompoundCommand::Redirections(),
+                                      body.get())));
+}
+
+ParseResult<util::ArenaPtr<ast::CompoundCommand>> Parser::parseIfCommand(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    auto result = parseExpectedReservedWord(textIter, ReservedWord::If);
+    if(!result)
+        return ParseFailure();
+    ast::IfCommand::Clauses clauses;
+    util::ArenaPtr<ast::Command> elseBody;
+    for(;;)
+    {
+        result = parseLineBreak(textIter);
+        if(!result)
+            return ParseFailure();
+        auto condition = parseCommandList(textIter, false);
+        if(!condition)
+            return ParseFailure();
+        result = parseLineBreak(textIter);
+        if(!result)
+            return ParseFailure();
+        result = parseExpectedReservedWord(textIter, ReservedWord::Then);
+        if(!result)
+            return ParseFailure();
+        result = parseLineBreak(textIter);
+        if(!result)
+            return ParseFailure();
+        auto body = parseCommandList(textIter, false);
+        if(!body)
+            return ParseFailure();
+        clauses.emplace_back(arena, condition.get(), body.get());
+        result = parseLineBreak(textIter);
+        if(!result)
+            return ParseFailure();
+        ReservedWord reservedWord;
+        if(!parseReservedWord(copy(textIter), reservedWord) || reservedWord != ReservedWord::ElIf)
+            break;
+        parseReservedWord(textIter, reservedWord);
+    }
+    ReservedWord reservedWord;
+    if(parseReservedWord(copy(textIter), reservedWord) && reservedWord == ReservedWord::Else)
+    {
+        parseReservedWord(textIter, reservedWord);
+        result = parseLineBreak(textIter);
+        if(!result)
+            return ParseFailure();
+        auto body = parseCommandList(textIter, false);
+        if(!body)
+            return ParseFailure();
+        elseBody = body.get();
+        result = parseLineBreak(textIter);
+        if(!result)
+            return ParseFailure();
+    }
+    result = parseExpectedReservedWord(textIter, ReservedWord::Fi);
+    if(!result)
+        return ParseFailure();
+    return parserSuccess(util::ArenaPtr<ast::CompoundCommand>(
+        arena.allocate<ast::IfCommand>(input::LocationSpan(startLocation, textIter.getLocation()),
+                                       ast::CompoundCommand::Redirections(),
+                                       std::move(clauses),
+                                       elseBody)));
+}
+
+ParseResult<util::ArenaPtr<ast::Command>> Parser::parseDoGroup(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto result = parseExpectedReservedWord(textIter, ReservedWord::Do);
+    if(!result)
+        return ParseFailure();
+    result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    auto body = parseCommandList(textIter, false);
+    if(!body)
+        return ParseFailure();
+    result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    result = parseExpectedReservedWord(textIter, ReservedWord::Done);
+    if(!result)
+        return ParseFailure();
+    return body;
+}
+
+ParseResult<util::ArenaPtr<ast::CompoundCommand>> Parser::parseWhileCommand(
+    input::LineContinuationRemovingIterator &textIter, bool isUntil)
+{
+    auto startLocation = textIter.getLocation();
+    auto result =
+        parseExpectedReservedWord(textIter, isUntil ? ReservedWord::Until : ReservedWord::While);
+    if(!result)
+        return ParseFailure();
+    result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    auto condition = parseCommandList(textIter, false);
+    if(!condition)
+        return ParseFailure();
+    result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    auto body = parseDoGroup(textIter);
+    if(!body)
+        return ParseFailure();
+    return parserSuccess(util::ArenaPtr<ast::CompoundCommand>(arena.allocate<ast::WhileCommand>(
+        input::LocationSpan(startLocation, textIter.getLocation()),
+        ast::CompoundCommand::Redirections(),
+        isUntil,
+        condition.get(),
+        body.get())));
+}
+
+ParseResult<util::ArenaPtr<ast::CompoundCommand>> Parser::parseForCommand(
+    input::LineContinuationRemovingIterator &textIter, bool isSelect)
+{
+    auto startLocation = textIter.getLocation();
+    auto result =
+        parseExpectedReservedWord(textIter, isSelect ? ReservedWord::Select : ReservedWord::For);
+    if(!result)
+        return ParseFailure();
+    skipBlanks(textIter);
+    if(!isSelect && *textIter == '(')
+    {
+        auto textIter2 = textIter;
+        ++textIter2;
+        if(*textIter2 == '(')
+            return parserErrorStaticString("arithmetic for loops are not supported", startLocation);
+    }
+    if(!isAtWordStart(textIter))
+        return unexpectedTokenError(textIter);
+    auto nameLocation = textIter.getLocation();
+    auto name = parseWord(textIter, 0, false, false);
+    if(!name)
+        return ParseFailure();
+    if(!isNameWord(*name.get()))
+        return parserErrorStaticString("invalid variable name", nameLocation);
+    internLiteralSymbol(*name.get());
+    bool hasWordList = false;
+    ast::ForCommand::Words words;
+    skipBlanks(textIter);
+    ControlOperator controlOperator;
+    auto textIter2 = textIter;
+    if(parseControlOperator(textIter2, controlOperator)
+       && controlOperator == ControlOperator::Semicolon)
+    {
+        textIter = textIter2;
+    }
+    else
+    {
+        result = parseLineBreak(textIter);
+        if(!result)
+            return ParseFailure();
+        ReservedWord reservedWord;
+        if(parseReservedWord(copy(textIter), reservedWord) && reservedWord == ReservedWord::In)
+        {
+            parseReservedWord(textIter, reservedWord);
+            hasWordList = true;
+            for(;;)
+            {
+                skipBlanks(textIter);
+                if(!isAtWordStart(textIter))
+                    break;
+                auto word = parseWord(textIter, 0, false, false);
+                if(!word)
+                    return ParseFailure();
+                words.push_back(arena, word.get());
+            }
+            textIter2 = textIter;
+            if(parseControlOperator(textIter2, controlOperator)
+               && controlOperator == ControlOperator::Semicolon)
+                textIter = textIter2;
+            else if(!isAtNewLine(textIter) && *textIter != '#')
+                return unexpectedTokenError(textIter);
+        }
+    }
+    result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    auto body = parseDoGroup(textIter);
+    if(!body)
+        return ParseFailure();
+    return parserSuccess(util::ArenaPtr<ast::CompoundCommand>(
+        arena.allocate<ast::ForCommand>(input::LocationSpan(startLocation, textIter.getLocation()),
+                                        ast::CompoundCommand::Redirections(),
+                                        isSelect,
+                                        name.get(),
+                                        hasWordList,
+                                        std::move(words),
+                                        body.get())));
+}
+
+ParseResult<util::ArenaPtr<ast::CompoundCommand>> Parser::parseCaseCommand(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    typedef ast::CaseItem::Terminator Terminator;
+    auto startLocation = textIter.getLocation();
+    auto result = parseExpectedReservedWord(textIter, ReservedWord::Case);
+    if(!result)
+        return ParseFailure();
+    skipBlanks(textIter);
+    if(!isAtWordStart(textIter))
+        return unexpectedTokenError(textIter);
+    auto word = parseWord(textIter, 0, false, false);
+    if(!word)
+        return ParseFailure();
+    result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    result = parseExpectedReservedWord(textIter, ReservedWord::In);
+    if(!result)
+        return ParseFailure();
+    ast::CaseCommand::Items items;
+    for(;;)
+    {
+        result = parseLineBreak(textIter);
+        if(!result)
+            return ParseFailure();
+        if(isAtReservedWord(textIter, ReservedWord::Esac))
+            break;
+        auto itemStartLocation = textIter.getLocation();
+        if(*textIter == '(')
+        {
+            ++textIter;
+            skipBlanks(textIter);
+        }
+        ast::CaseItem::Patterns patterns;
+        for(;;)
+        {
+            if(!isAtWordStart(textIter))
+                return unexpectedTokenError(textIter);
+            auto pattern = parseWord(textIter, 0, false, false);
+            if(!pattern)
+                return ParseFailure();
+            patterns.push_back(arena, pattern.get());
+            skipBlanks(textIter);
+            ControlOperator controlOperator;
+            auto textIter2 = textIter;
+            if(!parseControlOperator(textIter2, controlOperator)
+               || controlOperator != ControlOperator::Pipe)
+                break;
+            textIter = textIter2;
+            skipBlanks(textIter);
+        }
+        if(*textIter != ')')
+            return expectedTokenError(textIter.getLocation(), ")");
+        ++textIter;
+        result = parseLineBreak(textIter);
+        if(!result)
+            return ParseFailure();
+        util::ArenaPtr<ast::Command> body;
+        if(!isAtCompoundListEnd(textIter))
+        {
+            auto list = parseCommandList(textIter, false);
+            if(!list)
+                return ParseFailure();
+            body = list.get();
+            result = parseLineBreak(textIter);
+            if(!result)
+                return ParseFailure();
+        }
+        auto terminator = Terminator::None;
+        ControlOperator controlOperator;
+        auto textIter2 = textIter;
+        if(parseControlOperator(textIter2, controlOperator))
+        {
+            switch(controlOperator)
+            {
+            case ControlOperator::DoubleSemicolon:
+                terminator = Terminator::Break;
+                break;
+            case ControlOperator::SemicolonAmpersand:
+                terminator = Terminator::FallThrough;
+                break;
+            case ControlOperator::DoubleSemicolonAmpersand:
+                terminator = Terminator::Continue;
+                break;
+            default:
+                return unexpectedTokenError(textIter);
+            }
+            textIter = textIter2;
+        }
+        else if(!isAtReservedWord(textIter, ReservedWord::Esac))
+        {
+            return expectedTokenError(textIter.getLocation(), ";;");
+        }
+        items.push_back(arena,
+                        arena.allocate<ast::CaseItem>(
+                            input::LocationSpan(itemStartLocation, textIter.getLocation()),
+                            std::move(patterns),
+                            body,
+                            terminator));
+        if(terminator == Terminator::None)
+            break;
+    }
+    result = parseExpectedReservedWord(textIter, ReservedWord::Esac);
+    if(!result)
+        return ParseFailure();
+    return parserSuccess(util::ArenaPtr<ast::CompoundCommand>(arena.allocate<ast::CaseCommand>(
+        input::LocationSpan(startLocation, textIter.getLocation()),
+        ast::CompoundCommand::Redirections(),
+        word.get(),
+        std::move(items))));
+}
+
+bool Parser::parseConditionalOperator(input::LineContinuationRemovingIterator &textIter,
+                                      bool isBinary,
+                                      util::string_view &operatorText)
+{
+    static const char *const unaryOperators[] = {
+        "-a", "-b", "-c", "-d", "-e", "-f", "-g", "-h", "-k", "-n", "-o", "-p", "-r",
+        "-s", "-t", "-u", "-v", "-w", "-x", "-z", "-G", "-L", "-N", "-O", "-R", "-S",
+    };
+    static const char *const binaryOperators[] = {
+        "==", "=", "!=", "=~", "-eq", "-ne", "-lt", "-le", "-gt", "-ge", "-nt", "-ot", "-ef",
+    };
+    char buffer[4];
+    std::size_t size = 0;
+    auto textIter2 = textIter;
+    while(size < sizeof(buffer))
+    {
+        if(!(getCharacterClasses(textIter2) & CharacterClass::simpleWordContinue)
+           && *textIter2 != '!')
+            break;
+        buffer[size++] = static_cast<char>(*textIter2);
+        ++textIter2;
+    }
+    if(size == 0 || !isUnquotedWordEndCharacter(textIter2, 0))
+        return false;
+    auto text = util::string_view(buffer, size);
+    if(isBinary)
+    {
+        for(const char *op : binaryOperators)
+        {
+            if(text == op)
+            {
+                operatorText = op;
+                textIter = textIter2;
+                return true;
+            }
+        }
+        return false;
+    }
+    for(const char *op : unaryOperators)
+    {
+        if(text == op)
+        {
+            operatorText = op;
+            textIter = textIter2;
+            return true;
+        }
+    }
+    return false;
+}
+
+ParseResult<util::ArenaPtr<ast::CompoundCommand>> Parser::parseConditionalCommand(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    auto result = parseExpectedReservedWord(textIter, ReservedWord::DoubleLBracket);
+    if(!result)
+        return ParseFailure();
+    result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    auto expression = parseConditionalOrExpression(textIter);
+    if(!expression)
+        return ParseFailure();
+    result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    result = parseExpectedReservedWord(textIter, ReservedWord::DoubleRBracket);
+    if(!result)
+        return ParseFailure();
+    return parserSuccess(util::ArenaPtr<ast::CompoundCommand>(
+        arena.allocate<ast::ConditionalCommand>(
+            input::LocationSpan(startLocation, textIter.getLocation()),
+            ast::CompoundCommand::Redirections(),
+            expression.get())));
+}
+
+ParseResult<util::ArenaPtr<ast::ConditionalExpression>> Parser::parseConditionalOrExpression(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    auto retval = parseConditionalAndExpression(textIter);
+    if(!retval)
+        return ParseFailure();
+    for(;;)
+    {
+        auto textIter2 = textIter;
+        auto result = parseLineBreak(textIter2);
+        if(!result)
+            return ParseFailure();
+        ControlOperator controlOperator;
+        if(!parseControlOperator(textIter2, controlOperator)
+           || controlOperator != ControlOperator::DoublePipe)
+            break;
+        result = parseLineBreak(textIter2);
+        if(!result)
+            return ParseFailure();
+        auto right = parseConditionalAndExpression(textIter2);
+        if(!right)
+            return ParseFailure();
+        textIter = textIter2;
+        retval = util::ArenaPtr<ast::ConditionalExpression>(
+            arena.allocate<ast::ConditionalAndOrExpression>(
+                input::LocationSpan(startLocation, textIter.getLocation()),
+                true,
+                retval.get(),
+                right.get()));
+    }
+    return retval;
+}
+
+ParseResult<util::ArenaPtr<ast::ConditionalExpression>> Parser::parseConditionalAndExpression(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    auto retval = parseConditionalNotExpression(textIter);
+    if(!retval)
+        return ParseFailure();
+    for(;;)
+    {
+        auto textIter2 = textIter;
+        auto result = parseLineBreak(textIter2);
+        if(!result)
+            return ParseFailure();
+        ControlOperator controlOperator;
+        if(!parseControlOperator(textIter2, controlOperator)
+           || controlOperator != ControlOperator::DoubleAmpersand)
+            break;
+        result = parseLineBreak(textIter2);
+        if(!result)
+            return ParseFailure();
+        auto right = parseConditionalNotExpression(textIter2);
+        if(!right)
+            return ParseFailure();
+        textIter = textIter2;
+        retval = util::ArenaPtr<ast::ConditionalExpression>(
+            arena.allocate<ast::ConditionalAndOrExpression>(
+                input::LocationSpan(startLocation, textIter.getLocation()),
+                false,
+                retval.get(),
+                right.get()));
+    }
+    return retval;
+}
+
+ParseResult<util::ArenaPtr<ast::ConditionalExpression>> Parser::parseConditionalNotExpression(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    if(!isAtReservedWord(textIter, ReservedWord::ExMark))
+        return parseConditionalPrimaryExpression(textIter);
+    ReservedWord reservedWord;
+    parseReservedWord(textIter, reservedWord);
+    auto result = parseLineBreak(textIter);
+    if(!result)
+        return ParseFailure();
+    auto operand = parseConditionalNotExpression(textIter);
+    if(!operand)
+        return ParseFailure();
+    return parserSuccess(
+        util::ArenaPtr<ast::ConditionalExpression>(arena.allocate<ast::ConditionalNotExpression>(
+            input::LocationSpan(startLocation, textIter.getLocation()), operand.get())));
+}
+
+ParseResult<util::ArenaPtr<ast::ConditionalExpression>> Parser::parseConditionalPrimaryExpression(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    auto startLocation = textIter.getLocation();
+    if(*textIter == '(')
+    {
+        ++textIter;
+        auto result = parseLineBreak(textIter);
+        if(!result)
+            return ParseFailure();
+        auto retval = parseConditionalOrExpression(textIter);
+        if(!retval)
+            return ParseFailure();
+        result = parseLineBreak(textIter);
+        if(!result)
+            return ParseFailure();
+        if(*textIter != ')')
+            return expectedTokenError(textIter.getLocation(), ")");
+        ++textIter;
+        return retval;
+    }
+    if(!isAtWordStart(textIter) || isAtReservedWord(textIter, ReservedWord::DoubleRBracket))
+        return unexpectedTokenError(textIter);
+    util::string_view operatorText;
+    auto textIter2 = textIter;
+    if(parseConditionalOperator(textIter2, false, operatorText))
+    {
+        // `-f` is just a word if it isn't followed by an operand, like in `[[ -f ]]`
+        skipBlanks(textIter2);
+        if(isAtWordStart(textIter2) && !isAtReservedWord(textIter2, ReservedWord::DoubleRBracket))
+        {
+            textIter = textIter2;
+            auto operand = parseWord(textIter, 0, false, false);
+            if(!operand)
+                return ParseFailure();
+            return parserSuccess(util::ArenaPtr<ast::ConditionalExpression>(
+                arena.allocate<ast::ConditionalUnaryExpression>(
+                    input::LocationSpan(startLocation, textIter.getLocation()),
+                    operatorText,
+                    operand.get())));
+        }
+    }
+    auto left = parseWord(textIter, 0, false, false);
+    if(!left)
+        return ParseFailure();
+    textIter2 = textIter;
+    skipBlanks(textIter2);
+    if(*textIter2 == '<' || *textIter2 == '>')
+    {
+        operatorText = *textIter2 == '<' ? "<" : ">";
+        ++textIter2;
+    }
+    else if(!parseConditionalOperator(textIter2, true, operatorText))
+    {
+        return parserSuccess(util::ArenaPtr<ast::ConditionalExpression>(
+            arena.allocate<ast::ConditionalWordExpression>(
+                input::LocationSpan(startLocation, textIter.getLocation()), left.get())));
+    }
+    skipBlanks(textIter2);
+    if(!isAtWordStart(textIter2) || isAtReservedWord(textIter2, ReservedWord::DoubleRBracket))
+        return unexpectedTokenError(textIter2);
+    textIter = textIter2;
+    auto right = parseWord(textIter, 0, false, false);
+    if(!right)
+        return ParseFailure();
+    return parserSuccess(util::ArenaPtr<ast::ConditionalExpression>(
+        arena.allocate<ast::ConditionalBinaryExpression>(
+            input::LocationSpan(startLocation, textIter.getLocation()),
+            left.get(),
+            operatorText,
+            right.get())));
+}
+
+Token Parser::skipScanToToken(std::size_t index, Token::Kind kind, bool backslashEscapes)
+{
+    TokenStream tokens(textInput, index);
+    for(;;)
+    {
+        auto token = tokens.get();
+        if(token.kind == kind || token.kind == Token::Kind::EndOfFile)
+            return token;
+        // a backslash only escapes one character, but nothing after the first character of a
+        // token can be special, so the whole token can be skipped
+        if(backslashEscapes && token.kind == Token::Kind::Backslash)
+            tokens.get();
+    }
+}
+
+bool Parser::skipScanBackquote(input::LineContinuationRemovingIterator &textIter)
+{
+    auto closingBackquote = skipScanToToken(getTextIndex(textIter), Token::Kind::Backquote, true);
+    if(closingBackquote.kind == Token::Kind::EndOfFile)
+        return false;
+    textIter = input::LineContinuationRemovingIterator(
+        textInput.iteratorAt(closingBackquote.getEndIndex()));
+    return true;
+}
+
+bool Parser::skipScanArithmetic(input::LineContinuationRemovingIterator &textIter,
+                                std::vector<SkipScanHereDocument> &hereDocuments)
+{
+    std::size_t nestLevel = 0;
+    for(;;)
+    {
+        switch(*textIter)
+        {
+        case input::eof:
+            return false;
+        case '(':
+            ++textIter;
+            nestLevel++;
+            break;
+        case ')':
+            ++textIter;
+            if(nestLevel > 0)
+            {
+                nestLevel--;
+                break;
+            }
+            if(*textIter != ')')
+                return false;
+            ++textIter;
+            return true;
+        case '\'':
+        case '\"':
+        case '\\':
+        case '$':
+        case '`':
+            if(!skipScanWord(textIter, hereDocuments))
+                return false;
+            break;
+        default:
+            ++textIter;
+            break;
+        }
+    }
+}
+
+bool Parser::skipScanDollar(input::LineContinuationRemovingIterator &textIter,
+                            std::vector<SkipScanHereDocument> &hereDocuments)
+{
+    assert(*textIter == '$');
+    ++textIter;
+    if(*textIter == '\'')
+    {
+        ++textIter;
+        for(;;)
+        {
+            if(*textIter == input::eof)
+                return false;
+            if(*textIter == '\'')
+            {
+                ++textIter;
+                return true;
+            }
+            if(*textIter == '\\')
+                ++textIter;
+            ++textIter;
+        }
+    }
+    if(*textIter == '\"')
+    {
+        ++textIter;
+        return skipScanDoubleQuoteString(textIter, hereDocuments, nullptr);
+    }
+    if(*textIter == '(')
+    {
+        ++textIter;
+        if(*textIter == '(')
+        {
+            ++textIter;
+            return skipScanArithmetic(textIter, hereDocuments);
+        }
+        return skipScanCommands(textIter, ')', hereDocuments);
+    }
+    if(*textIter != '{')
+        return true; // a simple parameter name is just part of the word
+    ++textIter;
+    std::size_t nestLevel = 0;
+    for(;;)
+    {
+        switch(*textIter)
+        {
+        case input::eof:
+            return false;
+        case '{':
+            ++textIter;
+            nestLevel++;
+            break;
+        case '}':
+            ++textIter;
+            if(nestLevel == 0)
+                return true;
+            nestLevel--;
+            break;
+        case '\'':
+        case '\"':
+        case '\\':
+        case '$':
+        case '`':
+            if(!skipScanWord(textIter, hereDocuments))
+                return false;
+            break;
+        default:
+            ++textIter;
+            break;
+        }
+    }
+}
+
+bool Parser::skipScanDoubleQuoteString(input::LineContinuationRemovingIterator &textIter,
+                                       std::vector<SkipScanHereDocument> &hereDocuments,
+                                       std::string *text)
+{
+    for(;;)
+    {
+        switch(*textIter)
+        {
+        case input::eof:
+            return false;
+        case '\"':
+            ++textIter;
+            return true;
+        case '\\':
+            ++textIter;
+            if(*textIter == input::eof)
+                return false;
+            if(text)
+                *text += static_cast<char>(*textIter);
+            ++textIter;
+            break;
+        case '$':
+            if(!skipScanDollar(textIter, hereDocuments))
+                return false;
+            break;
+        case '`':
+            ++textIter;
+            if(!skipScanBackquote(textIter))
+                return false;
+            break;
+        default:
+            if(text)
+                *text += static_cast<char>(*textIter);
+            ++textIter;
+            break;
+        }
+    }
+}
+
+bool Parser::skipScanWord(input::LineContinuationRemovingIterator &textIter,
+                          std::vector<SkipScanHereDocument> &hereDocuments,
+                          std::string *text)
+{
+    if(isUnquotedWordEndCharacter(textIter, 0))
+        return false;
+    // the word's text doesn't matter unless it's a here-document delimiter
+    do
+    {
+        switch(*textIter)
+        {
+        case '\\':
+            ++textIter;
+            if(*textIter == input::eof)
+                return false;
+            if(text)
+                *text += static_cast<char>(*textIter);
+            ++textIter;
+            break;
+        case '\'':
+        {
+            // line continuations aren't removed in single quotes
+            auto baseTextIter = textIter.getBaseIterator();
+            ++baseTextIter;
+            auto closingQuote =
+                skipScanToToken(getTextIndex(baseTextIter), Token::Kind::SingleQuote, false);
+            if(closingQuote.kind == Token::Kind::EndOfFile)
+                return false;
+            if(text)
+                for(; getTextIndex(baseTextIter) < closingQuote.beginIndex; ++baseTextIter)
+                    *text += static_cast<char>(*baseTextIter);
+            textIter = input::LineContinuationRemovingIterator(
+                textInput.iteratorAt(closingQuote.getEndIndex()));
+            break;
+        }
+        case '\"':
+            ++textIter;
+            if(!skipScanDoubleQuoteString(textIter, hereDocuments, text))
+                return false;
+            break;
+        case '$':
+            if(!skipScanDollar(textIter, hereDocuments))
+                return false;
+            break;
+        case '`':
+            ++textIter;
+            if(!skipScanBackquote(textIter))
+                return false;
+            break;
+        default:
+            if(text)
+            {
+                *text += static_cast<char>(*textIter);
+                ++textIter;
+                break;
+            }
+            ++textIter;
+            // most words are short, so only long ones are worth a search for their end
+            for(std::size_t count = 0;
+                getCharacterClasses(textIter) & CharacterClass::simpleWordContinue;
+                count++)
+            {
+                if(count >= 8)
+                {
+                    // the same bytes that end a run of simple word characters in
+                    // `parseWordHelper`
+                    skipToFirstByteOf<'\"',
+                                      '\'',
+                                      '!',
+                                      '$',
+                                      '`',
+                                      '\\',
+                                      '|',
+                                      '&',
+                                      ';',
+                                      '(',
+                                      ')',
+                                      '<',
+                                      '>',
+                                      ' ',
+                                      '\t',
+                                      '\r',
+                                      '\n'>(textIter);
+                    break;
+                }
+                ++textIter;
+            }
+            break;
+        }
+    } while(!isUnquotedWordEndCharacter(textIter, 0));
+    return true;
+}
+
+bool Parser::skipScanCommands(input::LineContinuationRemovingIterator &textIter,
+                              char closer,
+                              std::vector<SkipScanHereDocument> &hereDocuments)
+{
+    // what the innermost open construct is: `}` or `)` for its closer, `c` for the commands in a
+    // `case` item, `p` for `case` patterns, `[` for `[[ ]]`, `f` for `if ... fi`, `w` for a loop
+    // before its `do`, `d` for `do ... done`, and `\n` for a top-level command
+    std::string nesting(1, closer);
+    bool isCommandPosition = true;
+    // `for name do` doesn't need a separator before `do`
+    bool isAfterForName = false;
+    // after `&&`, `||`, `|` or a function's name, the command continues on the next line
+    bool isLineContinued = false;
+    bool isAfterLParen = false;
+    for(;;)
+    {
+        skipBlanks(textIter);
+        if(*textIter == input::eof)
+            return false;
+        if(isAtNewLine(textIter))
+        {
+            auto baseTextIter = textIter.getBaseIterator();
+            parseNewLine(baseTextIter);
+            for(auto &hereDocument : hereDocuments)
+            {
+                input::Location bodyEndLocation;
+                if(!parseHereDocumentBody(baseTextIter,
+                                          hereDocument.delimiter,
+                                          hereDocument.stripTabs,
+                                          bodyEndLocation))
+                    return false;
+            }
+            hereDocuments.clear();
+            textIter = input::LineContinuationRemovingIterator(baseTextIter);
+            if(nesting.back() == '\n' && !isLineContinued)
+                return true;
+            if(nesting.back() != 'p')
+                isCommandPosition = true;
+            continue;
+        }
+        if(nesting.back() == '[')
+        {
+            if(isAtReservedWord(textIter, ReservedWord::DoubleRBracket))
+            {
+                ReservedWord reservedWord;
+                parseReservedWord(textIter, reservedWord);
+                nesting.pop_back();
+                isCommandPosition = false;
+            }
+            else if(getCharacterClasses(textIter) & CharacterClass::metacharacter)
+            {
+                ++textIter;
+            }
+            else if(!skipScanWord(textIter, hereDocuments))
+            {
+                return false;
+            }
+            continue;
+        }
+        if(*textIter == '#')
+        {
+            // like `parseComment`, a comment ends at the first newline even after a backslash
+            auto newLine = skipScanToToken(getTextIndex(textIter), Token::Kind::NewLine, false);
+            textIter =
+                input::LineContinuationRemovingIterator(textInput.iteratorAt(newLine.beginIndex));
+            continue;
+        }
+        ControlOperator controlOperator;
+        if(parseControlOperator(textIter, controlOperator))
+        {
+            bool wasAfterLParen = isAfterLParen;
+            isAfterForName = false;
+            isLineContinued = false;
+            isAfterLParen = false;
+            switch(controlOperator)
+            {
+            case ControlOperator::LParen:
+                if(nesting.back() == 'p')
+                    break;
+                if(isCommandPosition && *textIter == '(')
+                {
+                    ++textIter;
+                    if(!skipScanArithmetic(textIter, hereDocuments))
+                        return false;
+                    isCommandPosition = false;
+                    break;
+                }
+                nesting += ')';
+                isCommandPosition = true;
+                isAfterLParen = true;
+                break;
+            case ControlOperator::RParen:
+                if(nesting.back() == 'p')
+                {
+                    nesting.back() = 'c';
+                    isCommandPosition = true;
+                    break;
+                }
+                if(nesting.back() != ')')
+                    return false;
+                nesting.pop_back();
+                if(nesting.empty())
+                    return hereDocuments.empty();
+                // for `name() { ... }`
+                isCommandPosition = true;
+                isLineContinued = wasAfterLParen;
+                break;
+            case ControlOperator::DoubleAmpersand:
+            case ControlOperator::DoublePipe:
+            case ControlOperator::Pipe:
+            case ControlOperator::PipeAmpersand:
+                isCommandPosition = true;
+                isLineContinued = true;
+                break;
+            case ControlOperator::DoubleSemicolon:
+            case ControlOperator::SemicolonAmpersand:
+            case ControlOperator::DoubleSemicolonAmpersand:
+                if(nesting.back() != 'c')
+                    return false;
+                nesting.back() = 'p';
+                isCommandPosition = false;
+                break;
+            default:
+                if(nesting.back() != 'p')
+                    isCommandPosition = true;
+                break;
+            }
+            continue;
+        }
+        isLineContinued = false;
+        isAfterLParen = false;
+        int fileDescriptor;
+        ast::Redirection::Kind kind;
+        if(parseRedirectionOperator(textIter, fileDescriptor, kind))
+        {
+            skipBlanks(textIter);
+            std::string delimiter;
+            if(!skipScanWord(
+                   textIter, hereDocuments, ast::Redirection::isHereDocument(kind) ? &delimiter :
+                                                                                      nullptr))
+                return false;
+            if(ast::Redirection::isHereDocument(kind))
+                hereDocuments.emplace_back(
+                    std::move(delimiter), kind == ast::Redirection::Kind::HereDocumentStripTabs);
+            continue;
+        }
+        ReservedWord reservedWord;
+        if(nesting.back() == 'p')
+        {
+            if(isAtReservedWord(textIter, ReservedWord::Esac))
+            {
+                parseReservedWord(textIter, reservedWord);
+                nesting.pop_back();
+                isCommandPosition = false;
+            }
+            else if(!skipScanWord(textIter, hereDocuments))
+            {
+                return false;
+            }
+            continue;
+        }
+        if((isCommandPosition || isAfterForName) && parseReservedWord(copy(textIter), reservedWord))
+        {
+            if(isAfterForName && reservedWord != ReservedWord::Do
+               && reservedWord != ReservedWord::In)
+                return false;
+            parseReservedWord(textIter, reservedWord);
+            isAfterForName = false;
+            isCommandPosition = true;
+            switch(reservedWord)
+            {
+            case ReservedWord::LBrace:
+                nesting += '}';
+                break;
+            case ReservedWord::RBrace:
+                if(nesting.back() != '}')
+                    return false;
+                nesting.pop_back();
+                if(nesting.empty())
+                    return hereDocuments.empty();
+                isCommandPosition = false;
+                break;
+            case ReservedWord::If:
+                nesting += 'f';
+                break;
+            case ReservedWord::Fi:
+                if(nesting.back() != 'f')
+                    return false;
+                nesting.pop_back();
+                isCommandPosition = false;
+                break;
+            case ReservedWord::While:
+            case ReservedWord::Until:
+                nesting += 'w';
+                break;
+            case ReservedWord::Do:
+                if(nesting.back() != 'w')
+                    return false;
+                nesting.back() = 'd';
+                break;
+            case ReservedWord::Done:
+                if(nesting.back() != 'd')
+                    return false;
+                nesting.pop_back();
+                isCommandPosition = false;
+                break;
+            case ReservedWord::Esac:
+                if(nesting.back() != 'c')
+                    return false;
+                nesting.pop_back();
+                isCommandPosition = false;
+                break;
+            case ReservedWord::DoubleLBracket:
+                nesting += '[';
+                break;
+            case ReservedWord::In:
+                // the words of a `for` loop
+                isCommandPosition = false;
+                break;
+            case ReservedWord::For:
+            case ReservedWord::Select:
+            case ReservedWord::Function:
+                skipBlanks(textIter);
+                if(*textIter == '(')
+                    return false; // `for ((`
+                if(!skipScanWord(textIter, hereDocuments))
+                    return false;
+                isAfterForName = reservedWord != ReservedWord::Function;
+                if(isAfterForName)
+                    nesting += 'w';
+                else
+                    isLineContinued = true;
+                break;
+            case ReservedWord::Case:
+                skipBlanks(textIter);
+                if(!skipScanWord(textIter, hereDocuments))
+                    return false;
+                skipBlanks(textIter);
+                while(isAtNewLine(textIter))
+                {
+                    if(!hereDocuments.empty())
+                        return false;
+                    parseNewLine(textIter);
+                    skipBlanks(textIter);
+                }
+                if(!parseReservedWord(textIter, reservedWord) || reservedWord != ReservedWord::In)
+                    return false;
+                nesting += 'p';
+                isCommandPosition = false;
+                break;
+            default:
+                break;
+            }
+            continue;
+        }
+        if(!skipScanWord(textIter, hereDocuments))
+            return false;
+        isCommandPosition = false;
+    }
+}
+
+ParseResult<util::ArenaPtr<ast::CompoundCommand>> Parser::parseFunctionBody(
+    input::LineContinuationRemovingIterator &textIter)
+{
+    if(parseFunctionBodiesLazily)
+    {
+        auto startLocation = textIter.getLocation();
+        auto textIter2 = textIter;
+        char closer = '\0';
+        ReservedWord reservedWord;
+        if(*textIter2 == '(')
+        {
+            ++textIter2;
+            if(*textIter2 != '(')
+                closer = ')';
+        }
+        else if(parseReservedWord(textIter2, reservedWord) && reservedWord == ReservedWord::LBrace)
+        {
+            closer = '}';
+        }
+        std::vector<SkipScanHereDocument> hereDocuments;
+        if(closer && skipScanCommands(textIter2, closer, hereDocuments))
+        {
+            textIter = textIter2;
+            auto retval = arena.allocate<ast::LazyFunctionBody>(
+                input::LocationSpan(startLocation, textIter.getLocation()),
+                ast::CompoundCommand::Redirections());
+            auto result = parseRedirections(textIter, retval->redirections);
+            if(!result)
+                return ParseFailure();
+            return parserSuccess(util::ArenaPtr<ast::CompoundCommand>(retval));
+        }
+        // parse it now, which also reports any syntax errors
+    }
+    return parseCompoundCommand(textIter);
+}
+
+std::vector<std::size_t> Parser::findTopLevelSplitPoints(std::size_t minimumRegionSize)
+{
+    std::vector<std::size_t> retval;
+    auto textIter = topLevelTextIter;
+    std::size_t regionStartIndex = getTextIndex(textIter);
+    std::vector<SkipScanHereDocument> hereDocuments;
+    while(*textIter != input::eof)
+    {
+        hereDocuments.clear();
+        if(!skipScanCommands(textIter, '\n', hereDocuments))
+            break;
+        std::size_t index = getTextIndex(textIter);
+        if(index - regionStartIndex >= minimumRegionSize)
+        {
+            retval.push_back(index);
+            regionStartIndex = index;
+        }
+    }
+    return retval;
+}
+
+void Parser::throwTopLevelParseError()
+{
+    // continue with the line after the error
+    pendingHereDocuments.clear();
+    auto textIter = textInput.iteratorAt(lastError.location.index);
+    while(*textIter != input::eof && !parseNewLine(textIter))
+        ++textIter;
+    topLevelTextIter = input::LineContinuationRemovingIterator(textIter);
+    throwParseError();
+}
+
+ParseCommandResult Parser::parseTopLevelCommand(util::ArenaPtr<ast::Command> &command)
+{
+    auto &textIter = topLevelTextIter;
+    skipBlanks(textIter);
+    if(*textIter == '#')
+    {
+        if(!parseComment(textIter, 0))
+            throwTopLevelParseError();
+    }
+    if(*textIter == input::eof)
+        return ParseCommandResult::Quit;
+    if(isAtNewLine(textIter))
+    {
+        parseNewLine(textIter);
+        return ParseCommandResult::NoCommand;
+    }
+    auto result = parseCommandList(textIter, true);
+    if(!result)
+        throwTopLevelParseError();
+    skipBlanks(textIter);
+    if(*textIter == '#')
+    {
+        if(!parseComment(textIter, 0))
+            throwTopLevelParseError();
+    }
+    if(isAtNewLine(textIter))
+    {
+        if(!parseNewLineAndHereDocuments(textIter))
+            throwTopLevelParseError();
+    }
+    else if(*textIter == input::eof)
+    {
+        auto baseTextIter = textIter.getBaseIterator();
+        if(!parseHereDocumentBodies(baseTextIter))
+            throwTopLevelParseError();
+    }
+    else
+    {
+        unexpectedTokenError(textIter);
+        throwTopLevelParseError();
+    }
+    command = result.get();
+    return ParseCommandResult::Success;
+}
+
+util::ArenaPtr<ast::CompoundCommand> Parser::getFunctionBody(
+    ast::FunctionDefinition &functionDefinition)
+{
+    auto lazyBody = util::dynamic_pointer_cast<ast::LazyFunctionBody>(functionDefinition.body);
+    if(!lazyBody)
+        return functionDefinition.body;
+    auto textIter = input::LineContinuationRemovingIterator(
+        textInput.iteratorAt(lazyBody->getSimpleLocationSpan().beginIndex));
+    // the body may be needed while in the middle of parsing something else
+    std::vector<util::ArenaPtr<ast::Redirection>> savedPendingHereDocuments;
+    savedPendingHereDocuments.swap(pendingHereDocuments);
+    auto body = *textIter == '(' ? parseSubshell(textIter) : parseBraceGroup(textIter);
+    pendingHereDocuments.swap(savedPendingHereDocuments);
+    if(!body)
+        throwParseError();
+    body.get()->redirections = ast::CompoundCommand::Redirections(lazyBody->redirections, arena);
+    functionDefinition.body = body.get();
+    return body.get();
+}
+
+void Parser::test()
+{
+    for(;;)
+    {
+        auto checkpointValue = checkpoint();
+        try
+        {
+            util::ArenaPtr<ast::Command> command;
+            auto result = parseTopLevelCommand(command);
+            if(result == ParseCommandResult::Quit)
+                break;
+            if(result == ParseCommandResult::Success)
+            {
+                ast::ASTDumpState dumpState;
+                command->dump(std::cout, dumpState);
+                std::cout.flush();
+            }
+        }
+        catch(ParseError &v)
+        {
+            std::cerr << "error: " << v.what() << std::endl;
+        }
+        catch(std::system_error &v)
+        {
+            std::cerr << "internal error: " << v.what() << std::endl;
+            break;
+        }
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+        arena.dumpStats(std::cerr);
+#endif
+        rollbackTo(checkpointValue);
+        // nothing refers to the text before the next command anymore, so a streamed input can
+        // release it
+        textInput.setLowWaterMark(getTopLevelIndex());
     }
 }
 }
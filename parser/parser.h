@@ -23,6 +23,8 @@
 #include <stdexcept>
 #include <type_traits>
 #include <limits>
+#include <cstring>
+#include <string>
 #include "../util/compiler_intrinsics.h"
 #include "../input/text_input.h"
 #include "../input/location.h"
@@ -32,8 +34,15 @@
 #include "../ast/word.h"
 #include "../ast/word_part.h"
 #include "../ast/comment.h"
+#include "../ast/command.h"
+#include "../ast/redirection.h"
+#include "../ast/conditional_expression.h"
 #include "../util/arena.h"
+#include "../util/symbol_table.h"
 #include "../util/unicode.h"
+#include "character_class.h"
+#include "lexer.h"
+#include "reserved_word.h"
 
 namespace quick_shell
 {
@@ -149,23 +158,258 @@ public:
     }
 };
 
+/** converts to a failed `ParseResult` of any type. The error itself is kept by the `Parser`, so
+ * failed results don't need to carry it. */
+struct ParseFailure final
+{
+};
+
+/** the result of a parse function that can fail: a `T` on success.
+ *
+ * A failed result only records that it failed; the `Parser` keeps the error until it's thrown,
+ * so results stay small enough to be returned in registers.
+ * */
+template <typename T = void>
+class ParseResult final
+{
+private:
+    T value;
+    bool success;
+
+public:
+    constexpr ParseResult(ParseFailure) noexcept : value(), success(false)
+    {
+    }
+    ParseResult(T value) : value(std::move(value)), success(true)
+    {
+    }
+    constexpr bool isError() const noexcept
+    {
+        return !success;
+    }
+    constexpr bool isSuccess() const noexcept
+    {
+        return success;
+    }
+    constexpr explicit operator bool() const noexcept
+    {
+        return success;
+    }
+    T &get() noexcept
+    {
+        assert(success);
+        return value;
+    }
+};
+
+template <>
+class ParseResult<void> final
+{
+private:
+    bool success;
+
+public:
+    constexpr ParseResult() noexcept : success(true)
+    {
+    }
+    constexpr ParseResult(ParseFailure) noexcept : success(false)
+    {
+    }
+    constexpr bool isError() const noexcept
+    {
+        return !success;
+    }
+    constexpr bool isSuccess() const noexcept
+    {
+        return success;
+    }
+    constexpr explicit operator bool() const noexcept
+    {
+        return success;
+    }
+};
+
+/** a null pointer is the failed result, so this is the same size as the pointer */
+template <typename T>
+class ParseResult<util::ArenaPtr<T>> final
+{
+private:
+    util::ArenaPtr<T> value;
+
+public:
+    constexpr ParseResult(ParseFailure) noexcept : value()
+    {
+    }
+    ParseResult(util::ArenaPtr<T> value) noexcept : value(value)
+    {
+        assert(value);
+    }
+    constexpr bool isError() const noexcept
+    {
+        return !value;
+    }
+    constexpr bool isSuccess() const noexcept
+    {
+        return static_cast<bool>(value);
+    }
+    constexpr explicit operator bool() const noexcept
+    {
+        return static_cast<bool>(value);
+    }
+    util::ArenaPtr<T> &get() noexcept
+    {
+        assert(value);
+        return value;
+    }
+};
+
+/** a null pointer is the failed result, so this is the same size as the pointer */
+template <typename T>
+class ParseResult<T *> final
+{
+private:
+    T *value;
+
+public:
+    constexpr ParseResult(ParseFailure) noexcept : value(nullptr)
+    {
+    }
+    ParseResult(T *value) noexcept : value(value)
+    {
+        assert(value);
+    }
+    constexpr bool isError() const noexcept
+    {
+        return !value;
+    }
+    constexpr bool isSuccess() const noexcept
+    {
+        return value != nullptr;
+    }
+    constexpr explicit operator bool() const noexcept
+    {
+        return value != nullptr;
+    }
+    T *&get() noexcept
+    {
+        assert(value);
+        return value;
+    }
+};
+
+static_assert(sizeof(ParseResult<>) == sizeof(bool), "");
+static_assert(sizeof(ParseResult<util::ArenaPtr<int>>) == sizeof(util::ArenaPtr<int>), "");
+
 class Parser final
 {
     Parser(const Parser &) = delete;
     Parser &operator=(const Parser &) = delete;
 
+private:
+    union GenerateParseErrorFnArgument final
+    {
+        void *object;
+        void (*function)();
+        std::size_t integer;
+        constexpr GenerateParseErrorFnArgument(void *object = nullptr) noexcept : object(object)
+        {
+        }
+        constexpr GenerateParseErrorFnArgument(void (*function)()) noexcept : function(function)
+        {
+        }
+        constexpr GenerateParseErrorFnArgument(std::size_t integer) noexcept : integer(integer)
+        {
+        }
+    };
+    typedef void (*GenerateParseErrorFn)(Parser &parser,
+                                         input::SimpleLocation location,
+                                         GenerateParseErrorFnArgument argument);
+    struct ParseResultError final
+    {
+        GenerateParseErrorFn function;
+        input::SimpleLocation location;
+        GenerateParseErrorFnArgument argument;
+        constexpr ParseResultError() noexcept : function(nullptr), location(), argument()
+        {
+        }
+        constexpr ParseResultError(GenerateParseErrorFn function,
+                                   input::SimpleLocation location,
+                                   GenerateParseErrorFnArgument argument) noexcept
+            : function(function),
+              location(location),
+              argument(argument)
+        {
+        }
+        void throwError(Parser &parser) const
+        {
+            function(parser, location, argument);
+            UNREACHABLE();
+        }
+    };
+
 private:
     input::TextInput &textInput;
     util::Arena &arena;
+    util::SymbolTable &symbolTable;
     const ParserDialect dialect;
+    /** from `getCharacterClassTable` for `dialect` */
+    const CharacterClass::Bits *const characterClasses;
+    /** scratch space for building text to intern */
+    std::string textBuffer;
+    /** the error from the last parse function that failed */
+    ParseResultError lastError;
+    /** where `parseTopLevelCommand` continues from */
+    input::LineContinuationRemovingIterator topLevelTextIter;
+    /** here-document redirections on the current line; their bodies start after its newline */
+    std::vector<util::ArenaPtr<ast::Redirection>> pendingHereDocuments;
+    /** see `setParseFunctionBodiesLazily` */
+    bool parseFunctionBodiesLazily;
+    /** see `setSymbolIdReferences` */
+    std::vector<util::SymbolId *> *symbolIdReferences;
 
 public:
     explicit Parser(input::TextInput &textInput,
                     util::Arena &arena,
+                    util::SymbolTable &symbolTable,
                     const ParserDialect &dialect = ParserDialect::getQuickShellDialect())
-        : textInput(textInput), arena(arena), dialect(dialect)
+        : textInput(textInput),
+          arena(arena),
+          symbolTable(symbolTable),
+          dialect(dialect),
+          characterClasses(getCharacterClassTable(dialect.textInputStyle)),
+          textBuffer(),
+          lastError(),
+          topLevelTextIter(textInput.begin()),
+          pendingHereDocuments(),
+          parseFunctionBodiesLazily(false),
+          symbolIdReferences(nullptr)
     {
         textInput.setInputStyle(dialect.textInputStyle);
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+        // AST nodes find their input through the context of the slab they're in
+        arena.setContext(&textInput);
+#endif
+    }
+
+private:
+    /** an arena checkpoint, along with how many symbol id references were recorded by then */
+    struct Checkpoint final
+    {
+        util::Arena::Checkpoint arenaCheckpoint;
+        std::size_t symbolIdReferenceCount;
+    };
+    Checkpoint checkpoint() const noexcept
+    {
+        return Checkpoint{arena.checkpoint(),
+                          symbolIdReferences ? symbolIdReferences->size() : 0};
+    }
+    /** rolls `arena` back to `checkpointValue`, also dropping the symbol id references into the
+     * memory that frees. Use this instead of `arena.rollbackTo`. */
+    void rollbackTo(const Checkpoint &checkpointValue) noexcept
+    {
+        if(symbolIdReferences)
+            symbolIdReferences->resize(checkpointValue.symbolIdReferenceCount);
+        arena.rollbackTo(checkpointValue.arenaCheckpoint);
     }
 
 private:
@@ -238,178 +482,216 @@ private:
     }
 
 private:
-    union GenerateParseErrorFnArgument final
+    static std::size_t getTextIndex(const input::TextInput::Iterator &iter) noexcept
     {
-        void *object;
-        void (*function)();
-        std::size_t integer;
-        constexpr GenerateParseErrorFnArgument(void *object = nullptr) noexcept : object(object)
-        {
-        }
-        constexpr GenerateParseErrorFnArgument(void (*function)()) noexcept : function(function)
-        {
-        }
-        constexpr GenerateParseErrorFnArgument(std::size_t integer) noexcept : integer(integer)
-        {
-        }
-    };
-    typedef void (*GenerateParseErrorFn)(Parser &parser,
-                                         input::SimpleLocation location,
-                                         GenerateParseErrorFnArgument argument);
-    struct ParseResultError final
+        return iter.getIndex();
+    }
+    static std::size_t getTextIndex(const input::LineContinuationRemovingIterator &iter)
     {
-        GenerateParseErrorFn function;
-        input::SimpleLocation location;
-        GenerateParseErrorFnArgument argument;
-        constexpr ParseResultError() noexcept : function(nullptr), location(), argument()
-        {
-        }
-        constexpr ParseResultError(GenerateParseErrorFn function,
-                                   input::SimpleLocation location,
-                                   GenerateParseErrorFnArgument argument) noexcept
-            : function(function),
-              location(location),
-              argument(argument)
-        {
-        }
-        void throwError(Parser &parser) const
-        {
-            function(parser, location, argument);
-            UNREACHABLE();
-        }
-    };
-    template <typename T = void>
-    struct ParseResult final
-    {
-        typedef typename std::conditional<std::is_void<T>::value,
-                                          util::variant<ParseResultError>,
-                                          util::variant<ParseResultError, T>>::type VariantType;
-        VariantType value;
-        template <typename T2 = T,
-                  typename Bool = typename std::enable_if<std::is_void<T2>::value, bool>::type>
-        ParseResult() noexcept(Bool(true))
-            : value()
-        {
-        }
-        template <typename T2 = T>
-        ParseResult(typename std::enable_if<!std::is_void<T2>::value, T2>::type &&value)
-            : value(value)
+        return iter.getBaseIterator().getIndex();
+    }
+    template <typename IteratorType>
+    static char *copyText(char *output, IteratorType iter, std::size_t endIndex)
+    {
+        std::size_t index;
+        while((index = getTextIndex(iter)) < endIndex)
         {
+            auto span = iter.getContiguousSpan();
+            if(span.empty())
+                break;
+            std::size_t count = span.size();
+            if(count > endIndex - index)
+                count = endIndex - index;
+            std::memcpy(output, span.begin(), count);
+            output += count;
+            iter.advance(count);
         }
-        template <typename T2 = T>
-        ParseResult(const typename std::enable_if<!std::is_void<T2>::value, T2>::type &value)
-            : value(value)
+        return output;
+    }
+    /** copies the text in `locationSpan` to `output`, which must have room for
+     * `locationSpan.size()` bytes, and returns the end of the copied text. Line continuations are
+     * removed unless `isRaw` is true. */
+    char *copyCookedText(char *output, const input::LocationSpan &locationSpan, bool isRaw)
+    {
+        auto iter = textInput.iteratorAt(locationSpan.beginIndex);
+        if(isRaw)
+            return copyText(output, iter, locationSpan.endIndex);
+        return copyText(
+            output, input::LineContinuationRemovingIterator(iter), locationSpan.endIndex);
+    }
+    /** copies the text in `locationSpan` into the arena, so word parts don't have to go back to
+     * `textInput` for it. */
+    util::string_view makeCookedText(const input::LocationSpan &locationSpan, bool isRaw)
+    {
+        if(locationSpan.size() == 0)
+            return util::string_view();
+        // line continuations only ever make the text shorter
+        auto *text = static_cast<char *>(arena.allocateBytes(locationSpan.size(), 1));
+        char *textEnd = copyCookedText(text, locationSpan, isRaw);
+        return util::string_view(text, textEnd - text);
+    }
+    void addTextWordPart(ast::Word::WordParts &wordParts,
+                         ast::CompactWordPart::Kind kind,
+                         ast::WordPart::QuoteKind quoteKind,
+                         const input::LocationSpan &locationSpan,
+                         bool isRaw = false)
+    {
+        wordParts.emplace_back(
+            arena, kind, quoteKind, locationSpan, makeCookedText(locationSpan, isRaw));
+    }
+    /** escape sequence values are stored in the word part itself */
+    void addEscapeSequenceWordPart(ast::Word::WordParts &wordParts,
+                                   ast::CompactWordPart::Kind kind,
+                                   ast::WordPart::QuoteKind quoteKind,
+                                   const input::LocationSpan &locationSpan,
+                                   char value)
+    {
+        wordParts.emplace_back(arena, kind, quoteKind, locationSpan, util::string_view(&value, 1));
+    }
+    /** like `addTextWordPart`, but the name is interned and the cooked text is shared with
+     * `symbolTable` */
+    void addVariableNameWordPart(ast::Word::WordParts &wordParts,
+                                 const input::LocationSpan &locationSpan)
+    {
+        textBuffer.resize(locationSpan.size());
+        char *textEnd = copyCookedText(&textBuffer[0], locationSpan, false);
+        util::string_view text(textBuffer.data(), textEnd - &textBuffer[0]);
+        auto symbol = symbolTable.intern(text);
+        constexpr auto kind = ast::CompactWordPart::Kind::AssignmentVariableName;
+        constexpr auto quoteKind = ast::WordPart::QuoteKind::Unquoted;
+        if(!symbolIdReferences)
         {
+            wordParts.emplace_back(
+                arena, kind, quoteKind, locationSpan, symbolTable.getText(symbol), symbol);
+            return;
         }
-        ParseResult(ParseResultError parseResultError) noexcept : value(parseResultError)
+        // the symbol table goes away once the symbols are remapped, so the text can't be shared
+        auto *textCopy = static_cast<char *>(arena.allocateBytes(text.size(), 1));
+        std::memcpy(textCopy, text.data(), text.size());
+        wordParts.emplace_back(
+            arena, kind, quoteKind, locationSpan, util::string_view(textCopy, text.size()), symbol);
+    }
+    /** interns the value of `word` after quote removal; returns an invalid id if the word isn't
+     * entirely literal text */
+    util::SymbolId internWordLiteral(const ast::Word &word)
+    {
+        auto *begin = word.wordParts.begin();
+        auto *end = word.wordParts.end();
+        for(auto *part = begin; part != end; ++part)
+            if(part->kind == ast::CompactWordPart::Kind::CommandSubstitution)
+                return util::SymbolId();
+        // quote parts have no cooked text, so `"abc"` is only one part of text
+        const ast::CompactWordPart *onlyTextPart = nullptr;
+        for(auto *part = begin; part != end; ++part)
         {
+            if(part->getCookedText().empty())
+                continue;
+            if(onlyTextPart)
+            {
+                onlyTextPart = nullptr;
+                break;
+            }
+            onlyTextPart = part;
         }
-        explicit ParseResult(
-            GenerateParseErrorFn function,
-            input::SimpleLocation location = input::SimpleLocation(),
-            GenerateParseErrorFnArgument argument = GenerateParseErrorFnArgument()) noexcept
-            : value(ParseResultError(function, location, argument))
+        if(onlyTextPart)
+            return symbolTable.intern(onlyTextPart->getCookedText());
+        textBuffer.clear();
+        for(auto *part = begin; part != end; ++part)
         {
+            auto text = part->getCookedText();
+            textBuffer.append(text.data(), text.size());
         }
-        explicit ParseResult(void (*function)(Parser &parser, input::SimpleLocation location),
+        return symbolTable.intern(util::string_view(textBuffer.data(), textBuffer.size()));
+    }
+    /** sets `word.literalSymbol` for a word that names a command, a function or a variable. Other
+     * words aren't interned, since the symbol table keeps every symbol and most arguments are
+     * only seen once. */
+    void internLiteralSymbol(ast::Word &word)
+    {
+        word.literalSymbol = internWordLiteral(word);
+        if(symbolIdReferences && word.literalSymbol)
+            symbolIdReferences->push_back(&word.literalSymbol);
+    }
+
+private:
+    /** records the error for a failed parse; returns the value to return from the parse function.
+     *
+     * Only call this where the parse actually fails; probes that can fail as part of normal
+     * parsing return `bool` instead, so discarded failures don't build an error.
+     * */
+    ParseFailure parserError(
+        GenerateParseErrorFn function,
+        input::SimpleLocation location = input::SimpleLocation(),
+        GenerateParseErrorFnArgument argument = GenerateParseErrorFnArgument()) noexcept
+    {
+        lastError = ParseResultError(function, location, argument);
+        return ParseFailure();
+    }
+    ParseFailure parserError(void (*function)(Parser &parser, input::SimpleLocation location),
                              input::SimpleLocation location) noexcept
-            : value(ParseResultError(
-                  [](Parser &parser,
-                     input::SimpleLocation location,
-                     GenerateParseErrorFnArgument argument)
-                  {
-                      reinterpret_cast<void (*)(Parser &, input::SimpleLocation location)>(
-                          argument.function)(parser, location);
-                      UNREACHABLE();
-                  },
-                  location,
-                  reinterpret_cast<void (*)()>(function)))
-        {
-        }
-        explicit ParseResult(void (*function)(Parser &parser, input::Location location),
+    {
+        return parserError(
+            [](Parser &parser,
+               input::SimpleLocation location,
+               GenerateParseErrorFnArgument argument)
+            {
+                reinterpret_cast<void (*)(Parser &, input::SimpleLocation location)>(
+                    argument.function)(parser, location);
+                UNREACHABLE();
+            },
+            location,
+            reinterpret_cast<void (*)()>(function));
+    }
+    ParseFailure parserError(void (*function)(Parser &parser, input::Location location),
                              input::SimpleLocation location) noexcept
-            : value(ParseResultError(
-                  [](Parser &parser,
-                     input::SimpleLocation location,
-                     GenerateParseErrorFnArgument argument)
-                  {
-                      reinterpret_cast<void (*)(Parser &, input::Location location)>(
-                          argument.function)(parser, input::Location(location, parser.textInput));
-                      UNREACHABLE();
-                  },
-                  location,
-                  reinterpret_cast<void (*)()>(function)))
-        {
-        }
-        explicit ParseResult(void (*function)(input::Location location),
+    {
+        return parserError(
+            [](Parser &parser,
+               input::SimpleLocation location,
+               GenerateParseErrorFnArgument argument)
+            {
+                reinterpret_cast<void (*)(Parser &, input::Location location)>(argument.function)(
+                    parser, input::Location(location, parser.textInput));
+                UNREACHABLE();
+            },
+            location,
+            reinterpret_cast<void (*)()>(function));
+    }
+    ParseFailure parserError(void (*function)(input::Location location),
                              input::SimpleLocation location) noexcept
-            : value(ParseResultError(
-                  [](Parser &parser,
-                     input::SimpleLocation location,
-                     GenerateParseErrorFnArgument argument)
-                  {
-                      reinterpret_cast<void (*)(input::Location location)>(argument.function)(
-                          input::Location(location, parser.textInput));
-                      UNREACHABLE();
-                  },
-                  location,
-                  reinterpret_cast<void (*)()>(function)))
-        {
-        }
-        explicit ParseResult(void (*function)(input::SimpleLocation location),
+    {
+        return parserError(
+            [](Parser &parser,
+               input::SimpleLocation location,
+               GenerateParseErrorFnArgument argument)
+            {
+                reinterpret_cast<void (*)(input::Location location)>(argument.function)(
+                    input::Location(location, parser.textInput));
+                UNREACHABLE();
+            },
+            location,
+            reinterpret_cast<void (*)()>(function));
+    }
+    ParseFailure parserError(void (*function)(input::SimpleLocation location),
                              input::SimpleLocation location) noexcept
-            : value(ParseResultError(
-                  [](Parser &parser,
-                     input::SimpleLocation location,
-                     GenerateParseErrorFnArgument argument)
-                  {
-                      reinterpret_cast<void (*)(input::SimpleLocation location)>(argument.function)(
-                          location);
-                      UNREACHABLE();
-                  },
-                  location,
-                  reinterpret_cast<void (*)()>(function)))
-        {
-        }
-        bool isError() const noexcept
-        {
-            return value.template is<ParseResultError>();
-        }
-        bool isSuccess() const noexcept
-        {
-            return !isError();
-        }
-        void throwError(Parser &parser) const
-        {
-            assert(isError());
-            value.template get<ParseResultError>().throwError(parser);
-        }
-        explicit operator bool() const noexcept
-        {
-            return isSuccess();
-        }
-        template <typename T2 = T>
-        typename std::enable_if<std::is_same<T, T2>::value && !std::is_void<T2>::value, T2>::type &
-            get() noexcept
-        {
-            return value.template get<T2>();
-        }
-        const ParseResultError &getError() const noexcept
-        {
-            return value.template get<ParseResultError>();
-        }
-    };
-    template <typename T = void, typename... Args>
-    ParseResult<T> parserError(Args &&... args) noexcept(
-        noexcept(ParseResult<T>(std::forward<Args>(args)...)))
     {
-        return ParseResult<T>(std::forward<Args>(args)...);
+        return parserError(
+            [](Parser &,
+               input::SimpleLocation location,
+               GenerateParseErrorFnArgument argument)
+            {
+                reinterpret_cast<void (*)(input::SimpleLocation location)>(argument.function)(
+                    location);
+                UNREACHABLE();
+            },
+            location,
+            reinterpret_cast<void (*)()>(function));
     }
     template <std::size_t N>
-    ParseResultError parserErrorStaticString(const char(&message)[N],
-                                             input::SimpleLocation location) noexcept
+    ParseFailure parserErrorStaticString(const char(&message)[N],
+                                         input::SimpleLocation location) noexcept
     {
-        return ParseResultError(
+        return parserError(
             [](Parser &parser,
                input::SimpleLocation location,
                GenerateParseErrorFnArgument argument)
@@ -421,13 +703,13 @@ private:
             static_cast<void *>(const_cast<char *>(message)));
     }
     template <std::size_t N>
-    ParseResultError parserErrorStaticString(const char(&message)[N],
-                                             const input::TextInput::Iterator &iter) noexcept
+    ParseFailure parserErrorStaticString(const char(&message)[N],
+                                         const input::TextInput::Iterator &iter) noexcept
     {
         return parserErrorStaticString(message, iter.getLocation());
     }
     template <std::size_t N>
-    ParseResultError parserErrorStaticString(
+    ParseFailure parserErrorStaticString(
         const char(&message)[N], const input::LineContinuationRemovingIterator &iter) noexcept
     {
         return parserErrorStaticString(message, iter.getLocation());
@@ -441,204 +723,161 @@ private:
     {
         return ParseResult<typename std::decay<T>::type>(std::forward<T>(v));
     }
+    /** throws the error from the last parse function that failed */
+    void throwParseError()
+    {
+        assert(lastError.function);
+        lastError.throwError(*this);
+    }
 
 private:
-    ParseResult<> parseNewLine(input::LineContinuationRemovingIterator &textIter)
+    /** advances `textIter` through its current contiguous span up to the first of `stopBytes`.
+     *
+     * Returns true if one of `stopBytes` was found; otherwise `textIter` is left at the end of the
+     * span, which may be an EOF.
+     * */
+    template <unsigned char... stopBytes, typename IteratorType>
+    static bool skipToFirstByteOf(IteratorType &textIter)
+    {
+        auto span = textIter.getContiguousSpan();
+        auto stopPosition = util::findFirstByteOf<stopBytes...>(span.begin(), span.end());
+        textIter.advance(stopPosition - span.begin());
+        return stopPosition != span.end();
+    }
+    // The probes below return true and advance `textIter` if the text at `textIter` matches;
+    // otherwise they return false and leave `textIter` alone. Callers decide whether not matching
+    // is an error, so speculative checks don't build errors that are thrown away.
+    bool parseNewLine(input::LineContinuationRemovingIterator &textIter)
     {
         auto baseTextIter = textIter.getBaseIterator();
-        auto result = parseNewLine(baseTextIter);
-        if(result)
-            textIter = input::LineContinuationRemovingIterator(baseTextIter);
-        return result;
+        if(!parseNewLine(baseTextIter))
+            return false;
+        textIter = input::LineContinuationRemovingIterator(baseTextIter);
+        return true;
     }
-    ParseResult<> parseNewLine(input::TextInput::Iterator &textIter)
+    bool parseNewLine(input::TextInput::Iterator &textIter)
     {
         if(*textIter == '\r')
         {
-            ++textIter;
-            if(dialect.textInputStyle.allowCRLFAsNewLine && *textIter == '\n')
+            auto textIter2 = textIter;
+            ++textIter2;
+            if(dialect.textInputStyle.allowCRLFAsNewLine && *textIter2 == '\n')
             {
-                ++textIter;
-                return parserSuccess();
+                ++textIter2;
+                textIter = textIter2;
+                return true;
             }
             if(dialect.textInputStyle.allowCRAsNewLine)
-                return parserSuccess();
+            {
+                textIter = textIter2;
+                return true;
+            }
+            return false;
         }
         if(dialect.textInputStyle.allowLFAsNewLine && *textIter == '\n')
         {
             ++textIter;
-            return parserSuccess();
+            return true;
         }
-        return parserErrorStaticString("missing newline", textIter);
+        return false;
     }
-    ParseResult<> parseBlank(input::LineContinuationRemovingIterator &textIter)
+    /** the `CharacterClass` bits for the character at `textIter`, with a CR that starts a CRLF
+     * resolved by looking at the next character */
+    CharacterClass::Bits getCharacterClasses(
+        const input::LineContinuationRemovingIterator &textIter)
     {
-        switch(*textIter)
+        auto retval = characterClasses[*textIter - input::eof];
+        if(retval & CharacterClass::crlfStart)
         {
-        case ' ':
-        case '\t':
-            ++textIter;
-            return parserSuccess();
-        default:
-            return parserErrorStaticString("missing blank", textIter);
+            auto baseTextIter = textIter.getBaseIterator();
+            ++baseTextIter;
+            if(*baseTextIter == '\n')
+                return CharacterClass::crlfNewLine;
         }
+        return retval;
     }
-    ParseResult<> parseMetacharacter(input::LineContinuationRemovingIterator &textIter)
+    bool isUnquotedWordEndCharacter(const input::LineContinuationRemovingIterator &textIter,
+                                    std::size_t backquoteNestLevel)
     {
-        switch(*textIter)
-        {
-        case '|':
-        case '&':
-        case ';':
-        case '(':
-        case ')':
-        case '<':
-        case '>':
-            ++textIter;
-            return parserSuccess();
-        default:
-        {
-            auto textIter2 = textIter;
-            auto retval = parseNewLine(textIter2);
-            if(retval)
-            {
-                textIter = textIter2;
-                return retval;
-            }
-            textIter2 = textIter;
-            retval = parseBlank(textIter2);
-            if(retval)
-            {
-                textIter = textIter2;
-                return retval;
-            }
-            return parserErrorStaticString("missing metacharacter", textIter);
-        }
-        }
+        if(backquoteNestLevel > 0 && *textIter == '`')
+            return true;
+        return getCharacterClasses(textIter) & CharacterClass::unquotedWordEnd;
     }
-    ParseResult<> parseMetacharacterOrEOF(input::LineContinuationRemovingIterator &textIter)
+    /** advances `textIter` if the character there has any of `classBits` */
+    bool parseCharacterClass(input::LineContinuationRemovingIterator &textIter,
+                             CharacterClass::Bits classBits)
     {
-        if(*textIter == input::eof)
+        if(getCharacterClasses(textIter) & classBits)
         {
             ++textIter;
-            return parserSuccess();
+            return true;
         }
-        return parseMetacharacter(textIter);
+        return false;
     }
-    ParseResult<> parseNameStartCharacter(input::LineContinuationRemovingIterator &textIter)
+    bool parseBlank(input::LineContinuationRemovingIterator &textIter)
     {
-        int ch = *textIter;
-        if((ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_')
+        return parseCharacterClass(textIter, CharacterClass::blank);
+    }
+    bool parseMetacharacter(input::LineContinuationRemovingIterator &textIter)
+    {
+        auto classes = getCharacterClasses(textIter);
+        if(classes & CharacterClass::newLine)
+            return parseNewLine(textIter);
+        if(classes & CharacterClass::metacharacter)
         {
             ++textIter;
-            return parserSuccess();
+            return true;
         }
-        return parserErrorStaticString("missing name start character", textIter);
+        return false;
     }
-    ParseResult<> parseNameContinueCharacter(input::LineContinuationRemovingIterator &textIter)
+    bool parseMetacharacterOrEOF(input::LineContinuationRemovingIterator &textIter)
     {
-        int ch = *textIter;
-        if(parseNameStartCharacter(copy(textIter)) || (ch >= '0' && ch <= '9'))
+        if(*textIter == input::eof)
         {
             ++textIter;
-            return parserSuccess();
+            return true;
         }
-        return parserErrorStaticString("missing name continue character", textIter);
+        return parseMetacharacter(textIter);
     }
-    ParseResult<> parseSimpleWordStartCharacter(input::LineContinuationRemovingIterator &textIter)
+    bool parseNameStartCharacter(input::LineContinuationRemovingIterator &textIter)
     {
-        switch(*textIter)
-        {
-        case '\"':
-        case '\'':
-        case '!':
-        case '$':
-        case '`':
-        case '\\':
-        case '#':
-            break;
-        default:
-            if(!parseMetacharacterOrEOF(copy(textIter)))
-            {
-                ++textIter;
-                return parserSuccess();
-            }
-        }
-        return parserErrorStaticString("missing unquoted word start character", textIter);
+        return parseCharacterClass(textIter, CharacterClass::nameStart);
     }
-    ParseResult<> parseSimpleWordContinueCharacter(
-        input::LineContinuationRemovingIterator &textIter)
+    bool parseNameContinueCharacter(input::LineContinuationRemovingIterator &textIter)
     {
-        if(parseSimpleWordStartCharacter(copy(textIter)) || *textIter == '#')
-        {
-            ++textIter;
-            return parserSuccess();
-        }
-        return parserErrorStaticString("missing unquoted word continue character", textIter);
+        return parseCharacterClass(textIter, CharacterClass::nameContinue);
     }
-    ParseResult<> parseWordStartCharacter(input::LineContinuationRemovingIterator &textIter,
-                                          std::size_t backquoteNestLevel)
+    bool parseSimpleWordStartCharacter(input::LineContinuationRemovingIterator &textIter)
     {
-        if(backquoteNestLevel > 0)
-            UNIMPLEMENTED();
-        switch(*textIter)
-        {
-        case '\"':
-        case '\'':
-        case '$':
-        case '!':
-        case '\\':
-            ++textIter;
-            return parserSuccess();
-        case '`':
-            if(backquoteNestLevel > 0)
-                break;
-            ++textIter;
-            return parserSuccess();
-        default:
-        {
-            auto textIter2 = textIter;
-            auto retval = parseSimpleWordStartCharacter(textIter2);
-            if(retval)
-            {
-                textIter = textIter2;
-                return retval;
-            }
-            break;
-        }
-        }
-        return parserErrorStaticString("missing word start character", textIter);
+        return parseCharacterClass(textIter, CharacterClass::simpleWordStart);
     }
-    ParseResult<> parseUnquotedWordEndCharacter(input::LineContinuationRemovingIterator &textIter,
-                                                std::size_t backquoteNestLevel)
+    bool parseSimpleWordContinueCharacter(input::LineContinuationRemovingIterator &textIter)
     {
-        if(backquoteNestLevel > 0)
-            UNIMPLEMENTED();
-        switch(*textIter)
-        {
-        case '`':
-            if(backquoteNestLevel > 0)
-            {
-                ++textIter;
-                return parserSuccess();
-            }
-            break;
-        default:
+        return parseCharacterClass(textIter, CharacterClass::simpleWordContinue);
+    }
+    bool parseWordStartCharacter(input::LineContinuationRemovingIterator &textIter,
+                                 std::size_t backquoteNestLevel)
+    {
+        if(backquoteNestLevel > 0 && *textIter == '`')
+            return false;
+        return parseCharacterClass(textIter, CharacterClass::wordStart);
+    }
+    bool parseUnquotedWordEndCharacter(input::LineContinuationRemovingIterator &textIter,
+                                       std::size_t backquoteNestLevel)
+    {
+        if(backquoteNestLevel > 0 && *textIter == '`')
         {
-            auto textIter2 = textIter;
-            auto retval = parseMetacharacterOrEOF(textIter2);
-            if(retval)
-            {
-                textIter = textIter2;
-                return retval;
-            }
-            break;
-        }
+            ++textIter;
+            return true;
         }
-        return parserErrorStaticString("missing unquoted word end character", textIter);
+        if(getCharacterClasses(textIter) & CharacterClass::unquotedWordEnd)
+            return parseMetacharacterOrEOF(textIter);
+        return false;
     }
+    /** returns the value of the digit at `textIter` and advances past it, or returns -1 if there
+     * isn't a digit in `base` there */
     template <typename IteratorType>
-    ParseResult<int> parseDigit(IteratorType &textIter, std::size_t base = 10)
+    int parseDigit(IteratorType &textIter, std::size_t base = 10)
     {
         assert(base >= 2 && base <= 36);
         int ch = *textIter;
@@ -652,19 +891,20 @@ private:
         if(value >= static_cast<int>(base))
             value = -1;
         if(value != -1)
-        {
             ++textIter;
-            return parserSuccess(value);
-        }
+        return value;
+    }
+    ParseFailure missingDigitError(input::SimpleLocation location, std::size_t base) noexcept
+    {
         if(base == 10)
-            return parserErrorStaticString("missing decimal digit", textIter);
+            return parserErrorStaticString("missing decimal digit", location);
         if(base == 16)
-            return parserErrorStaticString("missing hexadecimal digit", textIter);
+            return parserErrorStaticString("missing hexadecimal digit", location);
         if(base == 8)
-            return parserErrorStaticString("missing octal digit", textIter);
+            return parserErrorStaticString("missing octal digit", location);
         if(base == 2)
-            return parserErrorStaticString("missing binary digit", textIter);
-        return parserError<int>(
+            return parserErrorStaticString("missing binary digit", location);
+        return parserError(
             [](Parser &parser,
                input::SimpleLocation location,
                GenerateParseErrorFnArgument argument)
@@ -673,7 +913,7 @@ private:
                 ss << "missing base-" << argument.integer << " digit";
                 throw ParseError(input::Location(location, parser.textInput), ss.str());
             },
-            textIter.getLocation(),
+            location,
             base);
     }
     template <typename NumberType = unsigned long, typename IteratorType>
@@ -691,17 +931,14 @@ private:
         auto startLocation = textIter.getLocation();
         while(digitCount < maxDigitCount)
         {
-            auto textIter2 = textIter;
-            auto digitResult = parseDigit(textIter2, base);
-            if(!digitResult)
+            int digitValue = parseDigit(textIter, base);
+            if(digitValue < 0)
             {
                 if(digitCount >= minDigitCount)
                     break;
-                return digitResult.getError();
+                return missingDigitError(textIter.getLocation(), base);
             }
-            textIter = textIter2;
             digitCount++;
-            int digitValue = digitResult.get();
             if(retval > maxValueOverBase
                || (retval == maxValueOverBase
                    && static_cast<unsigned>(digitValue) > maxValueModBase))
@@ -711,22 +948,42 @@ private:
         }
         return parserSuccess(retval);
     }
-    ParseResult<std::vector<util::ArenaPtr<ast::WordPart>>> parseDoubleQuoteString(
-        input::LineContinuationRemovingIterator &textIter,
-        std::vector<util::ArenaPtr<ast::WordPart>> wordParts,
-        std::size_t backquoteNestLevel)
+    /** reports the expansion started by the `$` at `dollarSignLocation`; `textIter` is just past
+     * the `$` */
+    ParseFailure unsupportedDollarExpansionError(
+        const input::LineContinuationRemovingIterator &textIter, input::Location dollarSignLocation)
+    {
+        if(*textIter == '(')
+        {
+            auto textIter2 = textIter;
+            ++textIter2;
+            if(*textIter2 == '(')
+                return parserErrorStaticString("arithmetic expansions are not supported",
+                                               dollarSignLocation);
+            return parserErrorStaticString("command substitutions are not supported",
+                                           dollarSignLocation);
+        }
+        if(*textIter == '\"')
+            return parserErrorStaticString("locale-translated strings are not supported",
+                                           dollarSignLocation);
+        return parserErrorStaticString("parameter expansions are not supported",
+                                       dollarSignLocation);
+    }
+    ParseResult<> parseDoubleQuoteString(input::LineContinuationRemovingIterator &textIter,
+                                         ast::Word::WordParts &wordParts,
+                                         std::size_t backquoteNestLevel)
     {
         if(backquoteNestLevel > 0)
-            UNIMPLEMENTED();
-        typedef ast::TextWordPart<ast::WordPart::QuoteKind::DoubleQuote> TextWordPartType;
-        typedef ast::SimpleEscapeSequenceWordPart<ast::WordPart::QuoteKind::DoubleQuote>
-            SimpleEscapeSequenceWordPartType;
+            return parserErrorStaticString("command substitutions are not supported", textIter);
+        typedef ast::CompactWordPart::Kind Kind;
+        constexpr auto quoteKind = ast::WordPart::QuoteKind::DoubleQuote;
         assert(*textIter == '\"');
         auto quoteStartingLocation = textIter.getLocation();
         ++textIter;
-        wordParts.push_back(
-            arena.allocate<ast::QuoteWordPart<true, ast::WordPart::QuoteKind::DoubleQuote>>(
-                input::LocationSpan(quoteStartingLocation, textIter.getLocation())));
+        wordParts.emplace_back(arena,
+                               Kind::QuoteStart,
+                               quoteKind,
+                               input::LocationSpan(quoteStartingLocation, textIter.getLocation()));
         auto quotedTextStartLocation = textIter.getLocation();
         while(true)
         {
@@ -738,23 +995,32 @@ private:
             {
                 quoteStartingLocation = textIter.getLocation();
                 ++textIter;
-                wordParts.push_back(
-                    arena
-                        .allocate<ast::QuoteWordPart<false, ast::WordPart::QuoteKind::DoubleQuote>>(
-                            input::LocationSpan(quoteStartingLocation, textIter.getLocation())));
-                return parserSuccess(std::move(wordParts));
+                wordParts.emplace_back(
+                    arena,
+                    Kind::QuoteStop,
+                    quoteKind,
+                    input::LocationSpan(quoteStartingLocation, textIter.getLocation()));
+                return parserSuccess();
             }
             case '$':
             {
-                UNIMPLEMENTED();
+                auto dollarSignLocation = textIter.getLocation();
+                ++textIter;
+                // a `$` just before the closing quote is just text
+                if(*textIter != '\"')
+                    return unsupportedDollarExpansionError(textIter, dollarSignLocation);
+                addTextWordPart(wordParts,
+                                Kind::Text,
+                                quoteKind,
+                                input::LocationSpan(dollarSignLocation, textIter.getLocation()));
                 break;
             }
             case '`':
             {
                 if(backquoteNestLevel > 0)
                     return parserErrorStaticString("missing closing \"", textIter.getLocation());
-                UNIMPLEMENTED();
-                break;
+                return parserErrorStaticString("command substitutions are not supported",
+                                               textIter);
             }
             case '\\':
             {
@@ -773,8 +1039,8 @@ private:
                     ++baseTextIter;
                     auto locationSpan =
                         input::LocationSpan(backslashStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(
-                        arena.allocate<SimpleEscapeSequenceWordPartType>(locationSpan, ch));
+                    addEscapeSequenceWordPart(
+                        wordParts, Kind::SimpleEscapeSequence, quoteKind, locationSpan, ch);
                     break;
                 }
                 default:
@@ -782,7 +1048,7 @@ private:
                     ++baseTextIter;
                     auto locationSpan =
                         input::LocationSpan(backslashStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(arena.allocate<TextWordPartType>(locationSpan));
+                    addTextWordPart(wordParts, Kind::Text, quoteKind, locationSpan);
                     break;
                 }
                 }
@@ -793,62 +1059,35 @@ private:
             {
                 auto textStartLocation = textIter.getLocation();
                 ++textIter;
-                while(true)
+                while(!skipToFirstByteOf<'$', '`', '\\', '\"'>(textIter))
                 {
-                    switch(*textIter)
-                    {
-                    case input::eof:
-                    case '$':
-                    case '`':
-                    case '\\':
-                    case '\"':
+                    if(*textIter == input::eof)
                         break;
-                    default:
-                        ++textIter;
-                        continue;
-                    }
-                    break;
                 }
                 auto locationSpan = input::LocationSpan(textStartLocation, textIter.getLocation());
-                wordParts.push_back(arena.allocate<TextWordPartType>(locationSpan));
+                addTextWordPart(wordParts, Kind::Text, quoteKind, locationSpan);
                 break;
             }
             }
         }
     }
-    ParseResult<std::vector<util::ArenaPtr<ast::WordPart>>> parseDollarSingleQuoteString(
-        input::LineContinuationRemovingIterator &textIter,
-        std::vector<util::ArenaPtr<ast::WordPart>> wordParts,
-        input::Location dollarSignLocation,
-        std::size_t backquoteNestLevel)
+    ParseResult<> parseDollarSingleQuoteString(input::LineContinuationRemovingIterator &textIter,
+                                               ast::Word::WordParts &wordParts,
+                                               input::Location dollarSignLocation,
+                                               std::size_t backquoteNestLevel)
     {
         if(backquoteNestLevel > 0)
-            UNIMPLEMENTED();
-        typedef ast::TextWordPart<ast::WordPart::QuoteKind::EscapeInterpretingSingleQuote>
-            TextWordPartType;
-        typedef ast::
-            SimpleEscapeSequenceWordPart<ast::WordPart::QuoteKind::EscapeInterpretingSingleQuote>
-                SimpleEscapeSequenceWordPartType;
-        typedef ast::
-            HexEscapeSequenceWordPart<ast::WordPart::QuoteKind::EscapeInterpretingSingleQuote>
-                HexEscapeSequenceWordPartType;
-        typedef ast::
-            OctalEscapeSequenceWordPart<ast::WordPart::QuoteKind::EscapeInterpretingSingleQuote>
-                OctalEscapeSequenceWordPartType;
-        typedef ast::
-            UnicodeEscapeSequenceWordPart<ast::WordPart::QuoteKind::EscapeInterpretingSingleQuote>
-                UnicodeEscapeSequenceWordPartType;
-        typedef ast::
-            BashBugEscapeSequenceWordPart<ast::WordPart::QuoteKind::EscapeInterpretingSingleQuote>
-                BashBugEscapeSequenceWordPartType;
+            return parserErrorStaticString("command substitutions are not supported", textIter);
+        typedef ast::CompactWordPart::Kind Kind;
+        constexpr auto quoteKind = ast::WordPart::QuoteKind::EscapeInterpretingSingleQuote;
         assert(dialect.allowDollarSingleQuoteStrings);
         assert(*textIter == '\'');
         auto baseTextIter = textIter.getBaseIterator();
         ++baseTextIter;
-        wordParts.push_back(arena.allocate<ast::QuoteWordPart<true,
-                                                              ast::WordPart::QuoteKind::
-                                                                  EscapeInterpretingSingleQuote>>(
-            input::LocationSpan(dollarSignLocation, baseTextIter.getLocation())));
+        wordParts.emplace_back(arena,
+                               Kind::QuoteStart,
+                               quoteKind,
+                               input::LocationSpan(dollarSignLocation, baseTextIter.getLocation()));
         auto quotedTextStartLocation = baseTextIter.getLocation();
         auto wordPartStartLocation = quotedTextStartLocation;
         while(*baseTextIter != '\'')
@@ -858,8 +1097,12 @@ private:
             if(*baseTextIter == '\\')
             {
                 if(wordPartStartLocation != baseTextIter.getLocation())
-                    wordParts.push_back(arena.allocate<TextWordPartType>(
-                        input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation())));
+                    addTextWordPart(
+                        wordParts,
+                        Kind::Text,
+                        quoteKind,
+                        input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation()),
+                        true);
                 wordPartStartLocation = baseTextIter.getLocation();
                 ++baseTextIter;
                 switch(*baseTextIter)
@@ -871,8 +1114,8 @@ private:
                     ++baseTextIter;
                     auto locationSpan =
                         input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(
-                        arena.allocate<SimpleEscapeSequenceWordPartType>(locationSpan, '\a'));
+                    addEscapeSequenceWordPart(
+                        wordParts, Kind::SimpleEscapeSequence, quoteKind, locationSpan, '\a');
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
                 }
@@ -881,8 +1124,8 @@ private:
                     ++baseTextIter;
                     auto locationSpan =
                         input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(
-                        arena.allocate<SimpleEscapeSequenceWordPartType>(locationSpan, '\b'));
+                    addEscapeSequenceWordPart(
+                        wordParts, Kind::SimpleEscapeSequence, quoteKind, locationSpan, '\b');
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
                 }
@@ -892,8 +1135,8 @@ private:
                     ++baseTextIter;
                     auto locationSpan =
                         input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(
-                        arena.allocate<SimpleEscapeSequenceWordPartType>(locationSpan, '\x1B'));
+                    addEscapeSequenceWordPart(
+                        wordParts, Kind::SimpleEscapeSequence, quoteKind, locationSpan, '\x1B');
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
                 }
@@ -902,8 +1145,8 @@ private:
                     ++baseTextIter;
                     auto locationSpan =
                         input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(
-                        arena.allocate<SimpleEscapeSequenceWordPartType>(locationSpan, '\f'));
+                    addEscapeSequenceWordPart(
+                        wordParts, Kind::SimpleEscapeSequence, quoteKind, locationSpan, '\f');
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
                 }
@@ -912,8 +1155,8 @@ private:
                     ++baseTextIter;
                     auto locationSpan =
                         input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(
-                        arena.allocate<SimpleEscapeSequenceWordPartType>(locationSpan, '\n'));
+                    addEscapeSequenceWordPart(
+                        wordParts, Kind::SimpleEscapeSequence, quoteKind, locationSpan, '\n');
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
                 }
@@ -922,8 +1165,8 @@ private:
                     ++baseTextIter;
                     auto locationSpan =
                         input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(
-                        arena.allocate<SimpleEscapeSequenceWordPartType>(locationSpan, '\r'));
+                    addEscapeSequenceWordPart(
+                        wordParts, Kind::SimpleEscapeSequence, quoteKind, locationSpan, '\r');
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
                 }
@@ -932,8 +1175,8 @@ private:
                     ++baseTextIter;
                     auto locationSpan =
                         input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(
-                        arena.allocate<SimpleEscapeSequenceWordPartType>(locationSpan, '\t'));
+                    addEscapeSequenceWordPart(
+                        wordParts, Kind::SimpleEscapeSequence, quoteKind, locationSpan, '\t');
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
                 }
@@ -942,8 +1185,8 @@ private:
                     ++baseTextIter;
                     auto locationSpan =
                         input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(
-                        arena.allocate<SimpleEscapeSequenceWordPartType>(locationSpan, '\v'));
+                    addEscapeSequenceWordPart(
+                        wordParts, Kind::SimpleEscapeSequence, quoteKind, locationSpan, '\v');
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
                 }
@@ -956,8 +1199,8 @@ private:
                     ++baseTextIter;
                     auto locationSpan =
                         input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(
-                        arena.allocate<SimpleEscapeSequenceWordPartType>(locationSpan, ch));
+                    addEscapeSequenceWordPart(
+                        wordParts, Kind::SimpleEscapeSequence, quoteKind, locationSpan, ch);
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
                 }
@@ -970,15 +1213,18 @@ private:
                     {
                         auto locationSpan =
                             input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                        wordParts.push_back(arena.allocate<TextWordPartType>(locationSpan));
+                        addTextWordPart(wordParts, Kind::Text, quoteKind, locationSpan, true);
                     }
                     else
                     {
                         baseTextIter = iter2;
                         auto locationSpan =
                             input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                        wordParts.push_back(arena.allocate<HexEscapeSequenceWordPartType>(
-                            locationSpan, value.get()));
+                        addEscapeSequenceWordPart(wordParts,
+                                                  Kind::HexEscapeSequence,
+                                                  quoteKind,
+                                                  locationSpan,
+                                                  value.get());
                     }
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
@@ -996,8 +1242,11 @@ private:
                     assert(value); // we already have the first digit
                     auto locationSpan =
                         input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(arena.allocate<OctalEscapeSequenceWordPartType>(
-                        locationSpan, value.get() & 0xFF));
+                    addEscapeSequenceWordPart(wordParts,
+                                              Kind::OctalEscapeSequence,
+                                              quoteKind,
+                                              locationSpan,
+                                              value.get() & 0xFF);
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
                 }
@@ -1012,15 +1261,18 @@ private:
                     {
                         auto locationSpan =
                             input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                        wordParts.push_back(arena.allocate<TextWordPartType>(locationSpan));
+                        addTextWordPart(wordParts, Kind::Text, quoteKind, locationSpan, true);
                     }
                     else
                     {
                         baseTextIter = iter2;
                         auto locationSpan =
                             input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                        wordParts.push_back(arena.allocate<UnicodeEscapeSequenceWordPartType>(
-                            locationSpan, util::encodeUTF8(value.get())));
+                        wordParts.emplace_back(arena,
+                                               Kind::UnicodeEscapeSequence,
+                                               quoteKind,
+                                               locationSpan,
+                                               util::encodeUTF8(value.get()));
                     }
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
@@ -1032,12 +1284,15 @@ private:
                         input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
                     if(dialect.duplicateDollarSingleQuoteStringBashParsingFlaws)
                     {
-                        wordParts.push_back(arena.allocate<BashBugEscapeSequenceWordPartType>(
-                            locationSpan, "\\\x01\x01"));
+                        wordParts.emplace_back(arena,
+                                               Kind::BashBugEscapeSequence,
+                                               quoteKind,
+                                               locationSpan,
+                                               "\\\x01\x01");
                     }
                     else
                     {
-                        wordParts.push_back(arena.allocate<TextWordPartType>(locationSpan));
+                        addTextWordPart(wordParts, Kind::Text, quoteKind, locationSpan, true);
                     }
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
@@ -1052,7 +1307,7 @@ private:
                     {
                         auto locationSpan =
                             input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                        wordParts.push_back(arena.allocate<TextWordPartType>(locationSpan));
+                        addTextWordPart(wordParts, Kind::Text, quoteKind, locationSpan, true);
                         break;
                     }
                     case '\\':
@@ -1064,14 +1319,17 @@ private:
                                 ++baseTextIter;
                             auto locationSpan = input::LocationSpan(wordPartStartLocation,
                                                                     baseTextIter.getLocation());
-                            wordParts.push_back(arena.allocate<SimpleEscapeSequenceWordPartType>(
-                                locationSpan, 0x1C));
+                            addEscapeSequenceWordPart(wordParts,
+                                                      Kind::SimpleEscapeSequence,
+                                                      quoteKind,
+                                                      locationSpan,
+                                                      0x1C);
                         }
                         else
                         {
                             auto locationSpan = input::LocationSpan(wordPartStartLocation,
                                                                     baseTextIter.getLocation());
-                            wordParts.push_back(arena.allocate<TextWordPartType>(locationSpan));
+                            addTextWordPart(wordParts, Kind::Text, quoteKind, locationSpan, true);
                         }
                         break;
                     }
@@ -1082,13 +1340,19 @@ private:
                             input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
                         if(dialect.duplicateDollarSingleQuoteStringBashParsingFlaws)
                         {
-                            wordParts.push_back(arena.allocate<BashBugEscapeSequenceWordPartType>(
-                                locationSpan, "\x01\x01"));
+                            wordParts.emplace_back(arena,
+                                                   Kind::BashBugEscapeSequence,
+                                                   quoteKind,
+                                                   locationSpan,
+                                                   "\x01\x01");
                         }
                         else
                         {
-                            wordParts.push_back(arena.allocate<SimpleEscapeSequenceWordPartType>(
-                                locationSpan, '\x01'));
+                            addEscapeSequenceWordPart(wordParts,
+                                                      Kind::SimpleEscapeSequence,
+                                                      quoteKind,
+                                                      locationSpan,
+                                                      '\x01');
                         }
                         break;
                     }
@@ -1098,8 +1362,11 @@ private:
                         ++baseTextIter;
                         auto locationSpan =
                             input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                        wordParts.push_back(arena.allocate<SimpleEscapeSequenceWordPartType>(
-                            locationSpan, ch & 0x1F));
+                        addEscapeSequenceWordPart(wordParts,
+                                                  Kind::SimpleEscapeSequence,
+                                                  quoteKind,
+                                                  locationSpan,
+                                                  ch & 0x1F);
                     }
                     }
                     wordPartStartLocation = baseTextIter.getLocation();
@@ -1111,8 +1378,8 @@ private:
                     ++baseTextIter;
                     auto locationSpan =
                         input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation());
-                    wordParts.push_back(
-                        arena.allocate<SimpleEscapeSequenceWordPartType>(locationSpan, ch));
+                    addEscapeSequenceWordPart(
+                        wordParts, Kind::SimpleEscapeSequence, quoteKind, locationSpan, ch);
                     wordPartStartLocation = baseTextIter.getLocation();
                     break;
                 }
@@ -1124,46 +1391,90 @@ private:
             }
         }
         if(wordPartStartLocation != baseTextIter.getLocation())
-            wordParts.push_back(
-                arena.allocate<ast::TextWordPart<ast::WordPart::QuoteKind::
-                                                     EscapeInterpretingSingleQuote>>(
-                    input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation())));
+            addTextWordPart(wordParts,
+                            Kind::Text,
+                            quoteKind,
+                            input::LocationSpan(wordPartStartLocation, baseTextIter.getLocation()),
+                            true);
         auto closingQuoteStartLocation = baseTextIter.getLocation();
         textIter = input::LineContinuationRemovingIterator(baseTextIter);
         ++textIter;
-        wordParts.push_back(arena.allocate<ast::QuoteWordPart<false,
-                                                              ast::WordPart::QuoteKind::
-                                                                  EscapeInterpretingSingleQuote>>(
-            input::LocationSpan(closingQuoteStartLocation, textIter.getLocation())));
-        return parserSuccess(std::move(wordParts));
+        wordParts.emplace_back(
+            arena,
+            Kind::QuoteStop,
+            quoteKind,
+            input::LocationSpan(closingQuoteStartLocation, textIter.getLocation()));
+        return parserSuccess();
     }
     ParseResult<util::ArenaPtr<ast::Word>> parseWord(
         input::LineContinuationRemovingIterator &textIter,
         std::size_t backquoteNestLevel,
         bool checkForVariableAssignment,
         bool checkForReservedWords)
+    {
+        // don't keep the word parts allocated before an error
+        auto checkpointValue = checkpoint();
+        auto retval = parseWordHelper(
+            textIter, backquoteNestLevel, checkForVariableAssignment, checkForReservedWords);
+        if(!retval)
+            rollbackTo(checkpointValue);
+        return retval;
+    }
+    ParseResult<util::ArenaPtr<ast::Word>> parseWordHelper(
+        input::LineContinuationRemovingIterator &textIter,
+        std::size_t backquoteNestLevel,
+        bool checkForVariableAssignment,
+        bool checkForReservedWords)
     {
         if(backquoteNestLevel > 0)
-            UNIMPLEMENTED();
+            return parserErrorStaticString("command substitutions are not supported", textIter);
         auto wordStartLocation = textIter.getLocation();
         if(!parseWordStartCharacter(copy(textIter), backquoteNestLevel))
             return parserErrorStaticString("missing word", textIter);
-        std::vector<util::ArenaPtr<ast::WordPart>> wordParts;
-        while(!parseUnquotedWordEndCharacter(copy(textIter), backquoteNestLevel))
+        typedef ast::CompactWordPart::Kind Kind;
+        typedef ast::WordPart::QuoteKind QuoteKind;
+        ast::Word::WordParts wordParts;
+        while(!isUnquotedWordEndCharacter(textIter, backquoteNestLevel))
         {
-            if(parseSimpleWordStartCharacter(copy(textIter)))
+            auto classes = getCharacterClasses(textIter);
+            // a `#` only starts a comment at the start of a word
+            if(classes & CharacterClass::simpleWordContinue)
             {
                 auto wordPartStartLocation = textIter.getLocation();
-                if(checkForVariableAssignment && !parseNameStartCharacter(copy(textIter)))
+                if(checkForVariableAssignment && !(classes & CharacterClass::nameStart))
                     checkForVariableAssignment = false;
                 for(;;)
                 {
-                    if(!parseSimpleWordContinueCharacter(copy(textIter)))
+                    if(!checkForVariableAssignment)
                     {
-                        wordParts.push_back(
-                            arena.allocate<ast::TextWordPart<ast::WordPart::QuoteKind::Unquoted>>(
-                                input::LocationSpan(wordPartStartLocation,
-                                                    textIter.getLocation())));
+                        // skip over the bytes that are always simple word characters; the rest
+                        // (like a lone CR) are handled below
+                        skipToFirstByteOf<'\"',
+                                          '\'',
+                                          '!',
+                                          '$',
+                                          '`',
+                                          '\\',
+                                          '|',
+                                          '&',
+                                          ';',
+                                          '(',
+                                          ')',
+                                          '<',
+                                          '>',
+                                          ' ',
+                                          '\t',
+                                          '\r',
+                                          '\n'>(textIter);
+                    }
+                    auto classes = getCharacterClasses(textIter);
+                    if(!(classes & CharacterClass::simpleWordContinue))
+                    {
+                        addTextWordPart(
+                            wordParts,
+                            Kind::Text,
+                            QuoteKind::Unquoted,
+                            input::LocationSpan(wordPartStartLocation, textIter.getLocation()));
                         checkForVariableAssignment = false;
                         break;
                     }
@@ -1171,14 +1482,20 @@ private:
                     {
                         if(*textIter == '=')
                         {
-                            wordParts.push_back(arena.allocate<ast::AssignmentVariableNameWordPart>(
-                                input::LocationSpan(wordPartStartLocation,
-                                                    textIter.getLocation())));
+                            addVariableNameWordPart(
+                                wordParts,
+                                input::LocationSpan(wordPartStartLocation, textIter.getLocation()));
                             auto equalsSignStartLocation = textIter.getLocation();
                             ++textIter;
-                            wordParts.push_back(arena.allocate<ast::AssignmentEqualSignWordPart>(
+                            addTextWordPart(
+                                wordParts,
+                                Kind::AssignmentEqualSign,
+                                QuoteKind::Unquoted,
                                 input::LocationSpan(equalsSignStartLocation,
-                                                    textIter.getLocation())));
+                                                    textIter.getLocation()));
+                            if(*textIter == '(')
+                                return parserErrorStaticString(
+                                    "array assignments are not supported", textIter);
                             checkForVariableAssignment = false;
                             break;
                         }
@@ -1188,15 +1505,20 @@ private:
                             ++textIter;
                             if(*textIter == '=')
                             {
-                                wordParts.push_back(
-                                    arena.allocate<ast::AssignmentVariableNameWordPart>(
-                                        input::LocationSpan(wordPartStartLocation,
-                                                            plusEqualsSignStartLocation)));
+                                addVariableNameWordPart(
+                                    wordParts,
+                                    input::LocationSpan(wordPartStartLocation,
+                                                        plusEqualsSignStartLocation));
                                 ++textIter;
-                                wordParts.push_back(
-                                    arena.allocate<ast::AssignmentPlusEqualSignWordPart>(
-                                        input::LocationSpan(plusEqualsSignStartLocation,
-                                                            textIter.getLocation())));
+                                addTextWordPart(
+                                    wordParts,
+                                    Kind::AssignmentPlusEqualSign,
+                                    QuoteKind::Unquoted,
+                                    input::LocationSpan(plusEqualsSignStartLocation,
+                                                        textIter.getLocation()));
+                                if(*textIter == '(')
+                                    return parserErrorStaticString(
+                                        "array assignments are not supported", textIter);
                                 checkForVariableAssignment = false;
                                 break;
                             }
@@ -1204,14 +1526,42 @@ private:
                         }
                         else if(*textIter == '[')
                         {
-                            UNIMPLEMENTED();
+                            // `name[subscript]=value` assigns to an array element; anything else
+                            // is just text
+                            auto textIter2 = textIter;
+                            ++textIter2;
+                            while(*textIter2 != ']'
+                                  && (getCharacterClasses(textIter2)
+                                      & CharacterClass::simpleWordContinue))
+                                ++textIter2;
+                            if(*textIter2 == ']')
+                            {
+                                ++textIter2;
+                                if(*textIter2 == '+')
+                                    ++textIter2;
+                                if(*textIter2 == '=')
+                                    return parserErrorStaticString(
+                                        "array element assignments are not supported", textIter);
+                            }
+                            checkForVariableAssignment = false;
                         }
-                        else if(!parseNameContinueCharacter(copy(textIter)))
+                        else if(!(classes & CharacterClass::nameContinue))
                             checkForVariableAssignment = false;
                     }
                     ++textIter;
                 }
             }
+            else if(*textIter == '!')
+            {
+                // history expansion isn't supported, so `!` is just text
+                auto wordPartStartLocation = textIter.getLocation();
+                ++textIter;
+                checkForVariableAssignment = false;
+                addTextWordPart(wordParts,
+                                Kind::Text,
+                                QuoteKind::Unquoted,
+                                input::LocationSpan(wordPartStartLocation, textIter.getLocation()));
+            }
             else if(*textIter == '\\')
             {
                 auto escapeStartLocation = textIter.getLocation();
@@ -1221,11 +1571,12 @@ private:
                     break;
                 char value = *baseTextIter;
                 ++baseTextIter;
-                wordParts.push_back(
-                    arena.allocate<ast::SimpleEscapeSequenceWordPart<ast::WordPart::QuoteKind::
-                                                                         Unquoted>>(
-                        input::LocationSpan(escapeStartLocation, baseTextIter.getLocation()),
-                        value));
+                addEscapeSequenceWordPart(
+                    wordParts,
+                    Kind::SimpleEscapeSequence,
+                    QuoteKind::Unquoted,
+                    input::LocationSpan(escapeStartLocation, baseTextIter.getLocation()),
+                    value);
                 textIter = input::LineContinuationRemovingIterator(baseTextIter);
             }
             else if(*textIter == '\'')
@@ -1233,37 +1584,38 @@ private:
                 auto openingQuoteStartLocation = textIter.getLocation();
                 auto baseTextIter = textIter.getBaseIterator();
                 ++baseTextIter;
-                wordParts.push_back(
-                    arena.allocate<ast::QuoteWordPart<true, ast::WordPart::QuoteKind::SingleQuote>>(
-                        input::LocationSpan(openingQuoteStartLocation,
-                                            baseTextIter.getLocation())));
+                wordParts.emplace_back(
+                    arena,
+                    Kind::QuoteStart,
+                    QuoteKind::SingleQuote,
+                    input::LocationSpan(openingQuoteStartLocation, baseTextIter.getLocation()));
                 auto quotedTextStartLocation = baseTextIter.getLocation();
-                while(*baseTextIter != '\'')
+                while(!skipToFirstByteOf<'\''>(baseTextIter))
                 {
                     if(*baseTextIter == input::eof)
                         return parserErrorStaticString("missing closing \'",
                                                        quotedTextStartLocation);
-                    ++baseTextIter;
                 }
-                wordParts.push_back(
-                    arena.allocate<ast::TextWordPart<ast::WordPart::QuoteKind::SingleQuote>>(
-                        input::LocationSpan(quotedTextStartLocation, baseTextIter.getLocation())));
+                addTextWordPart(
+                    wordParts,
+                    Kind::Text,
+                    QuoteKind::SingleQuote,
+                    input::LocationSpan(quotedTextStartLocation, baseTextIter.getLocation()),
+                    true);
                 auto closingQuoteStartLocation = baseTextIter.getLocation();
                 textIter = input::LineContinuationRemovingIterator(baseTextIter);
                 ++textIter;
-                wordParts.push_back(
-                    arena
-                        .allocate<ast::QuoteWordPart<false, ast::WordPart::QuoteKind::SingleQuote>>(
-                            input::LocationSpan(closingQuoteStartLocation,
-                                                textIter.getLocation())));
+                wordParts.emplace_back(
+                    arena,
+                    Kind::QuoteStop,
+                    QuoteKind::SingleQuote,
+                    input::LocationSpan(closingQuoteStartLocation, textIter.getLocation()));
             }
             else if(*textIter == '\"')
             {
-                auto result =
-                    parseDoubleQuoteString(textIter, std::move(wordParts), backquoteNestLevel);
+                auto result = parseDoubleQuoteString(textIter, wordParts, backquoteNestLevel);
                 if(!result)
-                    return result.getError();
-                wordParts = std::move(result.get());
+                    return ParseFailure();
             }
             else if(*textIter == '$')
             {
@@ -1272,19 +1624,20 @@ private:
                 if(dialect.allowDollarSingleQuoteStrings && *textIter == '\'')
                 {
                     auto result = parseDollarSingleQuoteString(
-                        textIter, std::move(wordParts), dollarSignLocation, backquoteNestLevel);
+                        textIter, wordParts, dollarSignLocation, backquoteNestLevel);
                     if(!result)
-                        return result.getError();
-                    wordParts = std::move(result.get());
+                        return ParseFailure();
                 }
                 else
                 {
-                    UNIMPLEMENTED();
+                    return unsupportedDollarExpansionError(textIter, dollarSignLocation);
                 }
             }
             else
             {
-                UNIMPLEMENTED();
+                assert(*textIter == '`');
+                return parserErrorStaticString("command substitutions are not supported",
+                                               textIter);
             }
         }
         if(wordParts.empty())
@@ -1292,31 +1645,41 @@ private:
         if(checkForReservedWords && wordParts.size() == 1)
         {
             auto &wordPart = wordParts.front();
-            if(util::dynamic_pointer_cast<ast::TextWordPart<ast::WordPart::QuoteKind::Unquoted>>(
-                   wordPart))
+            if(wordPart.kind == Kind::Text && wordPart.quoteKind == QuoteKind::Unquoted)
             {
-                auto result = stringToReservedWord(wordPart->getSourceText());
+                auto result = stringToReservedWord(wordPart.getCookedText());
                 if(result.is<ReservedWord>())
                 {
-                    wordPart = ast::GenericReservedWordPart::make(
-                        arena, wordPart->location, result.get<ReservedWord>());
+                    auto reservedWord = result.get<ReservedWord>();
+                    wordPart = ast::CompactWordPart(reservedWord,
+                                                    wordPart.getSimpleLocationSpan(),
+                                                    getReservedWordString(reservedWord));
                 }
             }
         }
-        return parserSuccess(arena.allocate<ast::Word>(
-            input::LocationSpan(wordStartLocation, textIter.getLocation()), std::move(wordParts)));
+        auto word = arena.allocate<ast::Word>(
+            input::LocationSpan(wordStartLocation, textIter.getLocation()), std::move(wordParts));
+        if(symbolIdReferences)
+        {
+            // the parts don't move once they're in the word
+            for(auto &wordPart : word->wordParts)
+                if(wordPart.symbol)
+                    symbolIdReferences->push_back(&wordPart.symbol);
+        }
+        return parserSuccess(word);
     }
     ParseResult<util::ArenaPtr<ast::Comment>> parseComment(
         input::LineContinuationRemovingIterator &textIter, std::size_t backquoteNestLevel)
     {
         if(backquoteNestLevel > 0)
-            UNIMPLEMENTED();
+            return parserErrorStaticString("command substitutions are not supported", textIter);
         auto commentStartLocation = textIter.getLocation();
         if(*textIter != '#')
             return parserErrorStaticString("missing comment", textIter);
         auto baseTextIter = textIter.getBaseIterator();
         for(;;)
         {
+            skipToFirstByteOf<'\r', '\n', '`'>(baseTextIter);
             if(backquoteNestLevel > 0 && *baseTextIter == '`')
             {
                 if(dialect.errorOnBackquoteEndingComment)
@@ -1334,8 +1697,271 @@ private:
         return parserSuccess(arena.allocate<ast::Comment>(
             input::LocationSpan(commentStartLocation, textIter.getLocation())));
     }
+
+private:
+    // command-level parsing; defined in parser.cpp
+
+    enum class ControlOperator
+    {
+        Semicolon, // ";"
+        DoubleSemicolon, // ";;"
+        SemicolonAmpersand, // ";&"
+        DoubleSemicolonAmpersand, // ";;&"
+        Ampersand, // "&"
+        DoubleAmpersand, // "&&"
+        Pipe, // "|"
+        PipeAmpersand, // "|&"
+        DoublePipe, // "||"
+        LParen, // "("
+        RParen, // ")"
+    };
+    static util::string_view getControlOperatorString(ControlOperator controlOperator) noexcept;
+    /** probe for a control operator other than newline; `&>` is a redirection instead */
+    bool parseControlOperator(input::LineContinuationRemovingIterator &textIter,
+                              ControlOperator &controlOperator);
+    /** probe for an optional file descriptor followed by a redirection operator */
+    bool parseRedirectionOperator(input::LineContinuationRemovingIterator &textIter,
+                                  int &fileDescriptor,
+                                  ast::Redirection::Kind &kind);
+    bool isAtRedirection(const input::LineContinuationRemovingIterator &textIter)
+    {
+        auto textIter2 = textIter;
+        int fileDescriptor;
+        ast::Redirection::Kind kind;
+        return parseRedirectionOperator(textIter2, fileDescriptor, kind);
+    }
+    /** probe for a whole unquoted word that is a reserved word */
+    bool parseReservedWord(input::LineContinuationRemovingIterator &textIter,
+                           ReservedWord &reservedWord);
+    bool isAtReservedWord(const input::LineContinuationRemovingIterator &textIter,
+                          ReservedWord expectedReservedWord)
+    {
+        auto textIter2 = textIter;
+        ReservedWord reservedWord;
+        return parseReservedWord(textIter2, reservedWord) && reservedWord == expectedReservedWord;
+    }
+    bool isAtWordStart(const input::LineContinuationRemovingIterator &textIter)
+    {
+        return getCharacterClasses(textIter) & CharacterClass::wordStart;
+    }
+    bool isAtNewLine(const input::LineContinuationRemovingIterator &textIter)
+    {
+        return getCharacterClasses(textIter) & CharacterClass::newLine;
+    }
+    /** true if `word` is unquoted literal text, as needed for function names */
+    static bool isLiteralWord(const ast::Word &word) noexcept;
+    /** true if `word` is a valid variable name */
+    static bool isNameWord(const ast::Word &word) noexcept;
+    bool isAtCompoundCommand(const input::LineContinuationRemovingIterator &textIter);
+    /** true at the end of the commands in a compound command: before a reserved word like `fi`
+     * or `}`, before `)` or a case item terminator, or at EOF */
+    bool isAtCompoundListEnd(const input::LineContinuationRemovingIterator &textIter);
+    void skipBlanks(input::LineContinuationRemovingIterator &textIter)
+    {
+        while(getCharacterClasses(textIter) & CharacterClass::blank)
+            ++textIter;
+    }
+    /** a `Blank` for `location`, or an empty `BlankOrEmpty` if `location` is empty */
+    util::ArenaPtr<ast::BlankOrEmpty> makeBlankOrEmpty(const input::LocationSpan &location)
+    {
+        if(location.size() == 0)
+            return arena.allocate<ast::BlankOrEmpty>(location);
+        return arena.allocate<ast::Blank>(location);
+    }
+    /** describes the token at `location` for error messages, like "`fi`" or "newline" */
+    std::string getTokenDescription(input::SimpleLocation location);
+    ParseFailure unexpectedTokenError(input::SimpleLocation location) noexcept;
+    ParseFailure unexpectedTokenError(const input::LineContinuationRemovingIterator &textIter)
+    {
+        return unexpectedTokenError(textIter.getLocation());
+    }
+    /** `expectedToken` must be a string literal */
+    ParseFailure expectedTokenError(input::SimpleLocation location,
+                                    util::string_view expectedToken) noexcept;
+    /** probe for an operator inside `[[ ]]` that's written as a word, like `-f` or `==`; sets
+     * `operatorText` to a string literal */
+    bool parseConditionalOperator(input::LineContinuationRemovingIterator &textIter,
+                                  bool isBinary,
+                                  util::string_view &operatorText);
+    ParseResult<> parseExpectedReservedWord(input::LineContinuationRemovingIterator &textIter,
+                                            ReservedWord reservedWord);
+    /** reads lines up to and including the line that is `delimiter`, and sets `bodyEndLocation` to
+     * the start of that line; returns false if EOF comes first */
+    bool parseHereDocumentBody(input::TextInput::Iterator &textIter,
+                               const std::string &delimiter,
+                               bool stripTabs,
+                               input::Location &bodyEndLocation);
+    /** reads the bodies of `pendingHereDocuments`, starting at `textIter` */
+    ParseResult<> parseHereDocumentBodies(input::TextInput::Iterator &textIter);
+    /** parses a newline, then the bodies of the here-documents started on the line it ends */
+    ParseResult<> parseNewLineAndHereDocuments(input::LineContinuationRemovingIterator &textIter);
+    /** skips blanks, comments and newlines */
+    ParseResult<> parseLineBreak(input::LineContinuationRemovingIterator &textIter);
+    /** parses commands separated by `;`, `&` and, unless `isTopLevel`, newlines.
+     *
+     * A top-level list stops before the newline that ends it, so nothing after that newline is
+     * read. Returns the command itself if there's only one, not run in the background.
+     * */
+    ParseResult<util::ArenaPtr<ast::Command>> parseCommandList(
+        input::LineContinuationRemovingIterator &textIter, bool isTopLevel);
+    ParseResult<util::ArenaPtr<ast::Command>> parseAndOrList(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::Command>> parsePipeline(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::Command>> parseCommand(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::Redirection>> parseRedirection(
+        input::LineContinuationRemovingIterator &textIter);
+    /** parses the redirections after a compound command */
+    ParseResult<> parseRedirections(input::LineContinuationRemovingIterator &textIter,
+                                    ast::CompoundCommand::Redirections &redirections);
+    ParseResult<util::ArenaPtr<ast::Command>> parseSimpleCommand(
+        input::LineContinuationRemovingIterator &textIter);
+    /** parses the rest of a function definition, from the parentheses after the name */
+    ParseResult<util::ArenaPtr<ast::Command>> parseFunctionDefinitionRest(
+        input::LineContinuationRemovingIterator &textIter,
+        input::Location startLocation,
+        util::ArenaPtr<ast::Word> name,
+        bool usesFunctionKeyword);
+    ParseResult<util::ArenaPtr<ast::Command>> parseFunctionKeywordDefinition(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::Command>> parseCoprocCommand(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::CompoundCommand>> parseCompoundCommand(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::CompoundCommand>> parseBraceGroup(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::CompoundCommand>> parseSubshell(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::CompoundCommand>> parseIfCommand(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::CompoundCommand>> parseWhileCommand(
+        input::LineContinuationRemovingIterator &textIter, bool isUntil);
+    ParseResult<util::ArenaPtr<ast::CompoundCommand>> parseForCommand(
+        input::LineContinuationRemovingIterator &textIter, bool isSelect);
+    /** parses `do list done` */
+    ParseResult<util::ArenaPtr<ast::Command>> parseDoGroup(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::CompoundCommand>> parseCaseCommand(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::CompoundCommand>> parseConditionalCommand(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::ConditionalExpression>> parseConditionalOrExpression(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::ConditionalExpression>> parseConditionalAndExpression(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::ConditionalExpression>> parseConditionalNotExpression(
+        input::LineContinuationRemovingIterator &textIter);
+    ParseResult<util::ArenaPtr<ast::ConditionalExpression>> parseConditionalPrimaryExpression(
+        input::LineContinuationRemovingIterator &textIter);
+    // the skip-scan for lazily parsed function bodies and top-level split points: it only tracks
+    // enough of the syntax (quotes, expansions, here-documents, comments, reserved words in
+    // command position, `case` patterns and `[[ ]]`) to find where a body or command ends. They
+    // return false where the scan can't be sure, and the text is then parsed normally.
+
+    struct SkipScanHereDocument final
+    {
+        std::string delimiter;
+        bool stripTabs;
+        SkipScanHereDocument(std::string delimiter, bool stripTabs)
+            : delimiter(std::move(delimiter)), stripTabs(stripTabs)
+        {
+        }
+    };
+    /** skips commands up to and including `closer`, which is `}` or `)`, with `textIter`
+     * starting after the matching opener; or `\n` to skip one top-level command up to the
+     * newline that ends it and the here-document bodies after that newline */
+    bool skipScanCommands(input::LineContinuationRemovingIterator &textIter,
+                          char closer,
+                          std::vector<SkipScanHereDocument> &hereDocuments);
+    /** skips a word; if `text` isn't null, the word's text after quote removal is appended to it */
+    bool skipScanWord(input::LineContinuationRemovingIterator &textIter,
+                      std::vector<SkipScanHereDocument> &hereDocuments,
+                      std::string *text = nullptr);
+    /** skips a `"` string, starting after the opening quote */
+    bool skipScanDoubleQuoteString(input::LineContinuationRemovingIterator &textIter,
+                                   std::vector<SkipScanHereDocument> &hereDocuments,
+                                   std::string *text);
+    /** skips an expansion starting with `$` */
+    bool skipScanDollar(input::LineContinuationRemovingIterator &textIter,
+                        std::vector<SkipScanHereDocument> &hereDocuments);
+    /** returns the first token from `index` on that is of `kind`, or the `EndOfFile` token; with
+     * `backslashEscapes`, the token after a backslash is skipped. The tokens don't have line
+     * continuations removed, so this is only for comments, single quotes and backquotes, where
+     * removing them can't change where the text ends. */
+    Token skipScanToToken(std::size_t index, Token::Kind kind, bool backslashEscapes);
+    /** skips a backquoted command substitution, starting after the opening backquote */
+    bool skipScanBackquote(input::LineContinuationRemovingIterator &textIter);
+    /** skips an arithmetic expression, starting after the `((` and ending after the `))` */
+    bool skipScanArithmetic(input::LineContinuationRemovingIterator &textIter,
+                            std::vector<SkipScanHereDocument> &hereDocuments);
+    /** parses the compound command that is a function's body; in lazy mode, a `{ }` or `( )`
+     * body is only skip-scanned and becomes an `ast::LazyFunctionBody` */
+    ParseResult<util::ArenaPtr<ast::CompoundCommand>> parseFunctionBody(
+        input::LineContinuationRemovingIterator &textIter);
+    /** skips the rest of the line after a syntax error, then throws it */
+    void throwTopLevelParseError();
+
+public:
+    /** skip-scans the complete commands from where `parseTopLevelCommand` continues, and returns
+     * the indexes of command starts that split the input into regions of at least
+     * `minimumRegionSize` bytes. Parsing from a split point after `setTopLevelIndex` gives the
+     * same commands as parsing up to it does. The scan stops early where it can't be sure of the
+     * syntax, leaving the rest of the input as one region. */
+    std::vector<std::size_t> findTopLevelSplitPoints(std::size_t minimumRegionSize);
+    /** the index that `parseTopLevelCommand` continues from */
+    std::size_t getTopLevelIndex() const
+    {
+        return getTextIndex(topLevelTextIter);
+    }
+    /** makes `parseTopLevelCommand` continue from `index`, which must be at the start of a line
+     * and not in a here-document body */
+    void setTopLevelIndex(std::size_t index)
+    {
+        pendingHereDocuments.clear();
+        topLevelTextIter = input::LineContinuationRemovingIterator(textInput.iteratorAt(index));
+    }
+    /** when not null, the address of every symbol id stored in the AST is appended to
+     * `references`, and variable names get their own copy of their text instead of sharing the
+     * symbol table's, so the AST can be moved to a different symbol table by remapping the ids. */
+    void setSymbolIdReferences(std::vector<util::SymbolId *> *references) noexcept
+    {
+        symbolIdReferences = references;
+    }
+
+public:
+    /** parses the next complete command from the input, reading no further than the newline that
+     * ends it (and any here-document bodies that start after that newline), so it can be run
+     * before the rest of the input is available.
+     *
+     * Returns `ParseCommandResult::NoCommand` for lines with only blanks or a comment and
+     * `ParseCommandResult::Quit` at the end of the input. Throws `ParseError` on syntax errors,
+     * after skipping the rest of the line, so parsing can continue with the next line.
+     * */
+    ParseCommandResult parseTopLevelCommand(util::ArenaPtr<ast::Command> &command);
+    /** when enabled, function bodies in braces or parentheses are only scanned for their end when
+     * the function is defined, and are parsed by `getFunctionBody` when first needed, so sourcing
+     * a big library of functions only pays for the functions that are used. Syntax errors in a
+     * body are then reported by `getFunctionBody`. Off by default. */
+    void setParseFunctionBodiesLazily(bool value) noexcept
+    {
+        parseFunctionBodiesLazily = value;
+    }
+    bool getParseFunctionBodiesLazily() const noexcept
+    {
+        return parseFunctionBodiesLazily;
+    }
+    /** returns the body of `functionDefinition`, first parsing it and replacing
+     * `functionDefinition.body` if it is an `ast::LazyFunctionBody`. Throws `ParseError` if the
+     * body has a syntax error. */
+    util::ArenaPtr<ast::CompoundCommand> getFunctionBody(
+        ast::FunctionDefinition &functionDefinition);
 #warning finish
 public:
+    /** dumps each top-level command to `std::cout` and reports syntax errors to `std::cerr`,
+     * until the end of the input. The input before each command is released with
+     * `TextInput::setLowWaterMark` once the command is done, so memory use doesn't grow with the
+     * input. */
     void test();
 };
 }
@@ -17,8 +17,6 @@
 #define PARSER_RESERVED_WORD_H_
 
 #include <cassert>
-#include <algorithm>
-#include <tuple>
 #include "../util/string_view.h"
 #include "../util/compiler_intrinsics.h"
 #include "../util/variant.h"
@@ -161,70 +159,110 @@ inline util::string_view getReservedWordName(ReservedWord v) noexcept
 
 inline util::variant<ReservedWord> stringToReservedWord(util::string_view v) noexcept
 {
-    struct StringAndReservedWord
+    // the length and first character leave at most one candidate (two for "if" and "in", which
+    // the second character decides), which is then compared directly, so this runs on the input
+    // bytes without building a string or searching a table
+    ReservedWord candidate;
+    switch(v.size())
     {
-        util::string_view string;
-        ReservedWord reservedWord;
-        constexpr StringAndReservedWord(util::string_view string,
-                                        ReservedWord reservedWord) noexcept
-            : string(string),
-              reservedWord(reservedWord)
+    case 1:
+        switch(v[0])
         {
+        case '!':
+            return util::variant<ReservedWord>(ReservedWord::ExMark);
+        case '{':
+            return util::variant<ReservedWord>(ReservedWord::LBrace);
+        case '}':
+            return util::variant<ReservedWord>(ReservedWord::RBrace);
+        default:
+            return util::variant<ReservedWord>();
         }
-    };
-    struct Comparer
-    {
-        bool operator()(StringAndReservedWord a, StringAndReservedWord b) const noexcept
+    case 2:
+        switch(v[0])
         {
-            return a.string < b.string;
+        case '[':
+            candidate = ReservedWord::DoubleLBracket;
+            break;
+        case ']':
+            candidate = ReservedWord::DoubleRBracket;
+            break;
+        case 'd':
+            candidate = ReservedWord::Do;
+            break;
+        case 'f':
+            candidate = ReservedWord::Fi;
+            break;
+        case 'i':
+            candidate = v[1] == 'n' ? ReservedWord::In : ReservedWord::If;
+            break;
+        default:
+            return util::variant<ReservedWord>();
         }
-        bool operator()(util::string_view a, StringAndReservedWord b) const noexcept
+        break;
+    case 3:
+        if(v[0] != 'f')
+            return util::variant<ReservedWord>();
+        candidate = ReservedWord::For;
+        break;
+    case 4:
+        switch(v[0])
         {
-            return a < b.string;
+        case 'c':
+            candidate = ReservedWord::Case;
+            break;
+        case 'd':
+            candidate = ReservedWord::Done;
+            break;
+        case 'e':
+            if(v[1] == 's')
+                candidate = ReservedWord::Esac;
+            else
+                candidate = v[2] == 'i' ? ReservedWord::ElIf : ReservedWord::Else;
+            break;
+        case 't':
+            candidate = v[1] == 'i' ? ReservedWord::Time : ReservedWord::Then;
+            break;
+        default:
+            return util::variant<ReservedWord>();
         }
-        bool operator()(StringAndReservedWord a, util::string_view b) const noexcept
+        break;
+    case 5:
+        switch(v[0])
         {
-            return a.string < b;
+        case 'u':
+            candidate = ReservedWord::Until;
+            break;
+        case 'w':
+            candidate = ReservedWord::While;
+            break;
+        default:
+            return util::variant<ReservedWord>();
         }
-        bool operator()(util::string_view a, util::string_view b) const noexcept
+        break;
+    case 6:
+        switch(v[0])
         {
-            return a < b;
+        case 'c':
+            candidate = ReservedWord::Coproc;
+            break;
+        case 's':
+            candidate = ReservedWord::Select;
+            break;
+        default:
+            return util::variant<ReservedWord>();
         }
-    };
-    static const StringAndReservedWord mappingTable[] = {
-        {"!", ReservedWord::ExMark},
-        {"[[", ReservedWord::DoubleLBracket},
-        {"]]", ReservedWord::DoubleRBracket},
-        {"case", ReservedWord::Case},
-        {"coproc", ReservedWord::Coproc},
-        {"do", ReservedWord::Do},
-        {"done", ReservedWord::Done},
-        {"elif", ReservedWord::ElIf},
-        {"else", ReservedWord::Else},
-        {"esac", ReservedWord::Esac},
-        {"fi", ReservedWord::Fi},
-        {"for", ReservedWord::For},
-        {"function", ReservedWord::Function},
-        {"if", ReservedWord::If},
-        {"in", ReservedWord::In},
-        {"select", ReservedWord::Select},
-        {"then", ReservedWord::Then},
-        {"time", ReservedWord::Time},
-        {"until", ReservedWord::Until},
-        {"while", ReservedWord::While},
-        {"{", ReservedWord::LBrace},
-        {"}", ReservedWord::RBrace},
-    };
-    static const bool isSorted =
-        std::is_sorted(std::begin(mappingTable), std::end(mappingTable), Comparer());
-    assert(isSorted);
-    auto results =
-        std::equal_range(std::begin(mappingTable), std::end(mappingTable), v, Comparer());
-    auto *first = std::get<0>(results);
-    auto *last = std::get<1>(results);
-    if(first == last)
+        break;
+    case 8:
+        if(v[0] != 'f')
+            return util::variant<ReservedWord>();
+        candidate = ReservedWord::Function;
+        break;
+    default:
+        return util::variant<ReservedWord>();
+    }
+    if(v != getReservedWordString(candidate))
         return util::variant<ReservedWord>();
-    return util::variant<ReservedWord>(first->reservedWord);
+    return util::variant<ReservedWord>(candidate);
 }
 }
 }
@@ -0,0 +1,222 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Checks IncrementalParser against parsing the edited text from scratch after every edit: the
+ * items must have the same spans, commands and syntax errors. Runs a few edits that used to go
+ * wrong, then random edits with a fixed seed. Exits with 1 at the first difference.
+ *
+ * Build from the repository root:
+ *     g++ -std=c++11 -g -fsanitize=address,undefined -I. test/incremental_parser.cpp \
+ *         parser/parser.cpp parser/lexer.cpp parser/incremental_parser.cpp input/text_input.cpp \
+ *         input/editable.cpp input/memory.cpp input/location.cpp ast/ast_base.cpp ast/blank.cpp \
+ *         ast/comment.cpp ast/command.cpp ast/conditional_expression.cpp ast/redirection.cpp \
+ *         ast/word.cpp ast/word_part.cpp util/arena.cpp util/symbol_table.cpp \
+ *         -o test_incremental_parser
+ */
+
+#include "../input/memory.h"
+#include "../parser/incremental_parser.h"
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace quick_shell;
+
+namespace
+{
+/** the parts of a `TopLevelItem` that don't depend on when it was parsed */
+struct Item final
+{
+    std::size_t beginIndex;
+    std::size_t endIndex;
+    /** the command's span in the current input, or empty for no command */
+    std::size_t commandBeginIndex;
+    std::size_t commandEndIndex;
+    std::string error;
+    bool operator==(const Item &rt) const
+    {
+        return beginIndex == rt.beginIndex && endIndex == rt.endIndex
+               && commandBeginIndex == rt.commandBeginIndex
+               && commandEndIndex == rt.commandEndIndex && error == rt.error;
+    }
+    bool operator!=(const Item &rt) const
+    {
+        return !operator==(rt);
+    }
+};
+
+std::ostream &operator<<(std::ostream &os, const Item &item)
+{
+    os << "[" << item.beginIndex << ", " << item.endIndex << ")";
+    if(item.commandBeginIndex != item.commandEndIndex)
+        os << " command [" << item.commandBeginIndex << ", " << item.commandEndIndex << ")";
+    if(!item.error.empty())
+        os << " error: " << item.error;
+    return os;
+}
+
+std::vector<Item> parseFromScratch(const std::string &text)
+{
+    input::MemoryTextInput textInput("test", input::TextInputStyle(), text);
+    util::Arena arena;
+    util::SymbolTable symbolTable;
+    parser::Parser parser(textInput, arena, symbolTable, parser::ParserDialect::getBashDialect());
+    std::vector<Item> retval;
+    while(true)
+    {
+        std::size_t beginIndex = parser.getTopLevelIndex();
+        util::ArenaPtr<ast::Command> command;
+        std::string error;
+        try
+        {
+            if(parser.parseTopLevelCommand(command) == parser::ParseCommandResult::Quit)
+                break;
+        }
+        catch(parser::ParseError &e)
+        {
+            error = e.message;
+        }
+        Item item{beginIndex, parser.getTopLevelIndex(), 0, 0, error};
+        if(command)
+        {
+            item.commandBeginIndex = command->getSimpleLocationSpan().beginIndex;
+            item.commandEndIndex = command->getSimpleLocationSpan().endIndex;
+        }
+        retval.push_back(item);
+    }
+    return retval;
+}
+
+std::vector<Item> getItems(const parser::IncrementalParser &incrementalParser)
+{
+    std::vector<Item> retval;
+    for(auto &topLevelItem : incrementalParser.getItems())
+    {
+        Item item{topLevelItem.location.beginIndex,
+                  topLevelItem.location.endIndex,
+                  0,
+                  0,
+                  topLevelItem.error ? topLevelItem.error->message : std::string()};
+        if(topLevelItem.command)
+        {
+            auto span = topLevelItem.command->getSimpleLocationSpan();
+            item.commandBeginIndex = span.beginIndex + topLevelItem.indexOffset;
+            item.commandEndIndex = span.endIndex + topLevelItem.indexOffset;
+        }
+        retval.push_back(item);
+    }
+    return retval;
+}
+
+class Checker final
+{
+private:
+    std::string text;
+    input::EditableTextInput textInput;
+    util::SymbolTable symbolTable;
+    parser::IncrementalParser incrementalParser;
+    std::size_t editCount;
+
+public:
+    explicit Checker(const std::string &text)
+        : text(text),
+          textInput("test", input::TextInputStyle(), text),
+          symbolTable(),
+          incrementalParser(textInput, symbolTable, parser::ParserDialect::getBashDialect()),
+          editCount(0)
+    {
+    }
+    std::size_t size() const noexcept
+    {
+        return text.size();
+    }
+    bool replace(std::size_t beginIndex, std::size_t endIndex, const std::string &newText)
+    {
+        editCount++;
+        text.replace(beginIndex, endIndex - beginIndex, newText);
+        incrementalParser.replace(beginIndex, endIndex, newText);
+        auto expected = parseFromScratch(text);
+        auto actual = getItems(incrementalParser);
+        if(actual == expected)
+            return true;
+        std::cout << "edit " << editCount << ": replacing [" << beginIndex << ", " << endIndex
+                  << ") with \"" << newText << "\" gave:" << std::endl;
+        for(auto &item : actual)
+            std::cout << "    " << item << std::endl;
+        std::cout << "instead of:" << std::endl;
+        for(auto &item : expected)
+            std::cout << "    " << item << std::endl;
+        return false;
+    }
+};
+
+bool checkKnownEdits()
+{
+    // closing a quote that the first line left open
+    Checker checker("echo \"a\nb\nc\necho d\n");
+    if(!checker.replace(11, 11, "\""))
+        return false;
+    // and opening it again
+    if(!checker.replace(11, 12, ""))
+        return false;
+    // a CR before an LF only becomes a newline together with it
+    Checker crChecker("echo a\r\necho b\n");
+    return crChecker.replace(7, 8, "") && crChecker.replace(7, 7, "\n");
+}
+
+bool checkRandomEdits()
+{
+    static const char *const snippets[] = {
+        "x",         "\n",          "echo hi\n", "if true; then\n", "fi\n",    "'",
+        "\"",        "cat <<EOF\n", "EOF\n",     "\\\n",           "{ ",      "}",
+        "(",         ")",           ";;",        "case a in\n",     "esac\n",  "#",
+        " && ",      "a=b ",        "f() ",      "\\",             "\r\n",    "coproc ",
+        "$x",        "\"$x\"",      "`",         "$(",             "a[i]=v ", "$",
+    };
+    std::ostringstream initialText;
+    for(std::size_t i = 0; i < 20; i++)
+        initialText << "echo line" << i << " 'quoted " << i << "' \"double\"\n"
+                    << "if true; then echo yes; fi\n"
+                    << "for i in 1 2 3; do echo $i \"$i\" `date`; done\n"
+                    << "cat <<EOF\nbody " << i << "\nEOF\n";
+    Checker checker(initialText.str());
+    std::mt19937 randomEngine(1);
+    for(std::size_t i = 0; i < 3000; i++)
+    {
+        std::size_t beginIndex = randomEngine() % (checker.size() + 1);
+        std::size_t endIndex = beginIndex;
+        if(randomEngine() % 3 == 0)
+            endIndex = std::min(checker.size(), beginIndex + randomEngine() % 20);
+        std::string newText = snippets[randomEngine() % (sizeof(snippets) / sizeof(snippets[0]))];
+        if(randomEngine() % 4 == 0)
+            newText.clear();
+        if(!checker.replace(beginIndex, endIndex, newText))
+            return false;
+    }
+    return true;
+}
+}
+
+int main()
+{
+    bool passed = checkKnownEdits() && checkRandomEdits();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
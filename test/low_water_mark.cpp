@@ -0,0 +1,139 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Checks that Parser::test releases a streamed input as it goes: when the input reads more text,
+ * the text it still keeps before that is at most a few chunks, though the whole input is over
+ * 700 KB. The input has a syntax error every 997 lines, and the errors must still be reported with
+ * the right line numbers after the lines before them were released. Exits with 1 on failure.
+ *
+ * Build from the repository root:
+ *     g++ -std=c++11 -g -fsanitize=address,undefined -I. test/low_water_mark.cpp \
+ *         parser/parser.cpp parser/lexer.cpp input/text_input.cpp input/location.cpp \
+ *         ast/ast_base.cpp ast/blank.cpp ast/comment.cpp ast/command.cpp \
+ *         ast/conditional_expression.cpp ast/redirection.cpp ast/word.cpp ast/word_part.cpp \
+ *         util/arena.cpp util/symbol_table.cpp -o test_low_water_mark
+ */
+
+#include "../input/text_input.h"
+#include "../parser/parser.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace quick_shell;
+
+namespace
+{
+constexpr std::size_t lineCount = 50000;
+constexpr std::size_t errorLineInterval = 997;
+
+/** hands out `text` a little at a time, like a pipe, and records how much text before each read
+ * is still kept */
+class StreamedTextInput final : public input::TextInput
+{
+private:
+    std::string text;
+
+public:
+    std::size_t maxKeptSize;
+
+protected:
+    virtual std::size_t read(std::size_t startIndex,
+                             unsigned char *buffer,
+                             std::size_t bufferSize) override
+    {
+        maxKeptSize = std::max(maxKeptSize, startIndex - getLowWaterMark());
+        if(startIndex >= text.size())
+            return 0;
+        std::size_t count = std::min<std::size_t>({bufferSize, text.size() - startIndex, 1000});
+        std::memcpy(buffer, text.data() + startIndex, count);
+        return count;
+    }
+
+public:
+    explicit StreamedTextInput(std::string text)
+        : TextInput("test", input::TextInputStyle(), false), text(std::move(text)), maxKeptSize(0)
+    {
+    }
+};
+}
+
+int main()
+{
+    std::ostringstream text;
+    std::vector<std::string> expectedErrorPrefixes;
+    for(std::size_t line = 1; line <= lineCount; line++)
+    {
+        if(line % errorLineInterval == 0)
+        {
+            text << "echo )\n";
+            std::ostringstream os;
+            os << "error: test:" << line << ":6: ";
+            expectedErrorPrefixes.push_back(os.str());
+        }
+        else
+        {
+            text << "echo line" << line << "\n";
+        }
+    }
+    StreamedTextInput textInput(text.str());
+    util::Arena arena;
+    util::SymbolTable symbolTable;
+    parser::Parser parser(textInput, arena, symbolTable, parser::ParserDialect::getBashDialect());
+    std::ostringstream output, errors;
+    auto *coutBuffer = std::cout.rdbuf(output.rdbuf());
+    auto *cerrBuffer = std::cerr.rdbuf(errors.rdbuf());
+    parser.test();
+    std::cout.rdbuf(coutBuffer);
+    std::cerr.rdbuf(cerrBuffer);
+    bool passed = true;
+    std::size_t inputSize = text.str().size();
+    if(textInput.maxKeptSize > 3 * 4096)
+    {
+        std::cout << textInput.maxKeptSize << " bytes were still kept when reading more"
+                  << std::endl;
+        passed = false;
+    }
+    std::istringstream errorLines(errors.str());
+    std::string errorLine;
+    std::size_t errorCount = 0;
+    while(std::getline(errorLines, errorLine))
+    {
+        if(errorCount >= expectedErrorPrefixes.size()
+           || errorLine.compare(0,
+                                expectedErrorPrefixes[errorCount].size(),
+                                expectedErrorPrefixes[errorCount])
+                  != 0)
+        {
+            std::cout << "unexpected error: " << errorLine << std::endl;
+            passed = false;
+            break;
+        }
+        errorCount++;
+    }
+    if(passed && errorCount != expectedErrorPrefixes.size())
+    {
+        std::cout << "only " << errorCount << " errors were reported" << std::endl;
+        passed = false;
+    }
+    std::cout << (passed ? "passed" : "failed") << ": " << inputSize << " bytes, at most "
+              << textInput.maxKeptSize << " kept" << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Checks that parseInParallel gives the same commands, symbol table and symbol ids as parsing
+ * sequentially, on a generated script big enough to be split into many regions, and that the symbol
+ * id references the regions' parsers record are exactly the ids in their commands, of which only
+ * names are interned. The scripts have `coproc NAME arg` lines, where the parser parses `NAME` as a
+ * possible name and then rolls it back. Also checks scripts with expansions and backquotes, which
+ * the parser doesn't support yet: in lazily parsed function bodies they are only reported by
+ * getFunctionBody, and at the top level the parallel parse throws the same error as the sequential
+ * one. Exits with 1 on any difference.
+ *
+ * Build from the repository root:
+ *     g++ -std=c++11 -g -fsanitize=address,undefined -I. test/parallel_parser.cpp \
+ *         parser/parser.cpp parser/lexer.cpp parser/parallel_parser.cpp input/text_input.cpp \
+ *         input/memory.cpp input/location.cpp ast/ast_base.cpp ast/blank.cpp ast/comment.cpp \
+ *         ast/command.cpp ast/conditional_expression.cpp ast/redirection.cpp ast/word.cpp \
+ *         ast/word_part.cpp util/arena.cpp util/symbol_table.cpp -pthread -o test_parallel_parser
+ */
+
+#include "../input/memory.h"
+#include "../parser/parallel_parser.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace quick_shell;
+
+namespace
+{
+std::string makeScript()
+{
+    std::ostringstream os;
+    for(std::size_t i = 0; i < 20000; i++)
+    {
+        os << "coproc name" << i << " arg" << i % 7 << "\n";
+        os << "coproc worker" << i % 13 << " { echo started; }\n";
+        os << "v" << i % 101 << "=" << i << " w" << i % 3 << "+=x command" << i % 11 << " 'a b'\n";
+        os << "if true; then echo \"yes " << i << "\"; fi\n";
+        os << "f" << i % 17 << "() { echo body" << i % 5 << "; }\n";
+    }
+    return os.str();
+}
+
+void appendSymbolIds(const ast::Word &word, std::vector<const util::SymbolId *> &symbolIds)
+{
+    for(auto &wordPart : word.wordParts)
+        if(wordPart.symbol)
+            symbolIds.push_back(&wordPart.symbol);
+    if(word.literalSymbol)
+        symbolIds.push_back(&word.literalSymbol);
+}
+
+/** appends the symbol ids in the words of simple and coproc commands, which a dump doesn't show */
+void appendSymbolIds(const ast::Command *command, std::vector<const util::SymbolId *> &symbolIds)
+{
+    if(auto *commandList = dynamic_cast<const ast::CommandList *>(command))
+    {
+        for(auto &part : commandList->parts)
+            appendSymbolIds(part.command.get(), symbolIds);
+    }
+    else if(auto *andOrList = dynamic_cast<const ast::AndOrList *>(command))
+    {
+        for(auto &part : andOrList->parts)
+            appendSymbolIds(part.command.get(), symbolIds);
+    }
+    else if(auto *pipeline = dynamic_cast<const ast::Pipeline *>(command))
+    {
+        for(auto &part : pipeline->parts)
+            appendSymbolIds(part.command.get(), symbolIds);
+    }
+    else if(auto *coprocCommand = dynamic_cast<const ast::CoprocCommand *>(command))
+    {
+        if(coprocCommand->name)
+            appendSymbolIds(*coprocCommand->name, symbolIds);
+        appendSymbolIds(coprocCommand->command.get(), symbolIds);
+    }
+    else if(auto *simpleCommand = dynamic_cast<const ast::SimpleCommand *>(command))
+    {
+        for(auto &part : simpleCommand->parts)
+            if(auto *word = dynamic_cast<const ast::Word *>(part.wordOrRedirection.get()))
+                appendSymbolIds(*word, symbolIds);
+    }
+}
+
+/** checks that the symbol id references a parser records are exactly the ids in its commands, so
+ * none of them point at memory that a rollback freed, and that only names were interned */
+bool checkSymbolIdReferences()
+{
+    const std::string script =
+        "coproc name arg\n"
+        "v=1 w+=x command 'a b'\n"
+        "coproc other a b\n";
+    input::MemoryTextInput textInput("test", input::TextInputStyle(), script);
+    util::Arena arena;
+    util::SymbolTable symbolTable;
+    std::vector<util::SymbolId *> references;
+    parser::Parser parser(textInput, arena, symbolTable, parser::ParserDialect::getBashDialect());
+    parser.setSymbolIdReferences(&references);
+    std::vector<const util::SymbolId *> expected;
+    while(true)
+    {
+        util::ArenaPtr<ast::Command> command;
+        auto result = parser.parseTopLevelCommand(command);
+        if(result == parser::ParseCommandResult::Quit)
+            break;
+        if(result == parser::ParseCommandResult::Success)
+            appendSymbolIds(command.get(), expected);
+    }
+    std::vector<const util::SymbolId *> actual(references.begin(), references.end());
+    std::sort(expected.begin(), expected.end());
+    std::sort(actual.begin(), actual.end());
+    if(actual != expected)
+    {
+        std::cout << "symbol id references don't match the commands" << std::endl;
+        return false;
+    }
+    // only names are interned: not arguments, and not whole assignments
+    std::vector<std::string> symbolTexts;
+    for(std::uint32_t symbol = 1; symbol <= symbolTable.size(); symbol++)
+        symbolTexts.push_back(
+            static_cast<std::string>(symbolTable.getText(util::SymbolId(symbol))));
+    if(symbolTexts != std::vector<std::string>{"name", "v", "w", "command", "other"})
+    {
+        std::cout << "unexpected symbols:";
+        for(auto &symbolText : symbolTexts)
+            std::cout << " \"" << symbolText << "\"";
+        std::cout << std::endl;
+        return false;
+    }
+    return true;
+}
+
+struct ParseOutput final
+{
+    std::string dump;
+    std::vector<std::string> symbolTexts;
+    std::vector<std::uint32_t> symbols;
+};
+
+ParseOutput parse(const std::string &script,
+                  std::size_t threadCount,
+                  bool parseFunctionBodiesLazily = false)
+{
+    input::MemoryTextInput textInput("test", input::TextInputStyle(), script);
+    util::Arena arena;
+    util::SymbolTable symbolTable;
+    auto commands = parser::parseInParallel(textInput,
+                                            arena,
+                                            symbolTable,
+                                            parser::ParserDialect::getBashDialect(),
+                                            parseFunctionBodiesLazily,
+                                            threadCount);
+    ParseOutput retval;
+    std::ostringstream os;
+    std::vector<const util::SymbolId *> symbolIds;
+    for(auto &command : commands)
+    {
+        ast::ASTDumpState dumpState;
+        command->dump(os, dumpState);
+        appendSymbolIds(command.get(), symbolIds);
+    }
+    for(auto *symbolId : symbolIds)
+        retval.symbols.push_back(symbolId->value);
+    retval.dump = os.str();
+    for(std::uint32_t symbol = 1; symbol <= symbolTable.size(); symbol++)
+        retval.symbolTexts.push_back(
+            static_cast<std::string>(symbolTable.getText(util::SymbolId(symbol))));
+    return retval;
+}
+
+/** function definitions whose bodies use `$` and backquotes, parsed lazily */
+bool checkLazyExpansions()
+{
+    std::ostringstream os;
+    for(std::size_t i = 0; i < 20000; i++)
+    {
+        os << "g" << i % 17 << "() { for i in 1 2 3; do echo \"$i\" `date` $((i + " << i
+           << ")); done; }\n";
+        os << "echo plain" << i << "\n";
+    }
+    const std::string script = os.str();
+    if(parse(script, 4, true).dump != parse(script, 1, true).dump)
+    {
+        std::cout << "lazily parsed commands differ" << std::endl;
+        return false;
+    }
+    input::MemoryTextInput textInput("test", input::TextInputStyle(), script);
+    util::Arena arena;
+    util::SymbolTable symbolTable;
+    auto commands = parser::parseInParallel(
+        textInput, arena, symbolTable, parser::ParserDialect::getBashDialect(), true, 4);
+    auto *functionDefinition = dynamic_cast<ast::FunctionDefinition *>(commands.front().get());
+    if(!functionDefinition)
+    {
+        std::cout << "the first command isn't a function definition" << std::endl;
+        return false;
+    }
+    parser::Parser parser(textInput, arena, symbolTable, parser::ParserDialect::getBashDialect());
+    try
+    {
+        parser.getFunctionBody(*functionDefinition);
+    }
+    catch(parser::ParseError &e)
+    {
+        if(e.message == "parameter expansions are not supported")
+            return true;
+        std::cout << "getFunctionBody: " << e.what() << std::endl;
+        return false;
+    }
+    std::cout << "getFunctionBody didn't report the expansion" << std::endl;
+    return false;
+}
+
+/** returns the first parse error in `script`, or an empty string */
+std::string getFirstError(const std::string &script, std::size_t threadCount)
+{
+    try
+    {
+        parse(script, threadCount);
+    }
+    catch(parser::ParseError &e)
+    {
+        return e.what();
+    }
+    return std::string();
+}
+
+/** a `$` and a backquote at the top level, in a late region */
+bool checkTopLevelExpansions()
+{
+    std::string script = makeScript();
+    std::size_t index = script.find('\n', script.size() * 3 / 4) + 1;
+    script.insert(index, "for i in 1 2 3; do echo $i; done\necho `date`\n");
+    std::string expected = getFirstError(script, 1);
+    std::string actual = getFirstError(script, 4);
+    if(expected.find("parameter expansions are not supported") != std::string::npos
+       && actual == expected)
+        return true;
+    std::cout << "first error: \"" << actual << "\" instead of \"" << expected << "\""
+              << std::endl;
+    return false;
+}
+}
+
+int main()
+{
+    const std::string script = makeScript();
+    auto expected = parse(script, 1);
+    auto actual = parse(script, 4);
+    bool passed = true;
+    if(!checkSymbolIdReferences())
+        passed = false;
+    if(!checkLazyExpansions() || !checkTopLevelExpansions())
+        passed = false;
+    if(actual.dump != expected.dump)
+    {
+        std::cout << "commands differ" << std::endl;
+        passed = false;
+    }
+    if(actual.symbolTexts != expected.symbolTexts)
+    {
+        std::cout << "symbol tables differ" << std::endl;
+        passed = false;
+    }
+    if(actual.symbols != expected.symbols)
+    {
+        std::cout << "symbol ids differ" << std::endl;
+        passed = false;
+    }
+    std::cout << (passed ? "passed" : "failed") << ": " << script.size() << " bytes, "
+              << expected.symbolTexts.size() << " symbols, " << expected.symbols.size()
+              << " symbol ids checked" << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Checks that the constructs the parser doesn't support yet are reported as parse errors instead
+ * of stopping the program, and that the parser goes on to parse the next line. Also checks some
+ * nearby words that are supported. Exits with 1 at the first unexpected result.
+ *
+ * Build from the repository root:
+ *     g++ -std=c++11 -g -fsanitize=address,undefined -I. test/parser_errors.cpp parser/parser.cpp \
+ *         parser/lexer.cpp input/text_input.cpp input/memory.cpp input/location.cpp \
+ *         ast/ast_base.cpp ast/blank.cpp ast/comment.cpp ast/command.cpp \
+ *         ast/conditional_expression.cpp ast/redirection.cpp ast/word.cpp ast/word_part.cpp \
+ *         util/arena.cpp util/symbol_table.cpp -o test_parser_errors
+ */
+
+#include "../input/memory.h"
+#include "../parser/parser.h"
+#include <iostream>
+#include <string>
+
+using namespace quick_shell;
+
+namespace
+{
+/** parses `line` followed by `echo next`, and checks that `line` fails with `expectedMessage`,
+ * or succeeds if `expectedMessage` is empty, and that `echo next` is parsed after it */
+bool check(const std::string &line, const std::string &expectedMessage)
+{
+    input::MemoryTextInput textInput("test", input::TextInputStyle(), line + "\necho next\n");
+    util::Arena arena;
+    util::SymbolTable symbolTable;
+    parser::Parser parser(textInput, arena, symbolTable, parser::ParserDialect::getBashDialect());
+    std::string message;
+    try
+    {
+        util::ArenaPtr<ast::Command> command;
+        parser.parseTopLevelCommand(command);
+    }
+    catch(parser::ParseError &e)
+    {
+        message = e.message;
+    }
+    bool nextParsed = false;
+    try
+    {
+        util::ArenaPtr<ast::Command> command;
+        nextParsed =
+            parser.parseTopLevelCommand(command) == parser::ParseCommandResult::Success && command;
+    }
+    catch(parser::ParseError &)
+    {
+    }
+    if(message == expectedMessage && nextParsed)
+        return true;
+    std::cout << line << ": got \"" << message << "\" instead of \"" << expectedMessage << "\"";
+    if(!nextParsed)
+        std::cout << " and the next line wasn't parsed";
+    std::cout << std::endl;
+    return false;
+}
+}
+
+int main()
+{
+    struct Case
+    {
+        const char *line;
+        const char *expectedMessage;
+    };
+    static const Case cases[] = {
+        {"echo $x", "parameter expansions are not supported"},
+        {"echo ${x}", "parameter expansions are not supported"},
+        {"for i in 1 2 3; do echo $i; done", "parameter expansions are not supported"},
+        {"echo \"$x\"", "parameter expansions are not supported"},
+        {"echo \"a ${x} b\"", "parameter expansions are not supported"},
+        {"echo $(date)", "command substitutions are not supported"},
+        {"echo \"$(date)\"", "command substitutions are not supported"},
+        {"echo `date`", "command substitutions are not supported"},
+        {"echo \"`date`\"", "command substitutions are not supported"},
+        {"echo $((1 + 2))", "arithmetic expansions are not supported"},
+        {"echo $\"hello\"", "locale-translated strings are not supported"},
+        {"a[i]=v", "array element assignments are not supported"},
+        {"a[0]+=v echo", "array element assignments are not supported"},
+        {"a=(1 2 3)", "array assignments are not supported"},
+        {"a+=(4)", "array assignments are not supported"},
+        {"((x = 1))", "arithmetic commands are not supported"},
+        {"for ((i = 0; i < 3; i++)); do echo; done", "arithmetic for loops are not supported"},
+        {"echo a[i]=v", ""},
+        {"a[i] b", ""},
+        {"echo \"$\" $'a\\tb'", ""},
+        {"for i in 1 2 3; do echo i; done", ""},
+    };
+    bool passed = true;
+    for(auto &c : cases)
+        if(!check(c.line, c.expectedMessage))
+            passed = false;
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Checks ReadAheadTextInput: the text read through it must match its source up to EOF, an
+ * exception thrown by the source must come out of reading at the same place, and destroying it
+ * before EOF must stop the worker even though the source never ends. Also checks that
+ * makeFileTextInput only reads ahead files that aren't memory-mapped. Exits with 1 on failure.
+ *
+ * Build from the repository root:
+ *     g++ -std=c++11 -g -fsanitize=address,undefined -I. test/read_ahead.cpp \
+ *         input/read_ahead.cpp input/file.cpp input/istream.cpp input/text_input.cpp \
+ *         input/location.cpp -pthread -o test_read_ahead
+ */
+
+#include "../input/file.h"
+#include "../input/read_ahead.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#if defined(__unix)
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace quick_shell;
+
+namespace
+{
+constexpr std::size_t neverFail = static_cast<std::size_t>(-1);
+
+/** hands out `text` up to 1000 bytes at a time, then throws at `failIndex` if it's before the end
+ * of `text`. If `endless` is set, hands out `x` forever instead. */
+class SlowTextInput final : public input::TextInput
+{
+private:
+    std::string text;
+    std::size_t failIndex;
+    bool endless;
+    std::shared_ptr<std::atomic<std::size_t>> readCount;
+
+protected:
+    virtual std::size_t read(std::size_t startIndex,
+                             unsigned char *buffer,
+                             std::size_t bufferSize) override
+    {
+        ++*readCount;
+        std::size_t count = std::min<std::size_t>(bufferSize, 1000);
+        if(endless)
+        {
+            std::memset(buffer, 'x', count);
+            return count;
+        }
+        if(startIndex >= failIndex)
+            throw std::runtime_error("source failed");
+        if(startIndex >= text.size())
+            return 0;
+        count = std::min({count, text.size() - startIndex, failIndex - startIndex});
+        std::memcpy(buffer, text.data() + startIndex, count);
+        return count;
+    }
+
+public:
+    SlowTextInput(std::string text,
+                  std::size_t failIndex,
+                  bool endless,
+                  std::shared_ptr<std::atomic<std::size_t>> readCount =
+                      std::make_shared<std::atomic<std::size_t>>(0))
+        : TextInput("test", input::TextInputStyle(), false),
+          text(std::move(text)),
+          failIndex(failIndex),
+          endless(endless),
+          readCount(std::move(readCount))
+    {
+    }
+};
+
+std::string makeText()
+{
+    std::ostringstream os;
+    for(std::size_t i = 0; i < 5000; i++)
+        os << "echo line" << i << "\n";
+    return os.str();
+}
+
+/** reads `textInput` up to EOF, or up to `maxSize` bytes */
+std::string readText(input::TextInput &textInput, std::size_t maxSize = neverFail)
+{
+    std::string retval;
+    for(auto iter = textInput.begin(); retval.size() < maxSize && *iter != input::eof; ++iter)
+        retval += static_cast<char>(*iter);
+    return retval;
+}
+
+bool checkEOF()
+{
+    std::string text = makeText();
+    for(std::size_t readAheadChunkCount : {std::size_t(1),
+                                           input::ReadAheadTextInput::defaultReadAheadChunkCount})
+    {
+        input::ReadAheadTextInput textInput(
+            std::unique_ptr<input::TextInput>(new SlowTextInput(text, neverFail, false)),
+            readAheadChunkCount);
+        if(readText(textInput) != text)
+        {
+            std::cout << "the text read with " << readAheadChunkCount
+                      << " chunks doesn't match the source" << std::endl;
+            return false;
+        }
+        // reading at EOF again must not wait for the stopped worker
+        if(*textInput.iteratorAt(text.size()) != input::eof)
+        {
+            std::cout << "no EOF after the text" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool checkSourceException()
+{
+    std::string text = makeText();
+    constexpr std::size_t failIndex = 10000;
+    input::ReadAheadTextInput textInput(
+        std::unique_ptr<input::TextInput>(new SlowTextInput(text, failIndex, false)), 2);
+    std::string readText;
+    try
+    {
+        for(auto iter = textInput.begin(); *iter != input::eof; ++iter)
+            readText += static_cast<char>(*iter);
+        std::cout << "the source's exception wasn't thrown" << std::endl;
+        return false;
+    }
+    catch(std::runtime_error &e)
+    {
+        if(std::string(e.what()) != "source failed")
+        {
+            std::cout << "wrong exception: " << e.what() << std::endl;
+            return false;
+        }
+    }
+    if(readText != text.substr(0, failIndex))
+    {
+        std::cout << "the exception was thrown after " << readText.size() << " bytes instead of "
+                  << failIndex << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool checkDestructionBeforeEOF()
+{
+    auto readCount = std::make_shared<std::atomic<std::size_t>>(0);
+    {
+        input::ReadAheadTextInput textInput(
+            std::unique_ptr<input::TextInput>(new SlowTextInput("", neverFail, true, readCount)),
+            2);
+        if(readText(textInput, 100) != std::string(100, 'x'))
+        {
+            std::cout << "the endless source wasn't read" << std::endl;
+            return false;
+        }
+        // give the worker time to fill the ring and wait for room
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    // the worker stops at a full ring instead of reading the endless source without limit
+    std::size_t finalReadCount = readCount->load();
+    if(finalReadCount > 20)
+    {
+        std::cout << "the worker read the source " << finalReadCount << " times" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+#if defined(__unix)
+bool checkMakeFileTextInput()
+{
+    std::string text = makeText();
+    std::string directory = "/tmp/test_read_ahead_" + std::to_string(getpid());
+    std::string fileName = directory + "/file";
+    std::string fifoName = directory + "/fifo";
+    if(mkdir(directory.c_str(), 0700) != 0 || mkfifo(fifoName.c_str(), 0600) != 0)
+    {
+        std::cout << "can't make " << directory << std::endl;
+        return false;
+    }
+    std::ofstream(fileName, std::ios::binary) << text;
+    bool passed = true;
+    {
+        // regular files are memory-mapped, so there's nothing to read ahead
+        auto textInput = input::makeFileTextInput(fileName, input::TextInputStyle(), false, true);
+        if(dynamic_cast<input::ReadAheadTextInput *>(textInput.get())
+           || readText(*textInput) != text)
+        {
+            std::cout << "the regular file wasn't read in place" << std::endl;
+            passed = false;
+        }
+    }
+    {
+        std::thread writer([&]()
+                           {
+                               std::ofstream(fifoName, std::ios::binary) << text;
+                           });
+        auto textInput = input::makeFileTextInput(fifoName, input::TextInputStyle(), false, true);
+        if(!dynamic_cast<input::ReadAheadTextInput *>(textInput.get())
+           || readText(*textInput) != text)
+        {
+            std::cout << "the FIFO wasn't read ahead" << std::endl;
+            passed = false;
+        }
+        writer.join();
+    }
+    std::remove(fileName.c_str());
+    std::remove(fifoName.c_str());
+    rmdir(directory.c_str());
+    return passed;
+}
+#else
+bool checkMakeFileTextInput()
+{
+    return true;
+}
+#endif
+}
+
+int main()
+{
+    bool passed = checkEOF() && checkSourceException() && checkDestructionBeforeEOF()
+                  && checkMakeFileTextInput();
+    std::cout << (passed ? "passed" : "failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "arena.h"
+#include <ostream>
+
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
+#endif
+
+namespace quick_shell
+{
+namespace util
+{
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+std::string demangleTypeName(const char *name)
+{
+#if defined(__GNUC__)
+    int status = 0;
+    char *demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if(demangled)
+    {
+        std::string retval = demangled;
+        std::free(demangled);
+        return retval;
+    }
+#endif
+    return name;
+}
+#endif
+
+void Arena::dumpStats(std::ostream &os) const
+{
+    std::size_t slabCount = 0;
+    for(auto *slab = slabs; slab; slab = slab->next)
+        slabCount++;
+    os << "Arena: " << slabCount << " slabs" << std::endl;
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+    if(!statistics)
+        return;
+    os << "slab bytes: " << statistics->slabBytes << " (peak " << statistics->peakSlabBytes << ")"
+       << std::endl;
+    std::vector<const ArenaStatistics::TypeStatistics *> types;
+    types.reserve(statistics->types.size());
+    for(auto &entry : statistics->types)
+        types.push_back(&entry.second);
+    std::sort(types.begin(),
+              types.end(),
+              [](const ArenaStatistics::TypeStatistics *a, const ArenaStatistics::TypeStatistics *b)
+              {
+                  if(a->bytes != b->bytes)
+                      return a->bytes > b->bytes;
+                  return std::strcmp(a->name, b->name) < 0;
+              });
+    for(auto *typeStatistics : types)
+        os << "    " << typeStatistics->name << ": " << typeStatistics->count << " objects, "
+           << typeStatistics->bytes << " bytes" << std::endl;
+#endif
+}
+}
+}
+
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+#include <mutex>
+#include <map>
+#include <new>
+
+namespace
+{
+/** reserves `size` bytes of address space; returns nullptr on failure */
+void *reserveAddressSpace(std::size_t size) noexcept;
+/** makes reserved memory usable; returns false on failure */
+bool commitMemory(void *memory, std::size_t size) noexcept;
+/** returns memory to the OS, leaving the address space reserved */
+void decommitMemory(void *memory, std::size_t size) noexcept;
+
+struct SlabSpaceState final
+{
+    std::mutex lock;
+    /** unit 0 is never allocated, so offset 0 can be the null pointer */
+    std::size_t usedUnitCount = 1;
+    /** ranges that were freed, as unit count to first unit */
+    std::multimap<std::size_t, std::size_t> freeRanges;
+};
+
+SlabSpaceState &getSlabSpaceState()
+{
+    // never destroyed, so arenas can be freed during static destruction
+    static SlabSpaceState *state = new SlabSpaceState;
+    return *state;
+}
+}
+
+namespace quick_shell
+{
+namespace util
+{
+constexpr std::size_t CompactSlabSpace::granularity;
+constexpr std::size_t CompactSlabSpace::unitSize;
+constexpr std::size_t CompactSlabSpace::size;
+
+unsigned char *CompactSlabSpace::base = nullptr;
+
+void *CompactSlabSpace::allocate(std::size_t allocationSize)
+{
+    std::size_t unitCount = (allocationSize + unitSize - 1) / unitSize;
+    auto &state = getSlabSpaceState();
+    std::unique_lock<std::mutex> lockIt(state.lock);
+    if(!base)
+    {
+        base = static_cast<unsigned char *>(reserveAddressSpace(size));
+        if(!base)
+            throw std::bad_alloc();
+    }
+    std::size_t firstUnit;
+    auto iter = state.freeRanges.lower_bound(unitCount);
+    if(iter != state.freeRanges.end())
+    {
+        firstUnit = iter->second;
+        std::size_t leftoverUnitCount = iter->first - unitCount;
+        state.freeRanges.erase(iter);
+        if(leftoverUnitCount)
+            state.freeRanges.emplace(leftoverUnitCount, firstUnit + unitCount);
+    }
+    else
+    {
+        if(unitCount > size / unitSize - state.usedUnitCount)
+            throw std::bad_alloc();
+        firstUnit = state.usedUnitCount;
+        state.usedUnitCount += unitCount;
+    }
+    void *retval = base + firstUnit * unitSize;
+    if(!commitMemory(retval, unitCount * unitSize))
+    {
+        state.freeRanges.emplace(unitCount, firstUnit);
+        throw std::bad_alloc();
+    }
+    return retval;
+}
+
+void CompactSlabSpace::free(void *memory, std::size_t allocationSize) noexcept
+{
+    std::size_t unitCount = (allocationSize + unitSize - 1) / unitSize;
+    std::size_t firstUnit = (static_cast<unsigned char *>(memory) - base) / unitSize;
+    // single units are the common case and are reused right away, so keep them committed
+    if(unitCount > 1)
+        decommitMemory(memory, unitCount * unitSize);
+    auto &state = getSlabSpaceState();
+    std::unique_lock<std::mutex> lockIt(state.lock);
+    state.freeRanges.emplace(unitCount, firstUnit);
+}
+}
+}
+
+#if defined(__unix)
+#include <sys/mman.h>
+namespace
+{
+void *reserveAddressSpace(std::size_t size) noexcept
+{
+    void *retval = ::mmap(nullptr,
+                          size,
+                          PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                          -1,
+                          0);
+    if(retval == MAP_FAILED)
+        return nullptr;
+    return retval;
+}
+
+bool commitMemory(void *memory, std::size_t size) noexcept
+{
+    // pages are backed on first touch
+    return true;
+}
+
+void decommitMemory(void *memory, std::size_t size) noexcept
+{
+    ::madvise(memory, size, MADV_DONTNEED);
+}
+}
+#elif defined(_WIN32)
+#include <windows.h>
+namespace
+{
+void *reserveAddressSpace(std::size_t size) noexcept
+{
+    return ::VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+bool commitMemory(void *memory, std::size_t size) noexcept
+{
+    return ::VirtualAlloc(memory, size, MEM_COMMIT, PAGE_READWRITE) != nullptr;
+}
+
+void decommitMemory(void *memory, std::size_t size) noexcept
+{
+    ::VirtualFree(memory, size, MEM_DECOMMIT);
+}
+}
+#else
+#error unimplemented platform
+#endif
+#endif
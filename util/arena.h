@@ -16,27 +16,138 @@
 #ifndef UTIL_ARENA_H_
 #define UTIL_ARENA_H_
 
-#include <vector>
 #include <memory>
 #include <utility>
 #include <type_traits>
 #include <functional>
+#include <atomic>
+#include <iosfwd>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+#include <string>
+#include <typeinfo>
+#include <typeindex>
+#include <unordered_map>
+#endif
 
 namespace quick_shell
 {
 namespace util
 {
 class Arena;
+class SharedArena;
 
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+/** the address range that all arena slabs are allocated from when
+ * `QUICK_SHELL_COMPACT_ARENA_PTR` is defined, so an `ArenaPtr` can be a 32-bit offset from its
+ * start.
+ *
+ * The range is only reserved, the first time a slab is allocated; memory is committed as slabs
+ * are allocated from it.
+ * */
+class CompactSlabSpace final
+{
+    static_assert(sizeof(void *) >= 8, "compact ArenaPtr is only useful for 64-bit pointers");
+
+public:
+    /** every object an `ArenaPtr` points to must be aligned to this */
+    static constexpr std::size_t granularity = 8;
+    /** slabs are allocated in multiples of this, aligned to it */
+    static constexpr std::size_t unitSize = 0x10000;
+    static constexpr std::size_t size = granularity << 32;
+
+private:
+    static unsigned char *base;
+
+public:
+    /** returns memory aligned to `unitSize` */
+    static void *allocate(std::size_t allocationSize);
+    /** `allocationSize` must be what was passed to `allocate` */
+    static void free(void *memory, std::size_t allocationSize) noexcept;
+    static std::uint32_t pointerToOffset(const volatile void *pointer) noexcept
+    {
+        if(!pointer)
+            return 0;
+        auto *bytePointer = static_cast<const volatile unsigned char *>(pointer);
+        assert(bytePointer > base && bytePointer < base + size);
+        auto difference = static_cast<std::size_t>(bytePointer - base);
+        assert(difference % granularity == 0);
+        return static_cast<std::uint32_t>(difference / granularity);
+    }
+    static void *offsetToPointer(std::uint32_t offset) noexcept
+    {
+        if(!offset)
+            return nullptr;
+        return base + static_cast<std::size_t>(offset) * granularity;
+    }
+    /** returns the start of the unit containing `pointer` */
+    static void *getUnitStart(const volatile void *pointer) noexcept
+    {
+        auto *bytePointer = static_cast<const volatile unsigned char *>(pointer);
+        assert(bytePointer > base && bytePointer < base + size);
+        auto difference = static_cast<std::size_t>(bytePointer - base);
+        return base + (difference & ~(unitSize - 1));
+    }
+};
+#endif
+
+/** pointer to an object allocated by `Arena`.
+ *
+ * If `QUICK_SHELL_COMPACT_ARENA_PTR` is defined, this is a 32-bit offset into
+ * `CompactSlabSpace` instead of a full pointer.
+ * */
 template <typename T>
 class ArenaPtr final
 {
     friend class Arena;
 
 private:
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+    std::uint32_t offset;
+#else
     T *ptr;
+#endif
+
+public:
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+    constexpr ArenaPtr() noexcept : offset(0)
+    {
+    }
+    constexpr ArenaPtr(std::nullptr_t) noexcept : offset(0)
+    {
+    }
+
+private:
+    explicit ArenaPtr(T *ptr) noexcept : offset(CompactSlabSpace::pointerToOffset(ptr))
+    {
+    }
 
 public:
+    template <typename T2,
+              typename = typename std::enable_if<std::is_convertible<T2 *, T *>::value>::type>
+    ArenaPtr(ArenaPtr<T2> v) noexcept : ArenaPtr(static_cast<T *>(v.get()))
+    {
+    }
+    void reset() noexcept
+    {
+        offset = 0;
+    }
+    void swap(ArenaPtr<T> &rt) noexcept
+    {
+        std::swap(offset, rt.offset);
+    }
+    T *get() const noexcept
+    {
+        return static_cast<T *>(CompactSlabSpace::offsetToPointer(offset));
+    }
+    constexpr explicit operator bool() const noexcept
+    {
+        return offset != 0;
+    }
+#else
     constexpr ArenaPtr() noexcept : ptr(nullptr)
     {
     }
@@ -71,17 +182,18 @@ public:
     {
         return ptr != nullptr;
     }
+#endif
     constexpr typename std::add_lvalue_reference<T>::type operator*() const noexcept
     {
-        return *ptr;
+        return *get();
     }
     constexpr T *operator->() const noexcept
     {
-        return ptr;
+        return get();
     }
     constexpr explicit operator T *() const noexcept
     {
-        return ptr;
+        return get();
     }
     template <typename To, typename From>
     friend constexpr ArenaPtr<To> static_pointer_cast(ArenaPtr<From> v) noexcept;
@@ -175,83 +287,591 @@ constexpr ArenaPtr<To> const_pointer_cast(ArenaPtr<From> v) noexcept
 	return ArenaPtr<To>(const_cast<To *>(v.get()));
 }
 
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+/** returns a readable name for a type name from `std::type_info::name` */
+std::string demangleTypeName(const char *name);
+
+/** the name `Arena` statistics use for `T`; specialize to override it */
+template <typename T>
+struct ArenaTypeName final
+{
+    static const char *get()
+    {
+        static const std::string name = demangleTypeName(typeid(T).name());
+        return name.c_str();
+    }
+};
+
+/** what an `Arena` has allocated; only kept if `QUICK_SHELL_ARENA_STATISTICS` is defined */
+struct ArenaStatistics final
+{
+    struct TypeStatistics final
+    {
+        const char *name = nullptr;
+        std::size_t count = 0;
+        std::size_t bytes = 0;
+    };
+    /** objects created by `Arena::allocate`; not reduced by rolling back */
+    std::unordered_map<std::type_index, TypeStatistics> types;
+    std::size_t slabCount = 0;
+    std::size_t slabBytes = 0;
+    std::size_t peakSlabBytes = 0;
+    void addSlab(std::size_t size) noexcept
+    {
+        slabCount++;
+        slabBytes += size;
+        if(slabBytes > peakSlabBytes)
+            peakSlabBytes = slabBytes;
+    }
+    void removeSlab(std::size_t size) noexcept
+    {
+        slabCount--;
+        slabBytes -= size;
+    }
+    void removeAllSlabs() noexcept
+    {
+        slabCount = 0;
+        slabBytes = 0;
+    }
+    /** `other`'s slabs are added to ours, so the peak is at least the combined size */
+    void merge(ArenaStatistics &&other)
+    {
+        for(auto &entry : other.types)
+        {
+            auto &typeStatistics = types[entry.first];
+            typeStatistics.name = entry.second.name;
+            typeStatistics.count += entry.second.count;
+            typeStatistics.bytes += entry.second.bytes;
+        }
+        slabCount += other.slabCount;
+        slabBytes += other.slabBytes;
+        if(other.peakSlabBytes > peakSlabBytes)
+            peakSlabBytes = other.peakSlabBytes;
+        if(slabBytes > peakSlabBytes)
+            peakSlabBytes = slabBytes;
+    }
+};
+#endif
+
+/** bump-pointer allocator for objects that all live until the arena is destroyed.
+ *
+ * Objects are placed in large slabs; only objects that aren't trivially destructible get a
+ * destructor record, so freeing everything else is just freeing the slabs.
+ * */
 class Arena final
 {
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    friend class SharedArena;
+
 private:
-    struct Allocation final
+    struct Slab final
     {
-        void *memory;
-        void (*destroyFn)(void *memory);
-        Allocation() noexcept : memory(), destroyFn()
+        Slab *next;
+#if defined(QUICK_SHELL_COMPACT_ARENA_PTR) || defined(QUICK_SHELL_ARENA_STATISTICS)
+        std::size_t size;
+#endif
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+        /** the arena's context when this slab was allocated */
+        const void *context;
+#endif
+    };
+    struct DestructorRecord final
+    {
+        DestructorRecord *next;
+        void (*destroyFn)(void *object);
+        void *object;
+    };
+
+private:
+    static constexpr std::size_t slabAlignment = alignof(std::max_align_t);
+    static constexpr std::size_t slabHeaderSize =
+        (sizeof(Slab) + slabAlignment - 1) & ~(slabAlignment - 1);
+    static constexpr std::size_t slabSize = 0x10000;
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+    static_assert(slabSize == CompactSlabSpace::unitSize,
+                  "getContext relies on slabs being single units");
+#endif
+    /** allocations bigger than this get their own slab */
+    static constexpr std::size_t largeAllocationSize = (slabSize - slabHeaderSize) / 4;
+
+public:
+    /** the state of an `Arena` at some point; see `checkpoint` and `rollbackTo` */
+    class Checkpoint final
+    {
+        friend class Arena;
+
+    private:
+        Slab *slabs;
+        unsigned char *current;
+        unsigned char *end;
+        DestructorRecord *destructors;
+        constexpr Checkpoint(Slab *slabs,
+                             unsigned char *current,
+                             unsigned char *end,
+                             DestructorRecord *destructors) noexcept : slabs(slabs),
+                                                                       current(current),
+                                                                       end(end),
+                                                                       destructors(destructors)
         {
         }
-        explicit Allocation(void *memory, void (*destroyFn)(void *memory)) noexcept
-            : memory(memory), destroyFn(destroyFn)
+    };
+
+private:
+    /** most recently added slab first */
+    Slab *slabs;
+    Slab *lastSlab;
+    /** free space in the slab being allocated from, which isn't always the first slab */
+    unsigned char *current;
+    unsigned char *end;
+    /** most recently constructed object first, so objects are destroyed in reverse order */
+    DestructorRecord *destructors;
+    DestructorRecord *lastDestructor;
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+    const void *context = nullptr;
+#endif
+
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+    std::unique_ptr<ArenaStatistics> statistics;
+#endif
+
+private:
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+    ArenaStatistics &getStatisticsForUpdate()
+    {
+        if(!statistics)
+            statistics.reset(new ArenaStatistics);
+        return *statistics;
+    }
+    template <typename T>
+    void recordAllocation()
+    {
+        auto &typeStatistics = getStatisticsForUpdate().types[std::type_index(typeid(T))];
+        typeStatistics.name = ArenaTypeName<T>::get();
+        typeStatistics.count++;
+        typeStatistics.bytes += sizeof(T);
+    }
+#endif
+    Slab *allocateSlab(std::size_t size)
+    {
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+        // before allocating, so the slab can't leak if this throws
+        auto &statistics = getStatisticsForUpdate();
+#endif
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+        auto *retval = static_cast<Slab *>(CompactSlabSpace::allocate(size));
+        retval->context = context;
+#else
+        auto *retval = static_cast<Slab *>(::operator new(size));
+#endif
+        retval->next = nullptr;
+#if defined(QUICK_SHELL_COMPACT_ARENA_PTR) || defined(QUICK_SHELL_ARENA_STATISTICS)
+        retval->size = size;
+#endif
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+        statistics.addSlab(size);
+#endif
+        return retval;
+    }
+    void freeSlab(Slab *slab) noexcept
+    {
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+        if(statistics)
+            statistics->removeSlab(slab->size);
+#endif
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+        CompactSlabSpace::free(static_cast<void *>(slab), slab->size);
+#else
+        ::operator delete(static_cast<void *>(slab));
+#endif
+    }
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+    /** stops allocating from the current slab if it was allocated with a different context */
+    void checkCurrentSlabContext() noexcept
+    {
+        if(current && getContext(current - 1) != context)
         {
+            current = nullptr;
+            end = nullptr;
         }
-        Allocation(Allocation &&rt) noexcept : memory(rt.memory), destroyFn(rt.destroyFn)
+    }
+#endif
+    static unsigned char *getSlabMemory(Slab *slab) noexcept
+    {
+        return reinterpret_cast<unsigned char *>(slab) + slabHeaderSize;
+    }
+    static unsigned char *alignUp(unsigned char *pointer, std::size_t alignment) noexcept
+    {
+        auto address = reinterpret_cast<std::uintptr_t>(pointer);
+        return pointer + (-address & (alignment - 1));
+    }
+    void *allocateBytesSlow(std::size_t size, std::size_t alignment)
+    {
+        if(size + alignment > largeAllocationSize)
         {
-            rt.memory = nullptr;
-            rt.destroyFn = nullptr;
+            // doesn't change the slab being allocated from
+            Slab *slab = allocateSlab(slabHeaderSize + size + alignment);
+            slab->next = slabs;
+            slabs = slab;
+            if(!lastSlab)
+                lastSlab = slab;
+            return alignUp(getSlabMemory(slab), alignment);
         }
-        ~Allocation() noexcept
+        Slab *slab = allocateSlab(slabSize);
+        slab->next = slabs;
+        slabs = slab;
+        if(!lastSlab)
+            lastSlab = slab;
+        current = getSlabMemory(slab);
+        end = reinterpret_cast<unsigned char *>(slab) + slabSize;
+        auto *retval = alignUp(current, alignment);
+        current = retval + size;
+        return retval;
+    }
+    template <typename T>
+    static constexpr std::size_t getObjectAlignment() noexcept
+    {
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+        return alignof(T) > CompactSlabSpace::granularity ? alignof(T) :
+                                                            CompactSlabSpace::granularity;
+#else
+        return alignof(T);
+#endif
+    }
+    void destroyAll() noexcept
+    {
+        rollbackTo(Checkpoint(nullptr, nullptr, nullptr, nullptr));
+    }
+
+public:
+    constexpr Arena() noexcept : slabs(nullptr),
+                                 lastSlab(nullptr),
+                                 current(nullptr),
+                                 end(nullptr),
+                                 destructors(nullptr),
+                                 lastDestructor(nullptr)
+    {
+    }
+    Arena(Arena &&rt) noexcept : slabs(rt.slabs),
+                                 lastSlab(rt.lastSlab),
+                                 current(rt.current),
+                                 end(rt.end),
+                                 destructors(rt.destructors),
+                                 lastDestructor(rt.lastDestructor)
+    {
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+        context = rt.context;
+#endif
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+        statistics = std::move(rt.statistics);
+#endif
+        rt.slabs = nullptr;
+        rt.lastSlab = nullptr;
+        rt.current = nullptr;
+        rt.end = nullptr;
+        rt.destructors = nullptr;
+        rt.lastDestructor = nullptr;
+    }
+    Arena &operator=(Arena &&rt) noexcept
+    {
+        if(this != &rt)
         {
-            if(destroyFn)
-                destroyFn(memory);
+            destroyAll();
+            swap(rt);
         }
-        void clear() noexcept
+        return *this;
+    }
+    ~Arena()
+    {
+        destroyAll();
+    }
+    void swap(Arena &other) noexcept
+    {
+        std::swap(slabs, other.slabs);
+        std::swap(lastSlab, other.lastSlab);
+        std::swap(current, other.current);
+        std::swap(end, other.end);
+        std::swap(destructors, other.destructors);
+        std::swap(lastDestructor, other.lastDestructor);
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+        std::swap(context, other.context);
+#endif
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+        statistics.swap(other.statistics);
+#endif
+    }
+    /** takes ownership of everything allocated in `other`.
+     *
+     * The merged allocations count as allocated now, so rolling back to an earlier checkpoint
+     * releases them. Pointers into `other`'s memory stay valid, but pointers to `other` itself
+     * don't follow the memory here.
+     * */
+    void merge(Arena &&other) noexcept
+    {
+        if(other.slabs)
         {
-            Allocation().swap(*this);
+            // keep allocating from our current slab, if any
+            other.lastSlab->next = slabs;
+            slabs = other.slabs;
+            if(!lastSlab)
+                lastSlab = other.lastSlab;
+            if(!current)
+            {
+                current = other.current;
+                end = other.end;
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+                checkCurrentSlabContext();
+#endif
+            }
         }
-        void swap(Allocation &other) noexcept
+        if(other.destructors)
         {
-            std::swap(memory, other.memory);
-            std::swap(destroyFn, other.destroyFn);
+            other.lastDestructor->next = destructors;
+            destructors = other.destructors;
+            if(!lastDestructor)
+                lastDestructor = other.lastDestructor;
         }
-        Allocation &operator=(Allocation rt) noexcept
+        other.slabs = nullptr;
+        other.lastSlab = nullptr;
+        other.current = nullptr;
+        other.end = nullptr;
+        other.destructors = nullptr;
+        other.lastDestructor = nullptr;
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+        if(other.statistics)
         {
-            swap(rt);
-            return *this;
+            if(statistics)
+                statistics->merge(std::move(*other.statistics));
+            else
+                statistics = std::move(other.statistics);
+            other.statistics.reset();
         }
-    };
+#endif
+    }
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+    const void *getContext() const noexcept
+    {
+        return context;
+    }
+    /** sets the context that is recorded for objects allocated after this; a slab only holds
+     * objects with the same context, so the context can be found from an object's address */
+    void setContext(const void *newContext) noexcept
+    {
+        if(context == newContext)
+            return;
+        context = newContext;
+        current = nullptr;
+        end = nullptr;
+    }
+    /** returns the context that was set when `object` was allocated, in whatever arena owns it
+     * now; `object` must point into an allocation that's smaller than a slab */
+    static const void *getContext(const volatile void *object) noexcept
+    {
+        return static_cast<const Slab *>(CompactSlabSpace::getUnitStart(object))->context;
+    }
+#endif
+    /** writes a report of what this arena holds; per-type statistics are only kept if
+     * `QUICK_SHELL_ARENA_STATISTICS` is defined */
+    void dumpStats(std::ostream &os) const;
+    Checkpoint checkpoint() const noexcept
+    {
+        return Checkpoint(slabs, current, end, destructors);
+    }
+    /** destroys and frees everything allocated since `checkpointValue` was taken.
+     *
+     * Checkpoints must be rolled back to in last-taken first order; a checkpoint is invalidated by
+     * rolling back to an earlier one or by moving this arena's contents into another arena.
+     * */
+    void rollbackTo(const Checkpoint &checkpointValue) noexcept
+    {
+        while(destructors != checkpointValue.destructors)
+        {
+            assert(destructors);
+            // the record itself lives in a slab, which is still allocated
+            auto *destructor = destructors;
+            destructors = destructor->next;
+            destructor->destroyFn(destructor->object);
+        }
+        if(!destructors)
+            lastDestructor = nullptr;
+        while(slabs != checkpointValue.slabs)
+        {
+            assert(slabs);
+            auto *slab = slabs;
+            slabs = slab->next;
+            freeSlab(slab);
+        }
+        if(!slabs)
+            lastSlab = nullptr;
+        current = checkpointValue.current;
+        end = checkpointValue.end;
+#ifdef QUICK_SHELL_COMPACT_ARENA_PTR
+        checkCurrentSlabContext();
+#endif
+    }
+    /** returns uninitialized memory that is freed when the arena is destroyed; `alignment` must
+     * be a power of 2 */
+    void *allocateBytes(std::size_t size, std::size_t alignment = alignof(std::max_align_t))
+    {
+        assert(alignment != 0 && (alignment & (alignment - 1)) == 0);
+        if(current)
+        {
+            auto *retval = alignUp(current, alignment);
+            if(retval <= end && size <= static_cast<std::size_t>(end - retval))
+            {
+                current = retval + size;
+                return retval;
+            }
+        }
+        return allocateBytesSlow(size, alignment);
+    }
+    template <typename T, typename... Args>
+    typename std::enable_if<std::is_trivially_destructible<T>::value, ArenaPtr<T>>::type allocate(
+        Args &&... args)
+    {
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+        recordAllocation<T>();
+#endif
+        void *memory = allocateBytes(sizeof(T), getObjectAlignment<T>());
+        return ArenaPtr<T>(::new(memory) T(std::forward<Args>(args)...));
+    }
+    template <typename T, typename... Args>
+    typename std::enable_if<!std::is_trivially_destructible<T>::value, ArenaPtr<T>>::type allocate(
+        Args &&... args)
+    {
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+        recordAllocation<T>();
+#endif
+        // allocate the record first so nothing can throw after T is constructed
+        auto *destructor = static_cast<DestructorRecord *>(
+            allocateBytes(sizeof(DestructorRecord), alignof(DestructorRecord)));
+        void *memory = allocateBytes(sizeof(T), getObjectAlignment<T>());
+        auto *retval = ::new(memory) T(std::forward<Args>(args)...);
+        destructor->next = destructors;
+        destructor->destroyFn = [](void *object)
+        {
+            static_cast<T *>(object)->~T();
+        };
+        destructor->object = const_cast<void *>(static_cast<const volatile void *>(retval));
+        destructors = destructor;
+        if(!lastDestructor)
+            lastDestructor = destructor;
+        return ArenaPtr<T>(retval);
+    }
+};
 
-private:
-    std::vector<Allocation> allocations;
+inline void swap(Arena &a, Arena &b) noexcept
+{
+    a.swap(b);
+}
+
+/** the calling thread's own arena, so worker threads can allocate without contention; anything
+ * still in it is freed when the thread exits */
+inline Arena &getThreadLocalArena() noexcept
+{
+    static thread_local Arena arena;
+    return arena;
+}
+
+/** an arena that many threads can merge their `Arena`s into at the same time, without locking.
+ *
+ * Worker threads allocate from their own arena (see `getThreadLocalArena`), then move the result
+ * into the shared arena with `merge`.
+ * */
+class SharedArena final
+{
+    SharedArena(const SharedArena &) = delete;
+    SharedArena &operator=(const SharedArena &) = delete;
 
 private:
-    void mergeHelper(Arena &other) noexcept
+    /** the contents of one merged arena; allocated in that arena, so it's freed with it */
+    struct MergedArena final
     {
-        for(auto &allocation : other.allocations)
-            allocations.push_back(std::move(allocation));
-        other.allocations.clear();
-    }
+        MergedArena *next;
+        Arena::Slab *slabs;
+        Arena::Slab *lastSlab;
+        unsigned char *current;
+        unsigned char *end;
+        Arena::DestructorRecord *destructors;
+        Arena::DestructorRecord *lastDestructor;
+    };
+
+private:
+    /** most recently merged first */
+    std::atomic<MergedArena *> mergedArenas;
 
 public:
-    void merge(Arena &&other)
+    SharedArena() noexcept : mergedArenas(nullptr)
     {
-        allocations.reserve(allocations.size() + other.allocations.size());
-        mergeHelper(other);
     }
-    template <typename T, typename... Args>
-    ArenaPtr<T> allocate(Args &&... args)
+    ~SharedArena()
+    {
+        release();
+    }
+    /** takes ownership of everything allocated in `arena`; O(1) and lock-free, and safe to call
+     * from multiple threads at once.
+     *
+     * Leaves `arena` empty; if this throws, `arena` is unchanged other than possibly having an
+     * extra slab.
+     * */
+    void merge(Arena &&arena)
+    {
+        // destructor records are always in slabs, so there's nothing to merge without slabs
+        if(!arena.slabs)
+            return;
+        auto *merged = static_cast<MergedArena *>(
+            arena.allocateBytes(sizeof(MergedArena), alignof(MergedArena)));
+        merged->slabs = arena.slabs;
+        merged->lastSlab = arena.lastSlab;
+        merged->current = arena.current;
+        merged->end = arena.end;
+        merged->destructors = arena.destructors;
+        merged->lastDestructor = arena.lastDestructor;
+        arena.slabs = nullptr;
+        arena.lastSlab = nullptr;
+        arena.current = nullptr;
+        arena.end = nullptr;
+        arena.destructors = nullptr;
+        arena.lastDestructor = nullptr;
+#ifdef QUICK_SHELL_ARENA_STATISTICS
+        // statistics aren't shared, but the slabs are gone
+        if(arena.statistics)
+            arena.statistics->removeAllSlabs();
+#endif
+        merged->next = mergedArenas.load(std::memory_order_relaxed);
+        while(!mergedArenas.compare_exchange_weak(
+            merged->next, merged, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+    /** moves everything merged so far into a single `Arena`, which destroys objects from later
+     * merges first; safe to call while other threads are merging. O(number of merged arenas). */
+    Arena release() noexcept
     {
-        allocations.emplace_back();
-        try
+        MergedArena *oldestFirst = nullptr;
+        for(auto *merged = mergedArenas.exchange(nullptr, std::memory_order_acquire); merged;)
         {
-            auto *retval = new T(std::forward<Args>(args)...);
-            allocations.back() =
-                Allocation(const_cast<void *>(static_cast<const volatile void *>(retval)),
-                           [](void *memory) noexcept {
-                               auto *object = static_cast<T *>(memory);
-                               delete object;
-                           });
-            return ArenaPtr<T>(retval);
+            auto *next = merged->next;
+            merged->next = oldestFirst;
+            oldestFirst = merged;
+            merged = next;
         }
-        catch(...)
+        Arena retval;
+        while(oldestFirst)
         {
-            allocations.pop_back();
-            throw;
+            // read everything before merging, since merged lives in part's memory
+            auto *merged = oldestFirst;
+            oldestFirst = merged->next;
+            Arena part;
+            part.slabs = merged->slabs;
+            part.lastSlab = merged->lastSlab;
+            part.current = merged->current;
+            part.end = merged->end;
+            part.destructors = merged->destructors;
+            part.lastDestructor = merged->lastDestructor;
+            retval.merge(std::move(part));
         }
+        return retval;
     }
 };
 }
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef UTIL_ARENA_VECTOR_H_
+#define UTIL_ARENA_VECTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+#include <new>
+#include <utility>
+#include <type_traits>
+#include <initializer_list>
+#include <limits>
+#include "arena.h"
+
+namespace quick_shell
+{
+namespace util
+{
+/** vector with storage for `inlineCapacity` elements inside itself, that grows into `Arena`
+ * memory.
+ *
+ * Is trivially destructible, so it can be used in arena-allocated objects without a destructor
+ * record. Elements must be trivially copyable and trivially destructible.
+ *
+ * The vector doesn't keep a pointer to its arena, so the operations that can allocate take the
+ * arena as an argument, and the only copy constructor takes one. That keeps the vector small,
+ * and keeps it usable after `Arena::merge` moves its memory into a different arena.
+ * */
+template <typename T, std::size_t inlineCapacity = 3>
+class ArenaVector final
+{
+    static_assert(std::is_trivially_destructible<T>::value, "T must be trivially destructible");
+    static_assert(inlineCapacity > 0, "inlineCapacity must be nonzero");
+
+public:
+    typedef T value_type;
+    typedef std::size_t size_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef T &reference;
+    typedef const T &const_reference;
+    typedef T *pointer;
+    typedef const T *const_pointer;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+
+private:
+    std::uint32_t elementCount;
+    std::uint32_t allocatedCapacity;
+    T *externalElements;
+    typename std::aligned_storage<sizeof(T) * inlineCapacity, alignof(T)>::type inlineElements;
+
+private:
+    bool isInline() const noexcept
+    {
+        return allocatedCapacity <= inlineCapacity;
+    }
+    void moveFrom(ArenaVector &rt) noexcept
+    {
+        elementCount = rt.elementCount;
+        allocatedCapacity = rt.allocatedCapacity;
+        externalElements = rt.externalElements;
+        if(rt.isInline())
+            copyElements(data(), rt.data(), elementCount);
+        rt.elementCount = 0;
+        rt.allocatedCapacity = inlineCapacity;
+        rt.externalElements = nullptr;
+    }
+    static void copyElements(T *destination, const T *source, std::size_t count) noexcept
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "T must be trivially copyable");
+        if(count)
+            std::memcpy(static_cast<void *>(destination),
+                        static_cast<const void *>(source),
+                        sizeof(T) * count);
+    }
+
+public:
+    ArenaVector() noexcept : elementCount(0),
+                             allocatedCapacity(inlineCapacity),
+                             externalElements(nullptr),
+                             inlineElements()
+    {
+    }
+    ArenaVector(Arena &arena, std::initializer_list<T> elements) : ArenaVector()
+    {
+        reserve(arena, elements.size());
+        copyElements(data(), elements.begin(), elements.size());
+        elementCount = static_cast<std::uint32_t>(elements.size());
+    }
+    /** copies `rt` using memory from `arena` */
+    ArenaVector(const ArenaVector &rt, Arena &arena) : ArenaVector()
+    {
+        reserve(arena, rt.size());
+        copyElements(data(), rt.data(), rt.size());
+        elementCount = rt.elementCount;
+    }
+    ArenaVector(const ArenaVector &) = delete;
+    ArenaVector &operator=(const ArenaVector &) = delete;
+    ArenaVector(ArenaVector &&rt) noexcept
+    {
+        moveFrom(rt);
+    }
+    ArenaVector &operator=(ArenaVector &&rt) noexcept
+    {
+        if(this != &rt)
+            moveFrom(rt);
+        return *this;
+    }
+    T *data() noexcept
+    {
+        return isInline() ? reinterpret_cast<T *>(&inlineElements) : externalElements;
+    }
+    const T *data() const noexcept
+    {
+        return isInline() ? reinterpret_cast<const T *>(&inlineElements) : externalElements;
+    }
+    std::size_t size() const noexcept
+    {
+        return elementCount;
+    }
+    std::size_t capacity() const noexcept
+    {
+        return allocatedCapacity;
+    }
+    bool empty() const noexcept
+    {
+        return elementCount == 0;
+    }
+    iterator begin() noexcept
+    {
+        return data();
+    }
+    const_iterator begin() const noexcept
+    {
+        return data();
+    }
+    const_iterator cbegin() const noexcept
+    {
+        return data();
+    }
+    iterator end() noexcept
+    {
+        return data() + elementCount;
+    }
+    const_iterator end() const noexcept
+    {
+        return data() + elementCount;
+    }
+    const_iterator cend() const noexcept
+    {
+        return data() + elementCount;
+    }
+    T &operator[](std::size_t index) noexcept
+    {
+        assert(index < elementCount);
+        return data()[index];
+    }
+    const T &operator[](std::size_t index) const noexcept
+    {
+        assert(index < elementCount);
+        return data()[index];
+    }
+    T &front() noexcept
+    {
+        return operator[](0);
+    }
+    const T &front() const noexcept
+    {
+        return operator[](0);
+    }
+    T &back() noexcept
+    {
+        return operator[](elementCount - 1);
+    }
+    const T &back() const noexcept
+    {
+        return operator[](elementCount - 1);
+    }
+    /** allocates from `arena` if more storage is needed. The old storage isn't reused, since
+     * arena memory is only freed all at once. */
+    void reserve(Arena &arena, std::size_t newCapacity)
+    {
+        if(newCapacity <= allocatedCapacity)
+            return;
+        assert(newCapacity <= std::numeric_limits<std::uint32_t>::max());
+        auto *newElements =
+            static_cast<T *>(arena.allocateBytes(sizeof(T) * newCapacity, alignof(T)));
+        copyElements(newElements, data(), elementCount);
+        externalElements = newElements;
+        allocatedCapacity = static_cast<std::uint32_t>(newCapacity);
+    }
+    /** allocates from `arena` if more storage is needed */
+    template <typename... Args>
+    T &emplace_back(Arena &arena, Args &&... args)
+    {
+        if(elementCount >= allocatedCapacity)
+            reserve(arena, static_cast<std::size_t>(allocatedCapacity) * 2);
+        T *retval =
+            ::new(static_cast<void *>(data() + elementCount)) T(std::forward<Args>(args)...);
+        elementCount++;
+        return *retval;
+    }
+    /** allocates from `arena` if more storage is needed */
+    void push_back(Arena &arena, const T &value)
+    {
+        emplace_back(arena, value);
+    }
+    void pop_back() noexcept
+    {
+        assert(elementCount > 0);
+        elementCount--;
+    }
+    void clear() noexcept
+    {
+        elementCount = 0;
+    }
+};
+}
+}
+
+#endif /* UTIL_ARENA_VECTOR_H_ */
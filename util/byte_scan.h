@@ -0,0 +1,201 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef UTIL_BYTE_SCAN_H_
+#define UTIL_BYTE_SCAN_H_
+
+#include <cstddef>
+#include <cstring>
+#include <cstdint>
+#include "compiler_intrinsics.h"
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace quick_shell
+{
+namespace util
+{
+template <unsigned char... bytes>
+struct ByteSet;
+
+template <>
+struct ByteSet<> final
+{
+    static constexpr bool contains(unsigned char) noexcept
+    {
+        return false;
+    }
+#if defined(__AVX2__)
+    static __m256i match(__m256i) noexcept
+    {
+        return _mm256_setzero_si256();
+    }
+#endif
+#if defined(__SSE2__)
+    static __m128i match(__m128i) noexcept
+    {
+        return _mm_setzero_si128();
+    }
+#endif
+};
+
+template <unsigned char first, unsigned char... rest>
+struct ByteSet<first, rest...> final
+{
+    static constexpr bool contains(unsigned char v) noexcept
+    {
+        return v == first || ByteSet<rest...>::contains(v);
+    }
+#if defined(__AVX2__)
+    /** returns a vector with 0xFF in every byte that is in this set and 0 elsewhere */
+    static __m256i match(__m256i v) noexcept
+    {
+        return _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(static_cast<char>(first))),
+                               ByteSet<rest...>::match(v));
+    }
+#endif
+#if defined(__SSE2__)
+    /** returns a vector with 0xFF in every byte that is in this set and 0 elsewhere */
+    static __m128i match(__m128i v) noexcept
+    {
+        return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(static_cast<char>(first))),
+                            ByteSet<rest...>::match(v));
+    }
+#endif
+};
+
+/** calls `fn(position)` for every byte in `[begin, end)` that is one of `bytes`, in order.
+ *
+ * Uses SSE2 or AVX2 when the compiler targets them, otherwise a plain loop.
+ * */
+template <unsigned char... bytes, typename Fn>
+void forEachByteOf(const unsigned char *begin, const unsigned char *end, Fn &&fn)
+{
+    typedef ByteSet<bytes...> Set;
+    if(sizeof...(bytes) == 0)
+        return;
+    const unsigned char *current = begin;
+#if defined(__AVX2__)
+    for(; end - current >= 32; current += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(current));
+        std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(Set::match(v)));
+        while(mask)
+        {
+            fn(current + countTrailingZeros(mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    for(; end - current >= 16; current += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(current));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(Set::match(v)));
+        while(mask)
+        {
+            fn(current + countTrailingZeros(mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for(; current != end; ++current)
+        if(Set::contains(*current))
+            fn(current);
+}
+
+/** returns a mask with bit `i` set if `begin[i]` is one of `bytes`, for each `i < count`.
+ *
+ * `count` must be at most 64. Uses SSE2 or AVX2 when the compiler targets them, otherwise a plain
+ * loop.
+ * */
+template <unsigned char... bytes>
+std::uint64_t getByteMask(const unsigned char *begin, std::size_t count) noexcept
+{
+    typedef ByteSet<bytes...> Set;
+    std::uint64_t retval = 0;
+    std::size_t index = 0;
+#if defined(__AVX2__)
+    for(; count - index >= 32; index += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin + index));
+        retval |= static_cast<std::uint64_t>(
+                      static_cast<std::uint32_t>(_mm256_movemask_epi8(Set::match(v))))
+                  << index;
+    }
+#endif
+#if defined(__SSE2__)
+    for(; count - index >= 16; index += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin + index));
+        retval |=
+            static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(Set::match(v))))
+            << index;
+    }
+#endif
+    for(; index < count; index++)
+        if(Set::contains(begin[index]))
+            retval |= static_cast<std::uint64_t>(1) << index;
+    return retval;
+}
+
+/** returns the first byte in `[begin, end)` that is one of `bytes`, or `end` if there are none.
+ *
+ * Uses SSE2 or AVX2 when the compiler targets them, otherwise a plain loop.
+ * */
+template <unsigned char... bytes>
+const unsigned char *findFirstByteOf(const unsigned char *begin, const unsigned char *end) noexcept
+{
+    typedef ByteSet<bytes...> Set;
+    if(sizeof...(bytes) == 0 || begin == end)
+        return end;
+    if(sizeof...(bytes) == 1)
+    {
+        // the C library's memchr is already vectorized
+        constexpr unsigned char byteArray[] = {bytes..., 0};
+        auto *retval = std::memchr(begin, byteArray[0], end - begin);
+        return retval ? static_cast<const unsigned char *>(retval) : end;
+    }
+    const unsigned char *current = begin;
+#if defined(__AVX2__)
+    for(; end - current >= 32; current += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(current));
+        std::uint32_t mask = static_cast<std::uint32_t>(_mm256_movemask_epi8(Set::match(v)));
+        if(mask)
+            return current + countTrailingZeros(mask);
+    }
+#endif
+#if defined(__SSE2__)
+    for(; end - current >= 16; current += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(current));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(Set::match(v)));
+        if(mask)
+            return current + countTrailingZeros(mask);
+    }
+#endif
+    for(; current != end; ++current)
+        if(Set::contains(*current))
+            return current;
+    return end;
+}
+}
+}
+
+#endif /* UTIL_BYTE_SCAN_H_ */
@@ -17,6 +17,10 @@
 #define UTIL_COMPILER_INTRINSICS_H_
 
 #include <cassert>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 #if defined(__clang__) || (__GNUC__ > 4) || (__GNUC__ == 4 && __GNUC_MINOR__ >= 5)
 #define BUILTIN_UNREACHABLE() __builtin_unreachable()
 #else
@@ -48,4 +52,40 @@
 #define UNIMPLEMENTED(x) UNIMPLEMENTED_HELPER(unimplemented : x)
 #endif
 
+namespace quick_shell
+{
+namespace util
+{
+/** the index of the lowest set bit in `v`, which must not be zero */
+inline unsigned countTrailingZeros(std::uint32_t v) noexcept
+{
+    assert(v != 0);
+#ifdef _MSC_VER
+    unsigned long retval;
+    _BitScanForward(&retval, v);
+    return retval;
+#else
+    return __builtin_ctz(v);
+#endif
+}
+
+/** the index of the lowest set bit in `v`, which must not be zero */
+inline unsigned countTrailingZeros(std::uint64_t v) noexcept
+{
+    assert(v != 0);
+#if defined(_MSC_VER) && defined(_WIN64)
+    unsigned long retval;
+    _BitScanForward64(&retval, v);
+    return retval;
+#elif defined(_MSC_VER)
+    if(static_cast<std::uint32_t>(v) != 0)
+        return countTrailingZeros(static_cast<std::uint32_t>(v));
+    return 32 + countTrailingZeros(static_cast<std::uint32_t>(v >> 32));
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+}
+}
+
 #endif /* UTIL_COMPILER_INTRINSICS_H_ */
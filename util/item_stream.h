@@ -18,6 +18,9 @@
 
 #include <type_traits>
 #include <utility>
+#include <iterator>
+#include <cstddef>
+#include <cassert>
 
 namespace quick_shell
 {
@@ -63,6 +66,11 @@ struct ItemStreamTraits final
     }
 };
 
+/** input iterator over the items of an item stream.
+ *
+ * The default-constructed iterator is the end iterator. Like `std::istreambuf_iterator`, two
+ * iterators compare equal if both or neither are at the end.
+ * */
 template <typename ItemStreamType>
 class ItemStreamIterator final
 {
@@ -73,8 +81,12 @@ private:
     mutable bool isItemValid;
 
 public:
-#error finish
-#error add iterator value_type ... typedefs
+    typedef typename Traits::ItemType value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const value_type *pointer;
+    typedef const value_type &reference;
+    typedef std::input_iterator_tag iterator_category;
+
 public:
     constexpr ItemStreamIterator() noexcept : itemStream(), item(), isItemValid(false)
     {
@@ -98,7 +110,49 @@ public:
     {
         return ItemStreamIterator();
     }
-    constexpr
+    const ItemStreamType &getItemStream() const noexcept
+    {
+        return itemStream;
+    }
+    bool isAtEnd() const noexcept(noexcept(Traits::isAtEnd(std::declval<const ItemStreamType &>())))
+    {
+        return Traits::isAtEnd(itemStream);
+    }
+    reference operator*() const
+    {
+        assert(!isAtEnd());
+        if(!isItemValid)
+        {
+            item = Traits::peek(itemStream);
+            isItemValid = true;
+        }
+        return item;
+    }
+    pointer operator->() const
+    {
+        return &operator*();
+    }
+    ItemStreamIterator &operator++()
+    {
+        assert(!isAtEnd());
+        Traits::get(itemStream);
+        isItemValid = false;
+        return *this;
+    }
+    ItemStreamIterator operator++(int)
+    {
+        auto retval = *this;
+        operator++();
+        return retval;
+    }
+    bool operator==(const ItemStreamIterator &rt) const
+    {
+        return isAtEnd() == rt.isAtEnd();
+    }
+    bool operator!=(const ItemStreamIterator &rt) const
+    {
+        return !operator==(rt);
+    }
 };
 }
 }
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "symbol_table.h"
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace quick_shell
+{
+namespace util
+{
+void SymbolTable::grow()
+{
+    std::vector<std::uint32_t> newSlots(slots.size() * 2, 0);
+    std::size_t mask = newSlots.size() - 1;
+    for(std::uint32_t symbol = 1; symbol < entries.size(); symbol++)
+    {
+        std::size_t index = entries[symbol].hash & mask;
+        while(newSlots[index] != 0)
+            index = (index + 1) & mask;
+        newSlots[index] = symbol;
+    }
+    slots = std::move(newSlots);
+}
+
+SymbolId SymbolTable::intern(util::string_view text)
+{
+    auto hash = hashText(text);
+    auto slot = findSlot(hash, text);
+    if(slots[slot] != 0)
+        return SymbolId(slots[slot]);
+    if(entries.size() > std::numeric_limits<std::uint32_t>::max()
+       || text.size() > std::numeric_limits<std::uint32_t>::max())
+        throw std::length_error("too many symbols");
+    char *storedText = nullptr;
+    if(!text.empty())
+    {
+        storedText = static_cast<char *>(arena.allocateBytes(text.size(), 1));
+        std::memcpy(storedText, text.data(), text.size());
+    }
+    auto symbol = static_cast<std::uint32_t>(entries.size());
+    entries.push_back(Entry{storedText, static_cast<std::uint32_t>(text.size()), hash});
+    slots[slot] = symbol;
+    // keep the load factor at most 1/2
+    if(entries.size() * 2 > slots.size())
+        grow();
+    return SymbolId(symbol);
+}
+}
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2017 Jacob Lifshay
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef UTIL_SYMBOL_TABLE_H_
+#define UTIL_SYMBOL_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <vector>
+#include <functional>
+#include "arena.h"
+#include "string_view.h"
+
+namespace quick_shell
+{
+namespace util
+{
+/** identifies a string interned in a `SymbolTable`; equal strings from the same table get equal
+ * ids. The default-constructed id is not a valid symbol. */
+struct SymbolId final
+{
+    std::uint32_t value;
+    constexpr SymbolId() noexcept : value(0)
+    {
+    }
+    constexpr explicit SymbolId(std::uint32_t value) noexcept : value(value)
+    {
+    }
+    constexpr bool isValid() const noexcept
+    {
+        return value != 0;
+    }
+    constexpr explicit operator bool() const noexcept
+    {
+        return value != 0;
+    }
+    constexpr bool operator==(const SymbolId &rt) const noexcept
+    {
+        return value == rt.value;
+    }
+    constexpr bool operator!=(const SymbolId &rt) const noexcept
+    {
+        return value != rt.value;
+    }
+    constexpr bool operator<(const SymbolId &rt) const noexcept
+    {
+        return value < rt.value;
+    }
+};
+
+/** interns strings, giving each distinct string a small integer id.
+ *
+ * The text of interned strings is copied into an arena owned by the table, so the views returned
+ * by `getText` stay valid as long as the table does. Ids are assigned in order starting from 1.
+ * */
+class SymbolTable final
+{
+    SymbolTable(const SymbolTable &) = delete;
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+private:
+    struct Entry final
+    {
+        const char *text;
+        std::uint32_t size;
+        std::uint32_t hash;
+    };
+
+private:
+    Arena arena;
+    /** indexed by `SymbolId::value`; entry 0 is unused */
+    std::vector<Entry> entries;
+    /** open addressing hash table of `SymbolId::value`s, 0 for empty slots. The size is always a
+     * power of 2. */
+    std::vector<std::uint32_t> slots;
+
+private:
+    static std::uint32_t hashText(util::string_view text) noexcept
+    {
+        // FNV-1a
+        std::uint32_t retval = 0x811C9DC5UL;
+        for(unsigned char ch : text)
+        {
+            retval ^= ch;
+            retval *= 0x1000193UL;
+        }
+        return retval;
+    }
+    bool entryEquals(const Entry &entry, std::uint32_t hash, util::string_view text) const noexcept
+    {
+        return entry.hash == hash && util::string_view(entry.text, entry.size) == text;
+    }
+    std::size_t findSlot(std::uint32_t hash, util::string_view text) const noexcept
+    {
+        std::size_t mask = slots.size() - 1;
+        for(std::size_t index = hash & mask;; index = (index + 1) & mask)
+        {
+            if(slots[index] == 0 || entryEquals(entries[slots[index]], hash, text))
+                return index;
+        }
+    }
+    void grow();
+
+public:
+    SymbolTable() : arena(), entries(1, Entry{nullptr, 0, 0}), slots(64, 0)
+    {
+    }
+    /** returns the id of `text`, adding it if it isn't already in the table */
+    SymbolId intern(util::string_view text);
+    /** returns the id of `text`, or an invalid id if it isn't in the table */
+    SymbolId find(util::string_view text) const noexcept
+    {
+        auto slot = slots[findSlot(hashText(text), text)];
+        return SymbolId(slot);
+    }
+    util::string_view getText(SymbolId symbol) const noexcept
+    {
+        assert(symbol.value < entries.size());
+        auto &entry = entries[symbol.value];
+        return util::string_view(entry.text, entry.size);
+    }
+    /** the number of interned strings */
+    std::size_t size() const noexcept
+    {
+        return entries.size() - 1;
+    }
+};
+}
+}
+
+namespace std
+{
+template <>
+struct hash<quick_shell::util::SymbolId>
+{
+    std::size_t operator()(const quick_shell::util::SymbolId &v) const noexcept
+    {
+        return std::hash<std::uint32_t>()(v.value);
+    }
+};
+}
+
+#endif /* UTIL_SYMBOL_TABLE_H_ */
@@ -17,6 +17,7 @@
 #define UTIL_TYPE_TRAITS_H_
 
 #include <type_traits>
+#include <cstddef>
 
 namespace quick_shell
 {
@@ -33,6 +34,41 @@ struct IsFunctionPointer<R (*)(Args...)>
 {
     static constexpr bool value = true;
 };
+
+/** C++11 version of `std::index_sequence` */
+template <std::size_t... indexes>
+struct IndexSequence
+{
+    typedef IndexSequence type;
+};
+
+template <typename A, typename B>
+struct ConcatIndexSequence;
+
+template <std::size_t... a, std::size_t... b>
+struct ConcatIndexSequence<IndexSequence<a...>, IndexSequence<b...>>
+    : public IndexSequence<a..., (sizeof...(a) + b)...>
+{
+};
+
+/** C++11 version of `std::make_index_sequence`; splits in half so the instantiation depth is
+ * logarithmic */
+template <std::size_t N>
+struct MakeIndexSequence
+    : public ConcatIndexSequence<typename MakeIndexSequence<N / 2>::type,
+                                 typename MakeIndexSequence<N - N / 2>::type>::type
+{
+};
+
+template <>
+struct MakeIndexSequence<0> : public IndexSequence<>
+{
+};
+
+template <>
+struct MakeIndexSequence<1> : public IndexSequence<0>
+{
+};
 }
 }
 